@@ -69,3 +69,26 @@ macro(createTraceLevelOptions)
   
   add_definitions(-DOPENER_TRACE_LEVEL=${TRACE_LEVEL})
 endmacro(createTraceLevelOptions)
+
+#####################################################
+# Generates the static object dictionary of a class #
+#####################################################
+# Adds a build step turning the description <name>.cipdict.cmake into the
+# header <name>_dictionary.h in the current binary directory and stores the
+# path of the header in HEADER_VARIABLE; the header has to be added to the
+# sources of the library including it. See
+# OpENer_CIP_Dictionary_generator.cmake for the description commands.
+function(opener_cip_dictionary DESCRIPTION HEADER_VARIABLE)
+  get_filename_component( description_path ${DESCRIPTION} ABSOLUTE )
+  get_filename_component( description_name ${DESCRIPTION} NAME )
+  string( REGEX REPLACE "\\.cipdict\\.cmake$" "_dictionary.h" header_name ${description_name} )
+  set( header_path ${CMAKE_CURRENT_BINARY_DIR}/${header_name} )
+  set( generator ${OpENer_BUILDSUPPORT_DIR}/OpENer_CIP_Dictionary_generator.cmake )
+
+  add_custom_command( OUTPUT ${header_path}
+                      COMMAND ${CMAKE_COMMAND} -DDESCRIPTION=${description_path} -DHEADER=${header_path} -P ${generator}
+                      DEPENDS ${description_path} ${generator}
+                      COMMENT "Generating the CIP object dictionary ${header_name}" )
+  include_directories( ${CMAKE_CURRENT_BINARY_DIR} )
+  set( ${HEADER_VARIABLE} ${header_path} PARENT_SCOPE )
+endfunction(opener_cip_dictionary)
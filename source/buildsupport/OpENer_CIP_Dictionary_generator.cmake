@@ -0,0 +1,387 @@
+#######################################################################
+# Generates the static object dictionary of a CIP class               #
+#######################################################################
+# Turns a declarative description of a CIP class into a header with the
+# const tables of the class, its meta class, the instances, the attributes
+# and the service dispatch; run by the build, see opener_cip_dictionary:
+#
+#   cmake -DDESCRIPTION=<name>.cipdict.cmake -DHEADER=<name>_dictionary.h
+#         -P OpENer_CIP_Dictionary_generator.cmake
+#
+# The description is a CMake file made of these commands:
+#
+#   cip_dictionary_class( <name> CLASS_ID <id> REVISION <revision>
+#                         [CLASS_GET_ALL <attribute numbers>]
+#                         [INSTANCE_GET_ALL <attribute numbers>] )
+#   cip_dictionary_class_attribute( <number> <type> <data> <flags> )
+#   cip_dictionary_service( CLASS|INSTANCE <code> <function> [<name>] )
+#   cip_dictionary_instance( <number> )
+#   cip_dictionary_attribute( <number> <type> <data> <flags> )
+#
+# The class attributes 1 to 7 and the services GetAttributeAll (if the get
+# all mask is not empty), GetAttributeSingle, GetAttributeList and
+# SetAttributeList are added as CreateCipClass does. cip_dictionary_attribute
+# adds an attribute to the instance declared last, the instances have to be
+# declared with ascending instance numbers. <id>, <code>, <type>, <data> and
+# <flags> are C constant expressions; the data and the service functions have
+# to be declared before the generated header is included.
+#
+# The header defines g_<name>_dictionary_class, to be registered with
+# RegisterStaticCipClass.
+
+include( CMakeParseArguments )
+
+if( NOT DESCRIPTION OR NOT HEADER )
+  message( FATAL_ERROR "usage: cmake -DDESCRIPTION=<description> -DHEADER=<header> -P OpENer_CIP_Dictionary_generator.cmake" )
+endif( NOT DESCRIPTION OR NOT HEADER )
+
+set( CIP_DICTIONARY_NAME "" )
+set( CIP_DICTIONARY_CLASS_SERVICE_CODES kGetAttributeSingle kGetAttributeList kSetAttributeList )
+set( CIP_DICTIONARY_CLASS_SERVICE_FUNCTIONS GetAttributeSingle GetAttributeList SetAttributeList )
+set( CIP_DICTIONARY_CLASS_SERVICE_NAMES GetAttributeSingle GetAttributeList SetAttributeList )
+set( CIP_DICTIONARY_INSTANCE_SERVICE_CODES ${CIP_DICTIONARY_CLASS_SERVICE_CODES} )
+set( CIP_DICTIONARY_INSTANCE_SERVICE_FUNCTIONS ${CIP_DICTIONARY_CLASS_SERVICE_FUNCTIONS} )
+set( CIP_DICTIONARY_INSTANCE_SERVICE_NAMES ${CIP_DICTIONARY_CLASS_SERVICE_NAMES} )
+set( CIP_DICTIONARY_CLASS_ATTRIBUTE_NUMBERS "" )
+set( CIP_DICTIONARY_CLASS_ATTRIBUTE_TYPES "" )
+set( CIP_DICTIONARY_CLASS_ATTRIBUTE_DATA "" )
+set( CIP_DICTIONARY_CLASS_ATTRIBUTE_FLAGS "" )
+set( CIP_DICTIONARY_INSTANCES "" )
+set( CIP_DICTIONARY_ATTRIBUTE_INSTANCES "" )
+set( CIP_DICTIONARY_ATTRIBUTE_NUMBERS "" )
+set( CIP_DICTIONARY_ATTRIBUTE_TYPES "" )
+set( CIP_DICTIONARY_ATTRIBUTE_DATA "" )
+set( CIP_DICTIONARY_ATTRIBUTE_FLAGS "" )
+
+function( cip_dictionary_error MESSAGE )
+  message( FATAL_ERROR "${DESCRIPTION}: ${MESSAGE}" )
+endfunction( cip_dictionary_error )
+
+# Computes the get all mask of the given attribute numbers
+function( cip_dictionary_mask RESULT )
+  set( mask 0 )
+  foreach( number ${ARGN} )
+    if( number GREATER 31 )
+      cip_dictionary_error( "attribute ${number} does not fit into a get all mask" )
+    endif( number GREATER 31 )
+    math( EXPR mask "${mask} | (1 << ${number})" )
+  endforeach( number )
+  set( ${RESULT} ${mask} PARENT_SCOPE )
+endfunction( cip_dictionary_mask )
+
+function( cip_dictionary_class NAME )
+  cmake_parse_arguments( CLASS "" "CLASS_ID;REVISION" "CLASS_GET_ALL;INSTANCE_GET_ALL" ${ARGN} )
+  if( NOT "${CIP_DICTIONARY_NAME}" STREQUAL "" )
+    cip_dictionary_error( "only one class per description" )
+  endif( NOT "${CIP_DICTIONARY_NAME}" STREQUAL "" )
+  if( NOT NAME MATCHES "^[A-Za-z_][A-Za-z0-9_]*$" )
+    cip_dictionary_error( "class name ${NAME} is no C identifier" )
+  endif( NOT NAME MATCHES "^[A-Za-z_][A-Za-z0-9_]*$" )
+  if( "${CLASS_CLASS_ID}" STREQUAL "" OR "${CLASS_REVISION}" STREQUAL "" )
+    cip_dictionary_error( "cip_dictionary_class needs CLASS_ID and REVISION" )
+  endif( "${CLASS_CLASS_ID}" STREQUAL "" OR "${CLASS_REVISION}" STREQUAL "" )
+
+  cip_dictionary_mask( CLASS_mask ${CLASS_CLASS_GET_ALL} )
+  cip_dictionary_mask( INSTANCE_mask ${CLASS_INSTANCE_GET_ALL} )
+  set( CIP_DICTIONARY_NAME ${NAME} PARENT_SCOPE )
+  set( CIP_DICTIONARY_CLASS_ID ${CLASS_CLASS_ID} PARENT_SCOPE )
+  set( CIP_DICTIONARY_REVISION ${CLASS_REVISION} PARENT_SCOPE )
+  set( CIP_DICTIONARY_CLASS_MASK ${CLASS_mask} PARENT_SCOPE )
+  set( CIP_DICTIONARY_INSTANCE_MASK ${INSTANCE_mask} PARENT_SCOPE )
+
+  # GetAttributeAll is the first service if any attribute is returned by it
+  foreach( kind CLASS INSTANCE )
+    if( NOT ${${kind}_mask} EQUAL 0 )
+      set( CIP_DICTIONARY_${kind}_SERVICE_CODES kGetAttributeAll ${CIP_DICTIONARY_${kind}_SERVICE_CODES} PARENT_SCOPE )
+      set( CIP_DICTIONARY_${kind}_SERVICE_FUNCTIONS GetAttributeAll ${CIP_DICTIONARY_${kind}_SERVICE_FUNCTIONS} PARENT_SCOPE )
+      set( CIP_DICTIONARY_${kind}_SERVICE_NAMES GetAttributeAll ${CIP_DICTIONARY_${kind}_SERVICE_NAMES} PARENT_SCOPE )
+    endif( NOT ${${kind}_mask} EQUAL 0 )
+  endforeach( kind )
+endfunction( cip_dictionary_class )
+
+function( cip_dictionary_class_attribute NUMBER TYPE DATA FLAGS )
+  if( NOT NUMBER GREATER 7 )
+    cip_dictionary_error( "the class attributes 1 to 7 are standard attributes" )
+  endif( NOT NUMBER GREATER 7 )
+  set( NUMBERS ${NUMBER} )
+  set( TYPES ${TYPE} )
+  foreach( field NUMBERS TYPES DATA FLAGS )
+    list( APPEND CIP_DICTIONARY_CLASS_ATTRIBUTE_${field} "${${field}}" )
+    set( CIP_DICTIONARY_CLASS_ATTRIBUTE_${field} ${CIP_DICTIONARY_CLASS_ATTRIBUTE_${field}} PARENT_SCOPE )
+  endforeach( field )
+endfunction( cip_dictionary_class_attribute )
+
+# A service with the code of an already defined service replaces it, as
+# InsertService does
+function( cip_dictionary_service KIND CODE FUNCTION )
+  if( NOT KIND STREQUAL "CLASS" AND NOT KIND STREQUAL "INSTANCE" )
+    cip_dictionary_error( "cip_dictionary_service needs CLASS or INSTANCE" )
+  endif( NOT KIND STREQUAL "CLASS" AND NOT KIND STREQUAL "INSTANCE" )
+  set( name ${FUNCTION} )
+  if( ARGC GREATER 3 )
+    set( name ${ARGV3} )
+  endif( ARGC GREATER 3 )
+
+  set( codes ${CIP_DICTIONARY_${KIND}_SERVICE_CODES} )
+  set( functions ${CIP_DICTIONARY_${KIND}_SERVICE_FUNCTIONS} )
+  set( names ${CIP_DICTIONARY_${KIND}_SERVICE_NAMES} )
+  list( FIND codes ${CODE} position )
+  if( position EQUAL -1 )
+    list( APPEND codes ${CODE} )
+    list( APPEND functions ${FUNCTION} )
+    list( APPEND names ${name} )
+  else( position EQUAL -1 )
+    list( REMOVE_AT functions ${position} )
+    list( INSERT functions ${position} ${FUNCTION} )
+    list( REMOVE_AT names ${position} )
+    list( INSERT names ${position} ${name} )
+  endif( position EQUAL -1 )
+  set( CIP_DICTIONARY_${KIND}_SERVICE_CODES ${codes} PARENT_SCOPE )
+  set( CIP_DICTIONARY_${KIND}_SERVICE_FUNCTIONS ${functions} PARENT_SCOPE )
+  set( CIP_DICTIONARY_${KIND}_SERVICE_NAMES ${names} PARENT_SCOPE )
+endfunction( cip_dictionary_service )
+
+function( cip_dictionary_instance NUMBER )
+  if( NOT NUMBER GREATER 0 )
+    cip_dictionary_error( "instance numbers start at 1" )
+  endif( NOT NUMBER GREATER 0 )
+  list( LENGTH CIP_DICTIONARY_INSTANCES count )
+  if( count GREATER 0 )
+    math( EXPR last "${count} - 1" )
+    list( GET CIP_DICTIONARY_INSTANCES ${last} previous )
+    if( NOT NUMBER GREATER previous )
+      cip_dictionary_error( "instance ${NUMBER} is not declared in ascending order" )
+    endif( NOT NUMBER GREATER previous )
+  endif( count GREATER 0 )
+  list( APPEND CIP_DICTIONARY_INSTANCES ${NUMBER} )
+  set( CIP_DICTIONARY_INSTANCES ${CIP_DICTIONARY_INSTANCES} PARENT_SCOPE )
+endfunction( cip_dictionary_instance )
+
+function( cip_dictionary_attribute NUMBER TYPE DATA FLAGS )
+  list( LENGTH CIP_DICTIONARY_INSTANCES count )
+  if( count EQUAL 0 )
+    cip_dictionary_error( "attribute ${NUMBER} is declared before any instance" )
+  endif( count EQUAL 0 )
+  math( EXPR INSTANCES "${count} - 1" )
+  set( NUMBERS ${NUMBER} )
+  set( TYPES ${TYPE} )
+  foreach( field INSTANCES NUMBERS TYPES DATA FLAGS )
+    list( APPEND CIP_DICTIONARY_ATTRIBUTE_${field} "${${field}}" )
+    set( CIP_DICTIONARY_ATTRIBUTE_${field} ${CIP_DICTIONARY_ATTRIBUTE_${field}} PARENT_SCOPE )
+  endforeach( field )
+endfunction( cip_dictionary_attribute )
+
+include( ${DESCRIPTION} )
+
+if( "${CIP_DICTIONARY_NAME}" STREQUAL "" )
+  cip_dictionary_error( "no cip_dictionary_class" )
+endif( "${CIP_DICTIONARY_NAME}" STREQUAL "" )
+
+set( prefix g_${CIP_DICTIONARY_NAME}_dictionary )
+set( class ${prefix}_class )
+set( meta_class ${prefix}_meta_class )
+
+# Emits the array of services of the class (KIND INSTANCE) or the meta class
+# (KIND CLASS) and sets <KIND>_SERVICE_SLOTS to the initializer of the service
+# dispatch table
+function( cip_dictionary_emit_services KIND ARRAY )
+  set( codes ${CIP_DICTIONARY_${KIND}_SERVICE_CODES} )
+  set( functions ${CIP_DICTIONARY_${KIND}_SERVICE_FUNCTIONS} )
+  set( names ${CIP_DICTIONARY_${KIND}_SERVICE_NAMES} )
+  list( LENGTH codes count )
+  math( EXPR last "${count} - 1" )
+  set( code_text "${CODE_TEXT}static const CipServiceStruct ${ARRAY}[${count}] = {\n" )
+  set( slots "" )
+  foreach( i RANGE ${last} )
+    list( GET codes ${i} code )
+    list( GET functions ${i} function )
+    list( GET names ${i} name )
+    math( EXPR slot "${i} + 1" )
+    set( code_text "${code_text}  { ${code}, &${function}, \"${name}\" },\n" )
+    set( slots "${slots} [${code}] = ${slot}," )
+  endforeach( i )
+  set( CODE_TEXT "${code_text}};\n\n" PARENT_SCOPE )
+  set( ${KIND}_SERVICE_COUNT ${count} PARENT_SCOPE )
+  set( ${KIND}_SERVICE_SLOTS "{${slots} }" PARENT_SCOPE )
+endfunction( cip_dictionary_emit_services )
+
+# Emits the table mapping the attribute numbers to the position + 1 of the
+# attribute in the attributes of the instances, the first position of an
+# attribute number wins as in RecordAttributeSlot. The attribute numbers of
+# all instances follow each other, STRIDE numbers per instance.
+function( cip_dictionary_emit_attribute_slots ARRAY HIGHEST STRIDE )
+  set( initializers "" )
+  set( i 0 )
+  foreach( number ${ARGN} )
+    math( EXPR position "${i} % ${STRIDE} + 1" )
+    math( EXPR i "${i} + 1" )
+    if( NOT DEFINED slot_${number} )
+      set( slot_${number} ${position} )
+      set( initializers "${initializers} [${number}] = ${position}," )
+    endif( NOT DEFINED slot_${number} )
+  endforeach( number )
+  math( EXPR count "${HIGHEST} + 1" )
+  set( CODE_TEXT "${CODE_TEXT}static const EipUint16 ${ARRAY}[${count}] = {${initializers} };\n\n" PARENT_SCOPE )
+endfunction( cip_dictionary_emit_attribute_slots )
+
+function( cip_dictionary_highest RESULT )
+  set( highest 0 )
+  foreach( number ${ARGN} )
+    if( number GREATER highest )
+      set( highest ${number} )
+    endif( number GREATER highest )
+  endforeach( number )
+  set( ${RESULT} ${highest} PARENT_SCOPE )
+endfunction( cip_dictionary_highest )
+
+get_filename_component( description_name ${DESCRIPTION} NAME )
+get_filename_component( header_name ${HEADER} NAME_WE )
+string( TOUPPER "OPENER_${header_name}_H_" guard )
+
+set( CODE_TEXT "/* Generated from ${description_name} by OpENer_CIP_Dictionary_generator.cmake, do not edit */\n" )
+set( CODE_TEXT "${CODE_TEXT}#ifndef ${guard}\n#define ${guard}\n\n" )
+set( CODE_TEXT "${CODE_TEXT}#include \"ciptypes.h\"\n#include \"cipcommon.h\"\n\n" )
+set( CODE_TEXT "${CODE_TEXT}static const CipClass ${class};\nstatic const CipClass ${meta_class};\n\n" )
+
+# class attributes, held by the meta class
+set( class_attribute_numbers 1 2 3 4 5 6 7 ${CIP_DICTIONARY_CLASS_ATTRIBUTE_NUMBERS} )
+list( LENGTH class_attribute_numbers class_attribute_count )
+cip_dictionary_highest( class_highest_attribute ${class_attribute_numbers} )
+set( CODE_TEXT "${CODE_TEXT}static const CipAttributeStruct ${prefix}_class_attributes[${class_attribute_count}] = {\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 1, kCipUint, kGetableSingleAndAll, (void *) &${class}.revision },\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 2, kCipUint, kGetableSingleAndAll, (void *) &${class}.number_of_instances },\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 3, kCipUint, kGetableSingleAndAll, (void *) &${class}.number_of_instances },\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 4, kCipUint, kGetableAll, (void *) &kCipUintZero },\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 5, kCipUint, kGetableAll, (void *) &kCipUintZero },\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 6, kCipUint, kGetableSingleAndAll, (void *) &${meta_class}.highest_attribute_number },\n" )
+set( CODE_TEXT "${CODE_TEXT}  { 7, kCipUint, kGetableSingleAndAll, (void *) &${class}.highest_attribute_number },\n" )
+set( i 0 )
+foreach( number ${CIP_DICTIONARY_CLASS_ATTRIBUTE_NUMBERS} )
+  list( GET CIP_DICTIONARY_CLASS_ATTRIBUTE_TYPES ${i} type )
+  list( GET CIP_DICTIONARY_CLASS_ATTRIBUTE_DATA ${i} data )
+  list( GET CIP_DICTIONARY_CLASS_ATTRIBUTE_FLAGS ${i} flags )
+  set( CODE_TEXT "${CODE_TEXT}  { ${number}, ${type}, ${flags}, (void *) ${data} },\n" )
+  math( EXPR i "${i} + 1" )
+endforeach( number )
+set( CODE_TEXT "${CODE_TEXT}};\n\n" )
+cip_dictionary_emit_attribute_slots( ${prefix}_class_attribute_slots ${class_highest_attribute} ${class_attribute_count} ${class_attribute_numbers} )
+cip_dictionary_emit_services( CLASS ${prefix}_class_services )
+
+# instance attributes, every instance has room for the attributes of the
+# instance declaring the most
+list( LENGTH CIP_DICTIONARY_INSTANCES instance_count )
+set( attribute_count 0 )
+cip_dictionary_highest( highest_attribute ${CIP_DICTIONARY_ATTRIBUTE_NUMBERS} )
+set( instance_attribute_numbers "" )
+if( instance_count GREATER 0 )
+  math( EXPR last_instance "${instance_count} - 1" )
+  foreach( instance RANGE ${last_instance} )
+    list( GET CIP_DICTIONARY_INSTANCES ${instance} instance_number )
+    set( attributes_${instance} "" )
+    set( numbers_${instance} "" )
+    set( i 0 )
+    foreach( attribute_instance ${CIP_DICTIONARY_ATTRIBUTE_INSTANCES} )
+      if( attribute_instance EQUAL instance )
+        list( GET CIP_DICTIONARY_ATTRIBUTE_NUMBERS ${i} number )
+        list( GET CIP_DICTIONARY_ATTRIBUTE_TYPES ${i} type )
+        list( GET CIP_DICTIONARY_ATTRIBUTE_DATA ${i} data )
+        list( GET CIP_DICTIONARY_ATTRIBUTE_FLAGS ${i} flags )
+        set( attributes_${instance} "${attributes_${instance}}  { ${number}, ${type}, ${flags}, (void *) ${data} },\n" )
+        list( APPEND numbers_${instance} ${number} )
+      endif( attribute_instance EQUAL instance )
+      math( EXPR i "${i} + 1" )
+    endforeach( attribute_instance )
+    list( LENGTH numbers_${instance} count )
+    if( count GREATER attribute_count )
+      set( attribute_count ${count} )
+    endif( count GREATER attribute_count )
+  endforeach( instance )
+
+  foreach( instance RANGE ${last_instance} )
+    list( GET CIP_DICTIONARY_INSTANCES ${instance} instance_number )
+    if( attribute_count GREATER 0 )
+      set( CODE_TEXT "${CODE_TEXT}static const CipAttributeStruct ${prefix}_instance_${instance_number}_attributes[${attribute_count}] = {\n${attributes_${instance}}};\n\n" )
+      # the positions of an instance, padded to the attributes of the class
+      set( padding "" )
+      list( LENGTH numbers_${instance} count )
+      while( count LESS attribute_count )
+        list( APPEND padding 0 )
+        math( EXPR count "${count} + 1" )
+      endwhile( count LESS attribute_count )
+      list( APPEND instance_attribute_numbers ${numbers_${instance}} ${padding} )
+    endif( attribute_count GREATER 0 )
+  endforeach( instance )
+
+  set( CODE_TEXT "${CODE_TEXT}static const CipInstance ${prefix}_instances[${instance_count}] = {\n" )
+  set( index "" )
+  foreach( instance RANGE ${last_instance} )
+    list( GET CIP_DICTIONARY_INSTANCES ${instance} instance_number )
+    set( attributes NULL )
+    if( attribute_count GREATER 0 )
+      set( attributes "(CipAttributeStruct *) ${prefix}_instance_${instance_number}_attributes" )
+    endif( attribute_count GREATER 0 )
+    set( next NULL )
+    if( instance LESS last_instance )
+      math( EXPR next_instance "${instance} + 1" )
+      set( next "(CipInstance *) &${prefix}_instances[${next_instance}]" )
+    endif( instance LESS last_instance )
+    set( CODE_TEXT "${CODE_TEXT}  { ${instance_number}, ${attributes}, (CipClass *) &${class}, ${next} },\n" )
+    set( index "${index}  (CipInstance *) &${prefix}_instances[${instance}],\n" )
+  endforeach( instance )
+  set( CODE_TEXT "${CODE_TEXT}};\n\n" )
+  set( CODE_TEXT "${CODE_TEXT}static CipInstance *const ${prefix}_instance_index[${instance_count}] = {\n${index}};\n\n" )
+endif( instance_count GREATER 0 )
+
+if( attribute_count GREATER 0 )
+  # positions without attribute are skipped by their number 0
+  set( slot_0 0 )
+  cip_dictionary_emit_attribute_slots( ${prefix}_attribute_slots ${highest_attribute} ${attribute_count} ${instance_attribute_numbers} )
+endif( attribute_count GREATER 0 )
+cip_dictionary_emit_services( INSTANCE ${prefix}_services )
+
+set( CODE_TEXT "${CODE_TEXT}static const CipClass ${meta_class} = {\n" )
+set( CODE_TEXT "${CODE_TEXT}  .m_stSuper = { 0xFFFFFFFF, NULL, NULL, NULL },\n" )
+set( CODE_TEXT "${CODE_TEXT}  .class_id = 0xFFFFFFFF,\n" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_instances = 1,\n" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_attributes = ${class_attribute_count},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .highest_attribute_number = ${class_highest_attribute},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .get_attribute_all_mask = ${CIP_DICTIONARY_CLASS_MASK}U,\n" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_services = ${CLASS_SERVICE_COUNT},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .instances = (CipInstance *) &${class},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .attribute_slots = (EipUint16 *) ${prefix}_class_attribute_slots,\n" )
+math( EXPR slot_count "${class_highest_attribute} + 1" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_attribute_slots = ${slot_count},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .services = (CipServiceStruct *) ${prefix}_class_services,\n" )
+set( CODE_TEXT "${CODE_TEXT}  .service_slots = ${CLASS_SERVICE_SLOTS},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .class_name = \"meta-${CIP_DICTIONARY_NAME}\",\n" )
+set( CODE_TEXT "${CODE_TEXT}  .is_static = true\n};\n\n" )
+
+set( CODE_TEXT "${CODE_TEXT}static const CipClass ${class} = {\n" )
+set( CODE_TEXT "${CODE_TEXT}  .m_stSuper = { 0, (CipAttributeStruct *) ${prefix}_class_attributes,\n" )
+set( CODE_TEXT "${CODE_TEXT}                 (CipClass *) &${meta_class}, NULL },\n" )
+set( CODE_TEXT "${CODE_TEXT}  .class_id = ${CIP_DICTIONARY_CLASS_ID},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .revision = ${CIP_DICTIONARY_REVISION},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_instances = ${instance_count},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_attributes = ${attribute_count},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .highest_attribute_number = ${highest_attribute},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .get_attribute_all_mask = ${CIP_DICTIONARY_INSTANCE_MASK}U,\n" )
+set( CODE_TEXT "${CODE_TEXT}  .number_of_services = ${INSTANCE_SERVICE_COUNT},\n" )
+if( instance_count GREATER 0 )
+  set( CODE_TEXT "${CODE_TEXT}  .instances = (CipInstance *) &${prefix}_instances[0],\n" )
+  set( CODE_TEXT "${CODE_TEXT}  .last_instance = (CipInstance *) &${prefix}_instances[${last_instance}],\n" )
+  set( CODE_TEXT "${CODE_TEXT}  .instance_index = (CipInstance **) ${prefix}_instance_index,\n" )
+  set( CODE_TEXT "${CODE_TEXT}  .instance_index_length = ${instance_count},\n" )
+  set( CODE_TEXT "${CODE_TEXT}  .instance_index_capacity = ${instance_count},\n" )
+endif( instance_count GREATER 0 )
+if( attribute_count GREATER 0 )
+  math( EXPR slot_count "${highest_attribute} + 1" )
+  set( CODE_TEXT "${CODE_TEXT}  .attribute_slots = (EipUint16 *) ${prefix}_attribute_slots,\n" )
+  set( CODE_TEXT "${CODE_TEXT}  .number_of_attribute_slots = ${slot_count},\n" )
+endif( attribute_count GREATER 0 )
+set( CODE_TEXT "${CODE_TEXT}  .services = (CipServiceStruct *) ${prefix}_services,\n" )
+set( CODE_TEXT "${CODE_TEXT}  .service_slots = ${INSTANCE_SERVICE_SLOTS},\n" )
+set( CODE_TEXT "${CODE_TEXT}  .class_name = \"${CIP_DICTIONARY_NAME}\",\n" )
+set( CODE_TEXT "${CODE_TEXT}  .is_static = true\n};\n\n" )
+set( CODE_TEXT "${CODE_TEXT}#endif /* ${guard} */\n" )
+
+file( WRITE ${HEADER} "${CODE_TEXT}" )
@@ -10,3 +10,16 @@ check_function_exists( rand HAVE_RAND )
 if( (NOT(HAVE_SRAND)) OR (NOT(HAVE_RAND)) )
   
 endif( (NOT(HAVE_SRAND)) OR (NOT(HAVE_RAND)) )
+
+include (CheckIncludeFiles)
+
+check_include_files( sys/epoll.h HAVE_SYS_EPOLL_H )
+check_include_files( linux/io_uring.h HAVE_LINUX_IO_URING_H )
+
+include (CheckSymbolExists)
+
+set( CMAKE_REQUIRED_DEFINITIONS -D_GNU_SOURCE )
+check_symbol_exists( recvmmsg sys/socket.h HAVE_RECVMMSG )
+check_symbol_exists( sendmmsg sys/socket.h HAVE_SENDMMSG )
+check_symbol_exists( sendmsg sys/socket.h HAVE_SENDMSG )
+unset( CMAKE_REQUIRED_DEFINITIONS )
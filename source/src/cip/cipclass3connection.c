@@ -17,10 +17,13 @@ ConnectionObject g_explicit_connections[OPENER_CIP_NUM_EXPLICIT_CONNS];
 
 /**** Implementation ****/
 EipStatus EstablishClass3Connection(ConnectionObject *connection_object,
-                              EipUint16 *extended_error) {
+                                    struct request_context *context,
+                                    EipUint16 *extended_error) {
   EipStatus eip_status = kEipStatusOk;
   EipUint32 produced_connection_id_buffer;
 
+  (void) context; /* explicit connections need no socket address info items */
+
   /*TODO add check for transport type trigger */
   /* if (0x03 == (g_stDummyConnectionObject.TransportTypeClassTrigger & 0x03)) */
 
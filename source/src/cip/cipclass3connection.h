@@ -18,13 +18,15 @@
  *
  * This function can be called after all data has been parsed from the forward open request
  * @param pa_pstConnObj pointer to the connection object structure holding the parsed data from the forward open request
+ * @param context the Forward Open request
  * @param pa_pnExtendedError the extended error code in case an error happened
  * @return general status on the establishment
  *    - EIP_OK ... on success
  *    - On an error the general status code to be put into the response
  */
 EipStatus EstablishClass3Connection(ConnectionObject *connection_object,
-                              EipUint16 *extended_error);
+                                    struct request_context *context,
+                                    EipUint16 *extended_error);
 
 void InitializeClass3ConnectionData(void);
 
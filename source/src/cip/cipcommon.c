@@ -22,9 +22,6 @@
 #include "trace.h"
 #include "appcontype.h"
 
-/* global public variables */
-EipUint8 g_message_data_reply_buffer[OPENER_MESSAGE_DATA_REPLY_BUFFER];
-
 const EipUint16 kCipUintZero = 0;
 
 /* private functions*/
@@ -68,9 +65,9 @@ void ShutdownCipStack(void) {
 EipStatus NotifyClass(CipClass *cip_class,
                       CipMessageRouterRequest *message_router_request,
                       CipMessageRouterResponse *message_router_response) {
-  int i;
   CipInstance *instance;
   CipServiceStruct *service;
+  EipUint16 service_slot;
   unsigned instance_number; /* my instance number */
 
   /* find the instance: if instNr==0, the class is addressed, else find the instance */
@@ -81,22 +78,16 @@ EipStatus NotifyClass(CipClass *cip_class,
     OPENER_TRACE_INFO("notify: found instance %d%s\n", instance_number,
                       instance_number == 0 ? " (class object)" : "");
 
-    service = instance->cip_class->services; /* get pointer to array of services */
-    if (service) /* if services are defined */
+    service_slot = instance->cip_class->service_slots[message_router_request
+        ->service]; /* look up the service in the dispatch table */
+    if (0 != service_slot) /* if a match is found */
     {
-      for (i = 0; i < instance->cip_class->number_of_services; i++) /* seach the services list */
-      {
-        if (message_router_request->service == service->service_number) /* if match is found */
-        {
-          /* call the service, and return what it returns */
-          OPENER_TRACE_INFO("notify: calling %s service\n", service->name);
-          OPENER_ASSERT(NULL != service->service_function);
-          return service->service_function(instance, message_router_request,
-                                           message_router_response);
-        } else {
-          service++;
-        }
-      }
+      service = &instance->cip_class->services[service_slot - 1];
+      /* call the service, and return what it returns */
+      OPENER_TRACE_INFO("notify: calling %s service\n", service->name);
+      OPENER_ASSERT(NULL != service->service_function);
+      return service->service_function(instance, message_router_request,
+                                       message_router_response);
     }
     OPENER_TRACE_WARN("notify: service 0x%x not supported\n",
                       message_router_request->service);
@@ -116,21 +107,100 @@ EipStatus NotifyClass(CipClass *cip_class,
   return kEipStatusOkSend;
 }
 
-CipInstance *AddCipInstances(CipClass *cip_class, int number_of_instances) {
+/** @brief Makes room for the given number of additional instances in the
+ * instance index of the class
+ *
+ *  @param cip_class the class whose index is to be enlarged
+ *  @param number_of_instances number of instances about to be added
+ *  @return kEipStatusOk on success, kEipStatusError if out of memory
+ */
+static EipStatus ReserveInstanceIndex(CipClass *cip_class,
+                                      int number_of_instances) {
+  EipUint32 needed_capacity = cip_class->instance_index_length
+      + number_of_instances;
+  if (needed_capacity <= cip_class->instance_index_capacity) {
+    return kEipStatusOk;
+  }
+  EipUint32 capacity = 2 * cip_class->instance_index_capacity;
+  if (capacity < needed_capacity) {
+    capacity = needed_capacity;
+  }
+  CipInstance **index = (CipInstance **) CipCalloc(capacity,
+                                                   sizeof(CipInstance *));
+  if (NULL == index) {
+    return kEipStatusError;
+  }
+  if (NULL != cip_class->instance_index) {
+    memcpy(index, cip_class->instance_index,
+           cip_class->instance_index_length * sizeof(CipInstance *));
+    CipFree(cip_class->instance_index);
+  }
+  cip_class->instance_index = index;
+  cip_class->instance_index_capacity = capacity;
+  return kEipStatusOk;
+}
+
+/** @brief Returns the position of the first instance in the index whose
+ * instance number is not lower than the given one */
+static EipUint32 FindInstanceIndexPosition(const CipClass *cip_class,
+                                           EipUint32 instance_number) {
+  EipUint32 low = 0;
+  EipUint32 high = cip_class->instance_index_length;
+
+  while (low < high) {
+    EipUint32 middle = low + (high - low) / 2;
+    if (cip_class->instance_index[middle]->instance_number < instance_number) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/** @brief Enters an instance into the instance index of its class, the index
+ * has to have room for it */
+static void InsertIntoInstanceIndex(CipClass *cip_class, CipInstance *instance) {
+  EipUint32 length = cip_class->instance_index_length;
+  EipUint32 position = length;
+
+  /* instances are usually added with ascending numbers */
+  if ((0 < length)
+      && (cip_class->instance_index[length - 1]->instance_number
+          > instance->instance_number)) {
+    position = FindInstanceIndexPosition(cip_class, instance->instance_number);
+    memmove(&cip_class->instance_index[position + 1],
+            &cip_class->instance_index[position],
+            (length - position) * sizeof(CipInstance *));
+  }
+  cip_class->instance_index[position] = instance;
+  cip_class->instance_index_length++;
+}
+
+/** @brief Creates instances with consecutive instance numbers, appends them
+ * to the list of instances of the class and enters them into its index
+ *
+ *  @param cip_class the class the instances are created for
+ *  @param number_of_instances number of instances to be created
+ *  @param instance_number instance number of the first new instance
+ *  @return pointer to the first of the new instances, 0 on error
+ */
+static CipInstance *CreateCipInstances(CipClass *cip_class,
+                                       int number_of_instances,
+                                       EipUint32 instance_number) {
   CipInstance *first_instance, *current_instance, **next_instance;
   int i;
-  int instance_number = 1; /* the first instance is number 1 */
 
-  OPENER_TRACE_INFO("adding %d instances to class %s\n", number_of_instances,
-                    cip_class->class_name);
-
-  next_instance = &cip_class->instances; /* get address of pointer to head of chain */
-  while (*next_instance) /* as long as what pp points to is not zero */
-  {
-    next_instance = &(*next_instance)->next; /*    follow the chain until pp points to pointer that contains a zero */
-    instance_number++; /*    keep track of what the first new instance number will be */
+  OPENER_ASSERT(!cip_class->is_static);
+  /* the instances of a generated dictionary are fixed */
+  if (kEipStatusOk != ReserveInstanceIndex(cip_class, number_of_instances)) {
+    OPENER_ASSERT(0);
+    return 0;
   }
 
+  next_instance = (NULL == cip_class->last_instance) ?
+      &cip_class->instances : &cip_class->last_instance->next; /* the pointer terminating the chain */
+
   first_instance = current_instance = (CipInstance *) CipCalloc(
       number_of_instances, sizeof(CipInstance)); /* allocate a block of memory for all created instances*/
   OPENER_ASSERT(NULL != current_instance);
@@ -150,6 +220,8 @@ CipInstance *AddCipInstances(CipClass *cip_class, int number_of_instances) {
       current_instance->attributes = (CipAttributeStruct*) CipCalloc(
           cip_class->number_of_attributes, sizeof(CipAttributeStruct));
     }
+    InsertIntoInstanceIndex(cip_class, current_instance);
+    cip_class->last_instance = current_instance;
 
     next_instance = &current_instance->next; /* update pp to point to the next link of the current node */
     instance_number++; /* update to the number of the next node*/
@@ -159,12 +231,20 @@ CipInstance *AddCipInstances(CipClass *cip_class, int number_of_instances) {
   return first_instance;
 }
 
+CipInstance *AddCipInstances(CipClass *cip_class, int number_of_instances) {
+  OPENER_TRACE_INFO("adding %d instances to class %s\n", number_of_instances,
+                    cip_class->class_name);
+
+  /* the instances are numbered on from the number of existing instances */
+  return CreateCipInstances(cip_class, number_of_instances,
+                            cip_class->number_of_instances + 1);
+}
+
 CipInstance *AddCIPInstance(CipClass *class, EipUint32 instance_id) {
   CipInstance *instance = GetCipInstance(class, instance_id);
 
   if (0 == instance) { /*we have no instance with given id*/
-    instance = AddCipInstances(class, 1);
-    instance->instance_number = instance_id;
+    instance = CreateCipInstances(class, 1, instance_id);
   }
   return instance;
 }
@@ -204,7 +284,7 @@ CipClass *CreateCipClass(EipUint32 class_id, int number_of_class_attributes,
   class->number_of_attributes = number_of_instance_attributes; /* the class remembers the number of instances of that class */
   class->get_attribute_all_mask = get_all_instance_attributes_mask; /* indicate which attributes are included in instance getAttributeAll */
   class->number_of_services = number_of_instance_services
-      + ((0 == get_all_instance_attributes_mask) ? 1 : 2); /* the class manages the behavior of the instances */
+      + ((0 == get_all_instance_attributes_mask) ? 3 : 4); /* the class manages the behavior of the instances */
   class->services = 0;
   class->class_name = name; /* initialize the class-specific fields of the metaClass struct */
   meta_class->class_id = 0xffffffff; /* set metaclass ID (this should never be referenced) */
@@ -213,7 +293,7 @@ CipClass *CreateCipClass(EipUint32 class_id, int number_of_class_attributes,
   meta_class->number_of_attributes = number_of_class_attributes + 7; /* the metaclass remembers how many class attributes exist*/
   meta_class->get_attribute_all_mask = get_all_class_attributes_mask; /* indicate which attributes are included in class getAttributeAll*/
   meta_class->number_of_services = number_of_class_services
-      + ((0 == get_all_class_attributes_mask) ? 1 : 2); /* the metaclass manages the behavior of the class itself */
+      + ((0 == get_all_class_attributes_mask) ? 3 : 4); /* the metaclass manages the behavior of the class itself */
   class->services = 0;
   meta_class->class_name = (char *) CipCalloc(1, strlen(name) + 6); /* fabricate the name "meta<classname>"*/
   strcpy(meta_class->class_name, "meta-");
@@ -275,6 +355,10 @@ CipClass *CreateCipClass(EipUint32 class_id, int number_of_class_attributes,
   }
   InsertService(meta_class, kGetAttributeSingle, &GetAttributeSingle,
                 "GetAttributeSingle");
+  InsertService(meta_class, kGetAttributeList, &GetAttributeList,
+                "GetAttributeList");
+  InsertService(meta_class, kSetAttributeList, &SetAttributeList,
+                "SetAttributeList");
 
   /* create the standard instance services*/
   if (0 != get_all_instance_attributes_mask) { /*only if the mask has values add the get_attribute_all service */
@@ -282,15 +366,51 @@ CipClass *CreateCipClass(EipUint32 class_id, int number_of_class_attributes,
   }
   InsertService(class, kGetAttributeSingle, &GetAttributeSingle,
                 "GetAttributeSingle");
+  InsertService(class, kGetAttributeList, &GetAttributeList,
+                "GetAttributeList");
+  InsertService(class, kSetAttributeList, &SetAttributeList,
+                "SetAttributeList");
 
   return class;
 }
 
+/** @brief Remembers the position of an attribute in the attributes of the
+ * instances of a class
+ *
+ * The instances usually insert their attributes in the same order, an
+ * instance deviating from the recorded position is searched by
+ * GetCipAttribute.
+ *
+ *  @param cip_class the class of the instance
+ *  @param attribute_number number of the inserted attribute
+ *  @param slot position of the attribute in the attributes of the instance
+ */
+static void RecordAttributeSlot(CipClass *cip_class,
+                                EipUint16 attribute_number, int slot) {
+  if (attribute_number >= cip_class->number_of_attribute_slots) {
+    EipUint16 *attribute_slots = (EipUint16 *) CipCalloc(attribute_number + 1,
+                                                         sizeof(EipUint16));
+    OPENER_ASSERT(NULL != attribute_slots);
+    if (NULL != cip_class->attribute_slots) {
+      memcpy(attribute_slots, cip_class->attribute_slots,
+             cip_class->number_of_attribute_slots * sizeof(EipUint16));
+      CipFree(cip_class->attribute_slots);
+    }
+    cip_class->attribute_slots = attribute_slots;
+    cip_class->number_of_attribute_slots = attribute_number + 1;
+  }
+  if (0 == cip_class->attribute_slots[attribute_number]) {
+    cip_class->attribute_slots[attribute_number] = slot + 1;
+  }
+}
+
 void InsertAttribute(CipInstance *instance, EipUint16 attribute_number,
                      EipUint8 cip_type, void *data, EipByte cip_flags) {
   int i;
   CipAttributeStruct *attribute;
 
+  OPENER_ASSERT(!instance->cip_class->is_static);
+  /* the attributes of a generated dictionary are read-only */
   attribute = instance->attributes;
   OPENER_ASSERT(NULL != attribute);
   /* adding a attribute to a class that was not declared to have any attributes is not allowed */
@@ -300,6 +420,7 @@ void InsertAttribute(CipInstance *instance, EipUint16 attribute_number,
       attribute->type = cip_type;
       attribute->attribute_flags = cip_flags;
       attribute->data = data;
+      RecordAttributeSlot(instance->cip_class, attribute_number, i);
 
       if (attribute_number > instance->cip_class->highest_attribute_number) /* remember the max attribute number that was defined*/
       {
@@ -323,6 +444,8 @@ void InsertService(CipClass * class, EipUint8 service_number,
   int i;
   CipServiceStruct *p;
 
+  OPENER_ASSERT(!class->is_static);
+  /* the services of a generated dictionary are read-only */
   p = class->services; /* get a pointer to the service array*/
   OPENER_ASSERT(p != 0);
   /* adding a service to a class that was not declared to have services is not allowed*/
@@ -333,6 +456,7 @@ void InsertService(CipClass * class, EipUint8 service_number,
       p->service_number = service_number; /* fill in service number*/
       p->service_function = service_function; /* fill in function address*/
       p->name = service_name;
+      class->service_slots[service_number] = i + 1; /* dispatch the service code to this slot*/
       return;
     }
     p++;
@@ -344,12 +468,22 @@ void InsertService(CipClass * class, EipUint8 service_number,
 CipAttributeStruct *GetCipAttribute(CipInstance * instance,
                                     EipUint16 attribute_number) {
   int i;
+  CipClass *cip_class = instance->cip_class;
   CipAttributeStruct *attribute = instance->attributes; /* init pointer to array of attributes*/
-  for (i = 0; i < instance->cip_class->number_of_attributes; i++) {
+
+  if ((attribute_number < cip_class->number_of_attribute_slots)
+      && (0 != cip_class->attribute_slots[attribute_number])) {
+    attribute += cip_class->attribute_slots[attribute_number] - 1; /* the attribute's usual position */
     if (attribute_number == attribute->attribute_number)
       return attribute;
-    else
-      attribute++;
+
+    attribute = instance->attributes; /* the instance has inserted its attributes in another order */
+    for (i = 0; i < cip_class->number_of_attributes; i++) {
+      if (attribute_number == attribute->attribute_number)
+        return attribute;
+      else
+        attribute++;
+    }
   }
 
   OPENER_TRACE_WARN("attribute %d not defined\n", attribute_number);
@@ -357,7 +491,6 @@ CipAttributeStruct *GetCipAttribute(CipInstance * instance,
   return 0;
 }
 
-/* TODO this needs to check for buffer overflow*/
 EipStatus GetAttributeSingle(CipInstance *instance,
                              CipMessageRouterRequest *message_router_request,
                              CipMessageRouterResponse *message_router_response) {
@@ -392,6 +525,15 @@ EipStatus GetAttributeSingle(CipInstance *instance,
        * single.
        */
 
+      if (GetEncodedDataLength(attribute->type, attribute->data)
+          > message_router_response->data_capacity) {
+        /* the attribute does not fit into the reply */
+        OPENER_TRACE_WARN("attribute %d too large for the reply\n",
+                          message_router_request->request_path.attribute_number);
+        message_router_response->general_status = kCipErrorReplyDataTooLarge;
+        return kEipStatusOkSend;
+      }
+
       if (attribute->type == kCipByteArray
           && instance->cip_class->class_id == kCipAssemblyClassCode) {
         /* we are getting a byte array of a assembly object, kick out to the app callback */
@@ -573,6 +715,65 @@ int EncodeData(EipUint8 cip_type, void *data, EipUint8 **message) {
   return counter;
 }
 
+int GetEncodedDataLength(EipUint8 cip_type, void *data) {
+  switch (cip_type) {
+    case (kCipBool):
+    case (kCipSint):
+    case (kCipUsint):
+    case (kCipByte):
+      return 1;
+
+    case (kCipInt):
+    case (kCipUint):
+    case (kCipWord):
+    case (kCipUsintUsint):
+      return 2;
+
+    case (kCipDint):
+    case (kCipUdint):
+    case (kCipDword):
+    case (kCipReal):
+      return 4;
+
+#ifdef OPENER_SUPPORT_64BIT_DATATYPES
+    case (kCipLint):
+    case (kCipUlint):
+    case (kCipLword):
+    case (kCipLreal):
+      return 8;
+#endif
+
+    case (kCipString): {
+      CipString *string = (CipString *) data;
+      return 2 + string->length + (string->length & 0x01); /* padded to even */
+    }
+
+    case (kCipShortString):
+      return 1 + ((CipShortString *) data)->length;
+
+    case (kCipEpath):
+      return 2 + ((CipEpath *) data)->path_size * 2;
+
+    case (kCipUdintUdintUdintUdintUdintString):
+      return 5 * 4
+          + GetEncodedDataLength(
+              kCipString,
+              &((CipTcpIpNetworkInterfaceConfiguration *) data)->domain_name);
+
+    case (kCip6Usint):
+      return 6;
+
+    case (kCipByteArray):
+      return ((CipByteArray *) data)->length;
+
+    case (kInternalUint6):
+      return 12;
+
+    default: /* types EncodeData does not encode */
+      return 0;
+  }
+}
+
 int DecodeData(EipUint8 cip_type, void *data, EipUint8 **message) {
   int number_of_decoded_bytes = -1;
 
@@ -649,59 +850,301 @@ int DecodeData(EipUint8 cip_type, void *data, EipUint8 **message) {
 EipStatus GetAttributeAll(CipInstance *instance,
                           CipMessageRouterRequest *message_router_request,
                           CipMessageRouterResponse *message_router_response) {
-  int i, j;
+  int j;
   EipUint8 *reply;
+  EipInt16 data_capacity = message_router_response->data_capacity;
   CipAttributeStruct *attribute;
   CipServiceStruct *service;
+  EipUint16 service_slot;
 
   reply = message_router_response->data; /* pointer into the reply */
   attribute = instance->attributes; /* pointer to list of attributes*/
-  service = instance->cip_class->services; /* pointer to list of services*/
+  service_slot = instance->cip_class->service_slots[kGetAttributeSingle]; /* look up the GET_ATTRIBUTE_SINGLE service*/
 
   if (instance->instance_number == 2) {
     OPENER_TRACE_INFO("GetAttributeAll: instance number 2\n");
   }
 
-  for (i = 0; i < instance->cip_class->number_of_services; i++) /* hunt for the GET_ATTRIBUTE_SINGLE service*/
+  if (0 != service_slot) /* found the service */
   {
-    if (service->service_number == kGetAttributeSingle) /* found the service */
-    {
-      if (0 == instance->cip_class->number_of_attributes) {
-        message_router_response->data_length = 0; /*there are no attributes to be sent back*/
-        message_router_response->reply_service = (0x80
-            | message_router_request->service);
-        message_router_response->general_status = kCipErrorServiceNotSupported;
-        message_router_response->size_of_additional_status = 0;
-      } else {
-        for (j = 0; j < instance->cip_class->number_of_attributes; j++) /* for each instance attribute of this class */
-        {
-          int attrNum = attribute->attribute_number;
-          if (attrNum < 32
-              && (instance->cip_class->get_attribute_all_mask & 1 << attrNum)) /* only return attributes that are flagged as being part of GetAttributeALl */
-              {
-            message_router_request->request_path.attribute_number = attrNum;
-            if (kEipStatusOkSend
-                != service->service_function(instance, message_router_request,
-                                             message_router_response)) {
-              message_router_response->data = reply;
-              return kEipStatusError;
-            }
-            message_router_response->data += message_router_response
-                ->data_length;
+    service = &instance->cip_class->services[service_slot - 1];
+    if (0 == instance->cip_class->number_of_attributes) {
+      message_router_response->data_length = 0; /*there are no attributes to be sent back*/
+      message_router_response->reply_service = (0x80
+          | message_router_request->service);
+      message_router_response->general_status = kCipErrorServiceNotSupported;
+      message_router_response->size_of_additional_status = 0;
+    } else {
+      for (j = 0; j < instance->cip_class->number_of_attributes; j++) /* for each instance attribute of this class */
+      {
+        int attrNum = attribute->attribute_number;
+        if (attrNum < 32
+            && (instance->cip_class->get_attribute_all_mask & 1 << attrNum)) /* only return attributes that are flagged as being part of GetAttributeALl */
+            {
+          message_router_request->request_path.attribute_number = attrNum;
+          /* each attribute may take the room the previous ones left */
+          message_router_response->data_capacity = data_capacity
+              - (message_router_response->data - reply);
+          if (kEipStatusOkSend
+              != service->service_function(instance, message_router_request,
+                                           message_router_response)) {
+            message_router_response->data = reply;
+            message_router_response->data_capacity = data_capacity;
+            return kEipStatusError;
           }
-          attribute++;
+          if (kCipErrorSuccess != message_router_response->general_status) {
+            /* e.g. the attribute did not fit, the reply carries no data */
+            message_router_response->data = reply;
+            message_router_response->data_capacity = data_capacity;
+            message_router_response->data_length = 0;
+            return kEipStatusOkSend;
+          }
+          message_router_response->data += message_router_response
+              ->data_length;
         }
-        message_router_response->data_length = message_router_response->data
-            - reply;
-        message_router_response->data = reply;
+        attribute++;
       }
-      return kEipStatusOkSend;
+      message_router_response->data_length = message_router_response->data
+          - reply;
+      message_router_response->data = reply;
+      message_router_response->data_capacity = data_capacity;
     }
-    service++;
+    return kEipStatusOkSend;
   }
   return kEipStatusOk; /* Return kEipStatusOk if cannot find GET_ATTRIBUTE_SINGLE service*/
 }
 
+/** @brief Returns the service of the class handling the given service code,
+ * NULL if the class does not support it */
+static CipServiceStruct *GetCipService(CipClass *cip_class,
+                                       EipUint8 service_number) {
+  EipUint16 service_slot = cip_class->service_slots[service_number];
+  return (0 == service_slot) ? NULL : &cip_class->services[service_slot - 1];
+}
+
+/** @brief Returns the number of bytes the value of an attribute takes in a
+ * request, -1 if it cannot be determined
+ *
+ *  @param attribute the attribute the value is meant for
+ *  @param message the encoded value
+ *  @param remaining_length number of bytes left in the request
+ */
+static int GetEncodedAttributeLength(const CipAttributeStruct *attribute,
+                                     EipUint8 *message, int remaining_length) {
+  switch (attribute->type) {
+    case (kCipBool):
+    case (kCipSint):
+    case (kCipUsint):
+    case (kCipByte):
+      return 1;
+    case (kCipInt):
+    case (kCipUint):
+    case (kCipWord):
+    case (kCipUsintUsint):
+      return 2;
+    case (kCipDint):
+    case (kCipUdint):
+    case (kCipDword):
+    case (kCipReal):
+      return 4;
+#ifdef OPENER_SUPPORT_64BIT_DATATYPES
+    case (kCipLint):
+    case (kCipUlint):
+    case (kCipLword):
+    case (kCipLreal):
+      return 8;
+#endif
+    case (kCip6Usint):
+      return 6;
+    case (kInternalUint6):
+      return 12;
+    case (kCipByteArray):
+      return ((CipByteArray *) attribute->data)->length;
+    case (kCipString): {
+      if (2 > remaining_length) {
+        return -1;
+      }
+      int length = 2 + GetIntFromMessage(&message);
+      return length + (length & 0x01); /* odd byte counts are padded */
+    }
+    case (kCipShortString):
+      return (1 > remaining_length) ? -1 : 1 + *message;
+    default:
+      return -1;
+  }
+}
+
+EipStatus GetAttributeList(CipInstance *instance,
+                           CipMessageRouterRequest *message_router_request,
+                           CipMessageRouterResponse *message_router_response) {
+  EipUint8 *message = message_router_request->data;
+  EipUint8 *reply = message_router_response->data;
+  EipUint8 *reply_end = reply + message_router_response->data_capacity;
+  EipUint8 *next_entry;
+  CipMessageRouterRequest attribute_request = *message_router_request;
+  CipMessageRouterResponse attribute_response;
+  CipServiceStruct *service = GetCipService(instance->cip_class,
+                                            kGetAttributeSingle);
+  int number_of_attributes;
+  int i;
+
+  message_router_response->reply_service = (0x80
+      | message_router_request->service);
+  message_router_response->general_status = kCipErrorSuccess;
+  message_router_response->size_of_additional_status = 0;
+  message_router_response->data_length = 0;
+
+  if (2 > message_router_request->data_length) {
+    message_router_response->general_status = kCipErrorNotEnoughData;
+    return kEipStatusOkSend;
+  }
+  number_of_attributes = GetIntFromMessage(&message);
+  if (2 + 2 * number_of_attributes > message_router_request->data_length) {
+    message_router_response->general_status = kCipErrorNotEnoughData;
+    return kEipStatusOkSend;
+  }
+  if (2 + 2 * number_of_attributes < message_router_request->data_length) {
+    message_router_response->general_status = kCipErrorTooMuchData;
+    return kEipStatusOkSend;
+  }
+
+  next_entry = reply;
+  AddIntToMessage(number_of_attributes, &next_entry);
+  attribute_request.service = kGetAttributeSingle;
+  attribute_request.data_length = 0;
+
+  for (i = 0; i < number_of_attributes; i++) {
+    EipUint16 attribute_number = GetIntFromMessage(&message);
+
+    if (next_entry + 4 > reply_end) {
+      OPENER_TRACE_WARN("GetAttributeList: reply does not fit\n");
+      message_router_response->general_status = kCipErrorReplyDataTooLarge;
+      return kEipStatusOkSend;
+    }
+    /* the attribute is encoded in place behind its number and status and may
+     * take what is left of the reply */
+    attribute_response.data = next_entry + 4;
+    attribute_response.data_capacity = reply_end - attribute_response.data;
+    attribute_response.data_length = 0;
+    attribute_response.general_status = kCipErrorServiceNotSupported;
+    if (NULL != service) {
+      attribute_request.request_path.attribute_number = attribute_number;
+      service->service_function(instance, &attribute_request,
+                                &attribute_response);
+    }
+    if (kCipErrorSuccess != attribute_response.general_status) {
+      attribute_response.data_length = 0;
+      message_router_response->general_status = kCipErrorAttributeListError;
+    }
+
+    AddIntToMessage(attribute_number, &next_entry);
+    AddIntToMessage(attribute_response.general_status, &next_entry);
+    next_entry += attribute_response.data_length;
+  }
+
+  message_router_response->data_length = next_entry - reply;
+  return kEipStatusOkSend;
+}
+
+EipStatus SetAttributeList(CipInstance *instance,
+                           CipMessageRouterRequest *message_router_request,
+                           CipMessageRouterResponse *message_router_response) {
+  EipUint8 *message = message_router_request->data;
+  EipUint8 *request_end = message + message_router_request->data_length;
+  EipUint8 *reply = message_router_response->data;
+  EipUint8 *reply_end = reply + message_router_response->data_capacity;
+  EipUint8 *next_entry;
+  EipUint8 attribute_data[PC_OPENER_ETHERNET_BUFFER_SIZE]; /* SetAttributeSingle replies in here */
+  CipMessageRouterRequest attribute_request = *message_router_request;
+  CipMessageRouterResponse attribute_response;
+  CipServiceStruct *service = GetCipService(instance->cip_class,
+                                            kSetAttributeSingle);
+  int number_of_attributes;
+  int i;
+
+  message_router_response->reply_service = (0x80
+      | message_router_request->service);
+  message_router_response->general_status = kCipErrorSuccess;
+  message_router_response->size_of_additional_status = 0;
+  message_router_response->data_length = 0;
+
+  if (2 > message_router_request->data_length) {
+    message_router_response->general_status = kCipErrorNotEnoughData;
+    return kEipStatusOkSend;
+  }
+  number_of_attributes = GetIntFromMessage(&message);
+  if (reply + 2 + 4 * number_of_attributes > reply_end) {
+    message_router_response->general_status = kCipErrorReplyDataTooLarge;
+    return kEipStatusOkSend;
+  }
+
+  next_entry = reply + 2;
+  attribute_request.service = kSetAttributeSingle;
+
+  for (i = 0; i < number_of_attributes; i++) {
+    CipAttributeStruct *attribute = NULL;
+    EipUint16 attribute_number;
+    EipUint16 status = kCipErrorSuccess;
+    int length = -1;
+
+    if (2 > request_end - message) {
+      message_router_response->general_status = kCipErrorNotEnoughData;
+      break;
+    }
+    attribute_number = GetIntFromMessage(&message);
+    attribute = GetCipAttribute(instance, attribute_number);
+
+    if (NULL == attribute) {
+      status = kCipErrorAttributeNotSupported;
+    } else if (0
+        > (length = GetEncodedAttributeLength(attribute, message,
+                                              request_end - message))) {
+      status = kCipErrorAttributeNotSupported;
+    } else if (length > request_end - message) {
+      status = kCipErrorNotEnoughData;
+      length = -1;
+    } else if (NULL != service) {
+      attribute_response.data = attribute_data;
+      attribute_response.data_capacity = sizeof(attribute_data);
+      attribute_response.data_length = 0;
+      attribute_response.general_status = kCipErrorSuccess;
+      attribute_request.request_path.attribute_number = attribute_number;
+      attribute_request.data = message;
+      attribute_request.data_length = length;
+      service->service_function(instance, &attribute_request,
+                                &attribute_response);
+      status = attribute_response.general_status;
+    } else if ((0 != (attribute->attribute_flags & kSetable))
+        && (kCipString != attribute->type)
+        && (kCipShortString != attribute->type)) {
+      /* the capacity of a string is unknown here, strings need the class's
+       * SetAttributeSingle */
+      EipUint8 *data = message;
+      if (length != DecodeData(attribute->type, attribute->data, &data)) {
+        status = kCipErrorAttributeNotSetable; /* DecodeData lacks the type */
+      }
+    } else {
+      status = kCipErrorAttributeNotSetable;
+    }
+
+    AddIntToMessage(attribute_number, &next_entry);
+    AddIntToMessage(status, &next_entry);
+    if (kCipErrorSuccess != status) {
+      message_router_response->general_status = kCipErrorAttributeListError;
+    }
+    if (0 > length) {
+      i++; /* the data of the following attributes cannot be found */
+      break;
+    }
+    message += length;
+  }
+
+  message = reply;
+  AddIntToMessage(i, &message);
+  message_router_response->data_length = next_entry - reply;
+  return kEipStatusOkSend;
+}
+
 int EncodeEPath(CipEpath *epath, EipUint8 **message) {
   unsigned int length = epath->path_size;
   AddIntToMessage(epath->path_size, message);
@@ -13,13 +13,9 @@
 #include "typedefs.h"
 #include "ciptypes.h"
 
-/** A buffer for holding the replay generated by explicit message requests
- *  or producing I/O connections. These will use this buffer in the following
- *  ways:
- *    1. Explicit messages will use this buffer to store the data generated by the request
- *    2. I/O Connections will use this buffer for the produced data
- */
-extern EipUint8 g_message_data_reply_buffer[];
+/** @brief Data of the class attributes 4 and 5 (optional attribute and service
+ * lists), no optional attributes or services are listed */
+extern const EipUint16 kCipUintZero;
 
 /** @brief Check if requested service present in class/instance and call appropriate service.
  *
@@ -38,7 +34,8 @@ EipStatus NotifyClass(CipClass *class,
 /** @brief Generic implementation of the GetAttributeSingle CIP service
  *
  *  Check from classID which Object requests an attribute, search if object has
- *  the appropriate attribute implemented.
+ *  the appropriate attribute implemented. An attribute larger than the
+ *  data_capacity of the response is answered with kCipErrorReplyDataTooLarge.
  * @param instance pointer to instance.
  * @param message_router_request pointer to request.
  * @param message_router_response pointer to response.
@@ -51,7 +48,8 @@ EipStatus GetAttributeSingle(CipInstance *instance,
 
 /** @brief Generic implementation of the GetAttributeAll CIP service
  *
- * Copy all attributes from Object into the global message buffer.
+ * Copy all attributes from Object into the response, bounded by its
+ * data_capacity.
  * @param instance pointer to object instance with data.
  * @param message_router_request pointer to MR request.
  * @param message_router_response pointer for MR response.
@@ -62,6 +60,37 @@ EipStatus GetAttributeAll(CipInstance *instance,
                           CipMessageRouterRequest *message_router_request,
                           CipMessageRouterResponse *message_router_response);
 
+/** @brief Generic implementation of the GetAttributeList CIP service
+ *
+ * Reads the requested attributes with the GetAttributeSingle service of the
+ * class and replies the attribute number, the status and, if successful, the
+ * data of every attribute. An attribute which does not fit into the rest of
+ * the reply gets the status kCipErrorReplyDataTooLarge.
+ * @param instance pointer to object instance with data.
+ * @param message_router_request pointer to MR request.
+ * @param message_router_response pointer for MR response.
+ * @return kEipStatusOkSend
+ */
+EipStatus GetAttributeList(CipInstance *instance,
+                           CipMessageRouterRequest *message_router_request,
+                           CipMessageRouterResponse *message_router_response);
+
+/** @brief Generic implementation of the SetAttributeList CIP service
+ *
+ * Writes the requested attributes with the SetAttributeSingle service of the
+ * class, classes without one get their setable attributes decoded with
+ * DecodeData; strings and the types DecodeData does not know are refused as
+ * not setable there. Replies the attribute number and the status of every attribute,
+ * the processing stops at an attribute whose data cannot be delimited.
+ * @param instance pointer to object instance with data.
+ * @param message_router_request pointer to MR request.
+ * @param message_router_response pointer for MR response.
+ * @return kEipStatusOkSend
+ */
+EipStatus SetAttributeList(CipInstance *instance,
+                           CipMessageRouterRequest *message_router_request,
+                           CipMessageRouterResponse *message_router_response);
+
 /** @brief Decodes padded EPath
  *  @param epath EPath to the receiving element
  *  @param message CIP Message to decode
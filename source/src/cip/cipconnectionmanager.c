@@ -3,6 +3,7 @@
  * All rights reserved. 
  *
  ******************************************************************************/
+#include <limits.h>
 #include <string.h>
 
 #include "cipconnectionmanager.h"
@@ -33,6 +34,29 @@ extern CipRevision revision_;
 #define CIP_CONN_TYPE_MASK 0x6000   /**< Bit mask filter on bit 13 & 14 */
 
 const int g_kForwardOpenHeaderLength = 36; /**< the length in bytes of the forward open command specific data till the start of the connection path (including con path size)*/
+const int g_kLargeForwardOpenHeaderLength = 40; /**< the same for the large forward open with its 32 bit network connection parameters */
+
+#ifndef OPENER_CONNECTION_ID_INDEX_SIZE
+/** @brief Number of buckets of the index finding active connections by their
+ * consumed connection ID, has to be a power of two */
+#define OPENER_CONNECTION_ID_INDEX_SIZE 256
+#endif
+
+#ifndef OPENER_MINIMUM_RPI
+/** @brief Smallest RPI in microseconds granted to a connection, smaller
+ * requested RPIs are rounded up to it */
+#define OPENER_MINIMUM_RPI 500
+#endif
+
+#ifndef OPENER_CONNECTION_TIMER_QUEUE_SIZE
+/** @brief Number of timers the connection manager can queue, two for each
+ * connection object. Has to be raised by applications with own connectable
+ * objects. */
+#define OPENER_CONNECTION_TIMER_QUEUE_SIZE (2 * (OPENER_CIP_NUM_EXPLICIT_CONNS \
+    + OPENER_CIP_NUM_EXLUSIVE_OWNER_CONNS \
+    + OPENER_CIP_NUM_INPUT_ONLY_CONNS * OPENER_CIP_NUM_INPUT_ONLY_CONNS_PER_CON_PATH \
+    + OPENER_CIP_NUM_LISTEN_ONLY_CONNS * OPENER_CIP_NUM_LISTEN_ONLY_CONNS_PER_CON_PATH))
+#endif
 
 /** @brief Compares the logical path on equality */
 #define EQLOGICALPATH(x,y) (((x)&0xfc)==(y))
@@ -55,8 +79,32 @@ ConnectionManagementHandling g_astConnMgmList[2
 /** List holding all currently active connections*/
 /*@null@*/ConnectionObject *g_active_connection_list = NULL;
 
-/** buffer connection object needed for forward open */
-ConnectionObject g_dummy_connection_object;
+/** Active connections hashed by their consumed connection ID, each bucket is
+ * linked by next_in_connection_id_index with the latest connection first */
+ConnectionObject *g_connection_id_index[OPENER_CONNECTION_ID_INDEX_SIZE];
+
+/** Time of the connection manager in microseconds, advanced by
+ * ManageConnections. All connection timers are based on it. */
+MicroSeconds g_connection_manager_time = 0;
+
+/** Production and inactivity watchdog timers of the active connections */
+TimerQueue g_connection_timers;
+QueuedTimer *g_connection_timer_storage[OPENER_CONNECTION_TIMER_QUEUE_SIZE];
+
+/** Phase policy for the first production of new connections */
+ProductionPhasePolicy g_production_phase_policy;
+
+/** Number of productions started with kProductionPhasePolicyEvenSpread */
+EipUint32 g_number_of_spread_productions;
+
+/** Production phase offsets configured for input assemblies */
+struct {
+  unsigned int input_assembly_id; /**< 0 if the entry is free */
+  MicroSeconds offset;
+} g_production_phase_offsets[OPENER_PRODUCTION_PHASE_OFFSETS];
+
+/** Productions sent per ManageConnections call */
+ProductionLoad g_production_load;
 
 /** @brief Holds the connection ID's "incarnation ID" in the upper 16 bits */
 EipUint32 g_incarnation_id;
@@ -76,12 +124,14 @@ EipStatus GetConnectionOwner(CipInstance *instance,
 
 EipStatus AssembleForwardOpenResponse(
     ConnectionObject *connection_object,
+    CipCommonPacketFormatData *common_packet_format_data,
     CipMessageRouterResponse * message_router_response, EipUint8 general_status,
     EipUint16 extended_status);
 
 EipStatus AssembleForwardCloseResponse(
     EipUint16 connection_serial_number, EipUint16 originatior_vendor_id,
     EipUint32 originator_serial_number,
+    CipCommonPacketFormatData *common_packet_format_data,
     CipMessageRouterRequest *message_router_request,
     CipMessageRouterResponse *message_router_response,
     EipUint16 extended_error_code);
@@ -129,6 +179,73 @@ ConnectionManagementHandling* GetConnMgmEntry(EipUint32 class_id);
 
 void InitializeConnectionManagerData(void);
 
+/** @brief Returns the bucket of the connection ID index holding the given
+ * connection ID */
+ConnectionObject **GetConnectionIdIndexBucket(EipUint32 connection_id);
+
+void ScheduleConnectionTimer(QueuedTimer *timer, MicroSeconds due_time);
+
+void HandleInactivityWatchdogTimer(ConnectionObject *connection_object);
+
+void HandleTransmissionTriggerTimer(ConnectionObject *connection_object);
+
+/** @brief Runs the task on the connection object in the thread owning the
+ * connection timers, see RunInIoThread */
+void RunConnectionTask(ThreadTask task, ConnectionObject *connection_object,
+                       EipBool8 wait);
+
+/** @brief Starts the timers of a new active connection and adds it to the
+ * connection ID index */
+void ActivateConnectionTask(void *object, EipUint32 value);
+
+/** @brief Stops the timers of a connection and removes it from the connection
+ * ID index */
+void DeactivateConnectionTask(void *object, EipUint32 value);
+
+void HandOverConnectionProductionTask(void *object, EipUint32 value);
+
+void TriggerConnectionProductionTask(void *object, EipUint32 value);
+
+void ResetInactivityWatchdogTask(void *object, EipUint32 value);
+
+/** @brief Calls the time out function of the connection unless it has been
+ * closed since the watchdog expired
+ *
+ * With OPENER_IO_THREAD the I/O thread confirms the time out first, see
+ * ConfirmConnectionTimeOutTask.
+ *
+ * @param object the timed out connection object
+ * @param value the consumed connection ID of the timed out connection
+ */
+void HandleConnectionTimeOutTask(void *object, EipUint32 value);
+
+#ifdef OPENER_IO_THREAD
+/** @brief Checks in the I/O thread that the watchdog of a timed out
+ * connection is still expired and has the connection closed if so
+ *
+ * Watchdog resets posted by the explicit messaging thread before the time
+ * out reached it are run by the I/O thread before this task; a connection
+ * refreshed by them gets its watchdog timer queued again.
+ *
+ * @param object the timed out connection object
+ * @param value the consumed connection ID of the timed out connection
+ */
+void ConfirmConnectionTimeOutTask(void *object, EipUint32 value);
+
+/** @brief Calls the time out function of a connection confirmed to be timed
+ * out unless it has been closed in the meantime */
+void CloseTimedOutConnectionTask(void *object, EipUint32 value);
+#endif
+
+/** @brief Restarts the inactivity watchdog, only called by the thread owning
+ * the connection timers */
+void RestartInactivityWatchdog(ConnectionObject *connection_object);
+
+/** @brief Determines the delay of the first production of the connection
+ * according to g_production_phase_policy */
+MicroSeconds DetermineProductionPhase(
+    const ConnectionObject *connection_object);
+
 void AddNullAddressItem(
     CipCommonPacketFormatData* common_data_packet_format_data);
 
@@ -174,7 +291,7 @@ EipStatus ConnectionManagerInit(EipUint16 unique_connection_id) {
       0, /* # of class services */
       0, /* # of instance attributes */
       0xffffffff, /* instance getAttributeAll mask */
-      3, /* # of instance services */
+      4, /* # of instance services */
       1, /* # of instances */
       "connection manager", /* class name */
       1); /* revision */
@@ -182,6 +299,8 @@ EipStatus ConnectionManagerInit(EipUint16 unique_connection_id) {
     return kEipStatusError;
 
   InsertService(connection_manager, kForwardOpen, &ForwardOpen, "ForwardOpen");
+  InsertService(connection_manager, kLargeForwardOpen, &ForwardOpen,
+                "LargeForwardOpen");
   InsertService(connection_manager, kForwardClose, &ForwardClose,
                 "ForwardClose");
   InsertService(connection_manager, kGetConnectionOwner, &GetConnectionOwner,
@@ -197,22 +316,24 @@ EipStatus ConnectionManagerInit(EipUint16 unique_connection_id) {
 
 EipStatus HandleReceivedConnectedData(EipUint8 *data, int data_length,
                                       struct sockaddr_in *from_address) {
+  /* not the global CPF structure, the I/O thread may handle the data */
+  CipCommonPacketFormatData common_packet_format_data;
 
   if ((CreateCommonPacketFormatStructure(data, data_length,
-                                         &g_common_packet_format_data_item))
+                                         &common_packet_format_data))
       == kEipStatusError) {
     return kEipStatusError;
   } else {
     /* check if connected address item or sequenced address item  received, otherwise it is no connected message and should not be here */
-    if ((g_common_packet_format_data_item.address_item.type_id
+    if ((common_packet_format_data.address_item.type_id
         == kCipItemIdConnectionAddress)
-        || (g_common_packet_format_data_item.address_item.type_id
+        || (common_packet_format_data.address_item.type_id
             == kCipItemIdSequencedAddressItem)) { /* found connected address item or found sequenced address item -> for now the sequence number will be ignored */
-      if (g_common_packet_format_data_item.data_item.type_id
+      if (common_packet_format_data.data_item.type_id
           == kCipItemIdConnectedDataItem) { /* connected data item received */
 
         ConnectionObject *connection_object = GetConnectedObject(
-            g_common_packet_format_data_item.address_item.data
+            common_packet_format_data.address_item.data
                 .connection_identifier);
         if (connection_object == NULL)
           return kEipStatusError;
@@ -222,23 +343,20 @@ EipStatus HandleReceivedConnectedData(EipUint8 *data, int data_length,
             == from_address->sin_addr.s_addr) {
 
           if (SEQ_GT32(
-              g_common_packet_format_data_item.address_item.data.sequence_number,
+              common_packet_format_data.address_item.data.sequence_number,
               connection_object->eip_level_sequence_count_consuming)) {
-            /* reset the watchdog timer */
-            connection_object->inactivity_watchdog_timer = (connection_object
-                ->o_to_t_requested_packet_interval / 1000)
-                << (2 + connection_object->connection_timeout_multiplier);
+            RestartInactivityWatchdog(connection_object);
 
             /* only inform assembly object if the sequence counter is greater or equal */
             connection_object->eip_level_sequence_count_consuming =
-                g_common_packet_format_data_item.address_item.data
+                common_packet_format_data.address_item.data
                     .sequence_number;
 
             if (NULL != connection_object->connection_receive_data_function) {
               return connection_object->connection_receive_data_function(
                   connection_object,
-                  g_common_packet_format_data_item.data_item.data,
-                  g_common_packet_format_data_item.data_item.length);
+                  common_packet_format_data.data_item.data,
+                  common_packet_format_data.data_item.length);
             }
           }
         } else {
@@ -251,7 +369,32 @@ EipStatus HandleReceivedConnectedData(EipUint8 *data, int data_length,
   return kEipStatusOk;
 }
 
+/** @brief Reads a network connection parameter of a (large) forward open
+ *
+ * The large forward open carries 32 bit parameters with the connection size
+ * in the lower 16 bits, their flags are returned in the layout of the 16 bit
+ * parameter.
+ *
+ *  @param message_router_request the forward open request, its data pointer
+ *  is advanced behind the parameter
+ *  @param connection_size the requested connection size in bytes
+ *  @return the network connection parameter in the 16 bit layout
+ */
+EipUint16 GetNetworkConnectionParameter(
+    CipMessageRouterRequest *message_router_request,
+    EipUint16 *connection_size) {
+  if (kLargeForwardOpen == message_router_request->service) {
+    EipUint32 parameter = GetDintFromMessage(&message_router_request->data);
+    *connection_size = (EipUint16) (parameter & 0xFFFF);
+    return (EipUint16) ((parameter >> 16) & 0xFE00);
+  }
+  EipUint16 parameter = GetIntFromMessage(&message_router_request->data);
+  *connection_size = parameter & 0x01FF;
+  return parameter;
+}
+
 /*   @brief Check if resources for new connection available, generate ForwardOpen Reply message.
+ *   Serves the forward open and the large forward open service.
  *      instance	pointer to CIP object instance
  *      message_router_request		pointer to Message Router Request.
  *      message_router_response		pointer to Message Router Response.
@@ -263,121 +406,134 @@ EipStatus ForwardOpen(CipInstance *instance,
                       CipMessageRouterResponse *message_router_response) {
   EipUint16 connection_status = kConnectionManagerStatusCodeSuccess;
   ConnectionManagementHandling *connection_management_entry;
+  RequestContext *context = message_router_request->context;
+  CipCommonPacketFormatData *common_packet_format_data =
+      &context->common_packet_format_data;
+  ConnectionObject connection_object; /* the requested connection, the open
+   function copies it into its connection pool */
 
   (void) instance; /*suppress compiler warning */
 
+  memset(&connection_object, 0, sizeof(connection_object));
+  connection_object.originator_address = context->originator_address;
+  message_router_response->reply_service = (0x80
+      | message_router_request->service);
+
   /*first check if we have already a connection with the given params */
-  g_dummy_connection_object.priority_timetick = *message_router_request->data++;
-  g_dummy_connection_object.timeout_ticks = *message_router_request->data++;
+  connection_object.priority_timetick = *message_router_request->data++;
+  connection_object.timeout_ticks = *message_router_request->data++;
   /* O_to_T Conn ID */
-  g_dummy_connection_object.consumed_connection_id = GetDintFromMessage(
+  connection_object.consumed_connection_id = GetDintFromMessage(
       &message_router_request->data);
   /* T_to_O Conn ID */
-  g_dummy_connection_object.produced_connection_id = GetDintFromMessage(
+  connection_object.produced_connection_id = GetDintFromMessage(
       &message_router_request->data);
-  g_dummy_connection_object.connection_serial_number = GetIntFromMessage(
+  connection_object.connection_serial_number = GetIntFromMessage(
       &message_router_request->data);
-  g_dummy_connection_object.originator_vendor_id = GetIntFromMessage(
+  connection_object.originator_vendor_id = GetIntFromMessage(
       &message_router_request->data);
-  g_dummy_connection_object.originator_serial_number = GetDintFromMessage(
+  connection_object.originator_serial_number = GetDintFromMessage(
       &message_router_request->data);
 
-  if ((NULL != CheckForExistingConnection(&g_dummy_connection_object))) {
+  if ((NULL != CheckForExistingConnection(&connection_object))) {
     /* TODO this test is  incorrect, see CIP spec 3-5.5.2 re: duplicate forward open
      it should probably be testing the connection type fields
      TODO think on how a reconfiguration request could be handled correctly */
-    if ((0 == g_dummy_connection_object.consumed_connection_id)
-        && (0 == g_dummy_connection_object.produced_connection_id)) {
+    if ((0 == connection_object.consumed_connection_id)
+        && (0 == connection_object.produced_connection_id)) {
       /*TODO implement reconfiguration of connection*/
 
       OPENER_TRACE_ERR(
           "this looks like a duplicate forward open -- I can't handle this yet, sending a CIP_CON_MGR_ERROR_CONNECTION_IN_USE response\n");
     }
     return AssembleForwardOpenResponse(
-        &g_dummy_connection_object, message_router_response,
+        &connection_object, common_packet_format_data, message_router_response,
         kCipErrorConnectionFailure,
         kConnectionManagerStatusCodeErrorConnectionInUse);
   }
   /* keep it to none existent till the setup is done this eases error handling and
    * the state changes within the forward open request can not be detected from
    * the application or from outside (reason we are single threaded)*/
-  g_dummy_connection_object.state = kConnectionStateNonExistent;
-  g_dummy_connection_object.sequence_count_producing = 0; /* set the sequence count to zero */
+  connection_object.state = kConnectionStateNonExistent;
+  connection_object.sequence_count_producing = 0; /* set the sequence count to zero */
 
-  g_dummy_connection_object.connection_timeout_multiplier =
+  connection_object.connection_timeout_multiplier =
       *message_router_request->data++;
   message_router_request->data += 3; /* reserved */
-  /* the requested packet interval parameter needs to be a multiple of TIMERTICK from the header file */
   OPENER_TRACE_INFO(
       "ForwardOpen: ConConnID %"PRIu32", ProdConnID %"PRIu32", ConnSerNo %u\n",
-      g_dummy_connection_object.consumed_connection_id,
-      g_dummy_connection_object.produced_connection_id,
-      g_dummy_connection_object.connection_serial_number);
+      connection_object.consumed_connection_id,
+      connection_object.produced_connection_id,
+      connection_object.connection_serial_number);
 
-  g_dummy_connection_object.o_to_t_requested_packet_interval =
+  connection_object.o_to_t_requested_packet_interval =
       GetDintFromMessage(&message_router_request->data);
+  if (OPENER_MINIMUM_RPI > connection_object.o_to_t_requested_packet_interval) {
+    connection_object.o_to_t_requested_packet_interval = OPENER_MINIMUM_RPI;
+  }
 
-  g_dummy_connection_object.o_to_t_network_connection_parameter =
-      GetIntFromMessage(&message_router_request->data);
-  g_dummy_connection_object.t_to_o_requested_packet_interval =
+  connection_object.o_to_t_network_connection_parameter =
+      GetNetworkConnectionParameter(
+          message_router_request,
+          &connection_object.consumed_connection_size);
+  /* the connections are scheduled in microseconds, a shorter RPI than
+   * OPENER_MINIMUM_RPI would let the productions take all the CPU time */
+  connection_object.t_to_o_requested_packet_interval =
       GetDintFromMessage(&message_router_request->data);
-
-  EipUint32 temp = g_dummy_connection_object.t_to_o_requested_packet_interval
-      % (kOpenerTimerTickInMilliSeconds * 1000);
-  if (temp > 0) {
-    g_dummy_connection_object.t_to_o_requested_packet_interval =
-        (EipUint32) (g_dummy_connection_object.t_to_o_requested_packet_interval
-            / (kOpenerTimerTickInMilliSeconds * 1000))
-            * (kOpenerTimerTickInMilliSeconds * 1000)
-            + (kOpenerTimerTickInMilliSeconds * 1000);
+  if (OPENER_MINIMUM_RPI > connection_object.t_to_o_requested_packet_interval) {
+    connection_object.t_to_o_requested_packet_interval = OPENER_MINIMUM_RPI;
   }
 
-  g_dummy_connection_object.t_to_o_network_connection_parameter =
-      GetIntFromMessage(&message_router_request->data);
+  connection_object.t_to_o_network_connection_parameter =
+      GetNetworkConnectionParameter(
+          message_router_request,
+          &connection_object.produced_connection_size);
 
   /*check if Network connection parameters are ok */
   if (CIP_CONN_TYPE_MASK
-      == (g_dummy_connection_object.o_to_t_network_connection_parameter
+      == (connection_object.o_to_t_network_connection_parameter
           & CIP_CONN_TYPE_MASK)) {
     return AssembleForwardOpenResponse(
-        &g_dummy_connection_object, message_router_response,
+        &connection_object, common_packet_format_data, message_router_response,
         kCipErrorConnectionFailure,
         kConnectionManagerStatusCodeErrorInvalidOToTConnectionType);
   }
 
   if (CIP_CONN_TYPE_MASK
-      == (g_dummy_connection_object.t_to_o_network_connection_parameter
+      == (connection_object.t_to_o_network_connection_parameter
           & CIP_CONN_TYPE_MASK)) {
     return AssembleForwardOpenResponse(
-        &g_dummy_connection_object, message_router_response,
+        &connection_object, common_packet_format_data, message_router_response,
         kCipErrorConnectionFailure,
         kConnectionManagerStatusCodeErrorInvalidTToOConnectionType);
   }
 
-  g_dummy_connection_object.transport_type_class_trigger =
+  connection_object.transport_type_class_trigger =
       *message_router_request->data++;
   /*check if the trigger type value is ok */
-  if (0x40 & g_dummy_connection_object.transport_type_class_trigger) {
+  if (0x40 & connection_object.transport_type_class_trigger) {
     return AssembleForwardOpenResponse(
-        &g_dummy_connection_object, message_router_response,
+        &connection_object, common_packet_format_data, message_router_response,
         kCipErrorConnectionFailure,
         kConnectionManagerStatusCodeErrorTransportTriggerNotSupported);
   }
 
-  temp = ParseConnectionPath(&g_dummy_connection_object, message_router_request,
-                             &connection_status);
+  EipUint32 temp = ParseConnectionPath(&connection_object,
+                                       message_router_request,
+                                       &connection_status);
   if (kEipStatusOk != temp) {
-    return AssembleForwardOpenResponse(&g_dummy_connection_object,
+    return AssembleForwardOpenResponse(&connection_object,
+                                       common_packet_format_data,
                                        message_router_response, temp,
                                        connection_status);
   }
 
   /*parsing is now finished all data is available and check now establish the connection */
   connection_management_entry = GetConnMgmEntry(
-      g_dummy_connection_object.connection_path.class_id);
+      connection_object.connection_path.class_id);
   if (NULL != connection_management_entry) {
     temp = connection_management_entry->open_connection_function(
-        &g_dummy_connection_object, &connection_status);
+        &connection_object, context, &connection_status);
   } else {
     temp = kEipStatusError;
     connection_status =
@@ -386,14 +542,16 @@ EipStatus ForwardOpen(CipInstance *instance,
 
   if (kEipStatusOk != temp) {
     OPENER_TRACE_INFO("connection manager: connect failed\n");
-    /* in case of error the dummy objects holds all necessary information */
-    return AssembleForwardOpenResponse(&g_dummy_connection_object,
+    /* in case of error the requested connection holds all necessary information */
+    return AssembleForwardOpenResponse(&connection_object,
+                                       common_packet_format_data,
                                        message_router_response, temp,
                                        connection_status);
   } else {
     OPENER_TRACE_INFO("connection manager: connect succeeded\n");
     /* in case of success the g_pstActiveConnectionList points to the new connection */
     return AssembleForwardOpenResponse(g_active_connection_list,
+                                       common_packet_format_data,
                                        message_router_response,
                                        kCipErrorSuccess, 0);
   }
@@ -426,36 +584,19 @@ void GeneralConnectionConfiguration(ConnectionObject *connection_object) {
   connection_object->watchdog_timeout_action = kWatchdogTimeoutActionAutoDelete; /* the default for all connections on EIP*/
 
   connection_object->expected_packet_rate = 0; /* default value */
+  connection_object->missed_production_slots = 0;
 
   if ((connection_object->transport_type_class_trigger & 0x80) == 0x00) { /* Client Type Connection requested */
-    connection_object->expected_packet_rate = (EipUint16) ((connection_object
-        ->t_to_o_requested_packet_interval) / 1000);
-    /* As soon as we are ready we should produce the connection. With the 0 here we will produce with the next timer tick
-     * which should be sufficient. */
-    connection_object->transmission_trigger_timer = 0;
+    connection_object->expected_packet_rate = connection_object
+        ->t_to_o_requested_packet_interval;
   } else {
     /* Server Type Connection requested */
-    connection_object->expected_packet_rate = (EipUint16) ((connection_object
-        ->o_to_t_requested_packet_interval) / 1000);
+    connection_object->expected_packet_rate = connection_object
+        ->o_to_t_requested_packet_interval;
   }
 
-  connection_object->production_inhibit_timer = connection_object
-      ->production_inhibit_time = 0;
-
-  /*setup the preconsuption timer: max(ConnectionTimeoutMultiplier * EpectetedPacketRate, 10s) */
-  connection_object->inactivity_watchdog_timer =
-      ((((connection_object->o_to_t_requested_packet_interval) / 1000)
-          << (2 + connection_object->connection_timeout_multiplier)) > 10000) ?
-          (((connection_object->o_to_t_requested_packet_interval) / 1000)
-              << (2 + connection_object->connection_timeout_multiplier)) :
-          10000;
-
-  connection_object->consumed_connection_size = connection_object
-      ->o_to_t_network_connection_parameter & 0x01FF;
-
-  connection_object->produced_connection_size = connection_object
-      ->t_to_o_network_connection_parameter & 0x01FF;
-
+  connection_object->production_inhibit_time = 0;
+  /* the timers are started when the connection gets active */
 }
 
 EipStatus ForwardClose(CipInstance *instance,
@@ -469,9 +610,12 @@ EipStatus ForwardClose(CipInstance *instance,
       kConnectionManagerStatusCodeErrorConnectionNotFoundAtTargetApplication;
   ConnectionObject *connection_object = g_active_connection_list;
 
+  CipCommonPacketFormatData *common_packet_format_data =
+      &message_router_request->context->common_packet_format_data;
+
   /* set AddressInfo Items to invalid TypeID to prevent assembleLinearMsg to read them */
-  g_common_packet_format_data_item.address_info_item[0].type_id = 0;
-  g_common_packet_format_data_item.address_info_item[1].type_id = 0;
+  common_packet_format_data->address_info_item[0].type_id = 0;
+  common_packet_format_data->address_info_item[1].type_id = 0;
 
   message_router_request->data += 2; /* ignore Priority/Time_tick and Time-out_ticks */
 
@@ -506,6 +650,7 @@ EipStatus ForwardClose(CipInstance *instance,
   return AssembleForwardCloseResponse(connection_serial_number,
                                       originator_vendor_id,
                                       originator_serial_number,
+                                      common_packet_format_data,
                                       message_router_request,
                                       message_router_response,
                                       connection_status);
@@ -523,75 +668,383 @@ EipStatus GetConnectionOwner(CipInstance *instance,
   return kEipStatusOk;
 }
 
-EipStatus ManageConnections(MilliSeconds elapsed_time) {
-  EipStatus eip_status;
-  ConnectionObject *connection_object;
-
+EipStatus ManageConnections(MicroSeconds elapsed_time) {
   /*Inform application that it can execute */
   HandleApplication();
   ManageEncapsulationMessages(elapsed_time);
 
-  connection_object = g_active_connection_list;
-  while (NULL != connection_object) {
-    if (connection_object->state == kConnectionStateEstablished) {
-      if ((0 != connection_object->consuming_instance) || /* we have a consuming connection check inactivity watchdog timer */
-      (connection_object->transport_type_class_trigger & 0x80)) /* all sever connections have to maintain an inactivity watchdog timer */
-      {
-        connection_object->inactivity_watchdog_timer -=
-            elapsed_time;
-        if (connection_object->inactivity_watchdog_timer <= 0) {
-          /* we have a timed out connection perform watchdog time out action*/
-          OPENER_TRACE_INFO(">>>>>>>>>>Connection timed out\n");
-          OPENER_ASSERT(NULL != connection_object->connection_timeout_function);
-          connection_object->connection_timeout_function(connection_object);
-        }
-      }
-      /* only if the connection has not timed out check if data is to be send */
-      if (kConnectionStateEstablished == connection_object->state) {
-        /* client connection */
-        if ((connection_object->expected_packet_rate != 0)
-            && (kEipInvalidSocket
-                != connection_object->socket[kUdpCommuncationDirectionProducing])) /* only produce for the master connection */
-            {
-          if (kConnectionTriggerTypeCyclicConnection
-              != (connection_object->transport_type_class_trigger
-                  & kConnectionTriggerTypeProductionTriggerMask)) {
-            /* non cyclic connections have to decrement production inhibit timer */
-            if (0 <= connection_object->production_inhibit_timer) {
-              connection_object->production_inhibit_timer -=
-                  elapsed_time;
-            }
-          }
-          connection_object->transmission_trigger_timer -=
-              elapsed_time;
-          if (connection_object->transmission_trigger_timer <= 0) { /* need to send package */
-            OPENER_ASSERT(
-                NULL != connection_object->connection_send_data_function);
-            eip_status = connection_object->connection_send_data_function(
-                connection_object);
-            if (eip_status == kEipStatusError) {
-              OPENER_TRACE_ERR(
-                  "sending of UDP data in manage Connection failed\n");
-            }
-            /* reload the timer value */
-            connection_object->transmission_trigger_timer = connection_object
-                ->expected_packet_rate;
-            if (kConnectionTriggerTypeCyclicConnection
-                != (connection_object->transport_type_class_trigger
-                    & kConnectionTriggerTypeProductionTriggerMask)) {
-              /* non cyclic connections have to reload the production inhibit timer */
-              connection_object->production_inhibit_timer = connection_object
-                  ->production_inhibit_time;
-            }
-          }
+#ifdef OPENER_IO_THREAD
+  return kEipStatusOk; /* the I/O thread handles the connection timers */
+#else
+  return ManageConnectionTimers(elapsed_time);
+#endif
+}
+
+EipStatus ManageConnectionTimers(MicroSeconds elapsed_time) {
+  QueuedTimer *timer;
+
+  g_connection_manager_time += elapsed_time;
+  g_production_load.last = 0;
+
+  /* only the connections with expired timers are visited */
+  while (NULL
+      != (timer = TimerQueuePopDue(&g_connection_timers,
+                                   g_connection_manager_time))) {
+    ConnectionObject *connection_object = timer->data;
+    if (&connection_object->inactivity_watchdog_timer == timer) {
+      HandleInactivityWatchdogTimer(connection_object);
+    } else {
+      HandleTransmissionTriggerTimer(connection_object);
+    }
+  }
+
+  if (g_production_load.maximum < g_production_load.last) {
+    g_production_load.maximum = g_production_load.last;
+  }
+  g_production_load.histogram[
+      (g_production_load.last < OPENER_PRODUCTION_LOAD_HISTOGRAM_SIZE) ?
+          g_production_load.last : OPENER_PRODUCTION_LOAD_HISTOGRAM_SIZE - 1]++;
+  return kEipStatusOk;
+}
+
+void HandleInactivityWatchdogTimer(ConnectionObject *connection_object) {
+  /* the timers are only queued while the connection is active */
+  if (!((0 != connection_object->consuming_instance) || /* we have a consuming connection check inactivity watchdog timer */
+      (connection_object->transport_type_class_trigger & 0x80))) /* all sever connections have to maintain an inactivity watchdog timer */
+  {
+    return;
+  }
+
+  if (connection_object->inactivity_watchdog_time_out
+      > g_connection_manager_time) {
+    /* data has been received in the meantime */
+    ScheduleConnectionTimer(&connection_object->inactivity_watchdog_timer,
+                            connection_object->inactivity_watchdog_time_out);
+    return;
+  }
+
+  /* we have a timed out connection perform watchdog time out action*/
+  OPENER_TRACE_INFO(">>>>>>>>>>Connection timed out\n");
+#ifdef OPENER_IO_THREAD
+  /* closing connections is up to the explicit messaging thread */
+  if (kEipStatusOk
+      != RunInExplicitThread(HandleConnectionTimeOutTask, connection_object,
+                             connection_object->consumed_connection_id)) {
+    /* try again later */
+    ScheduleConnectionTimer(
+        &connection_object->inactivity_watchdog_timer,
+        g_connection_manager_time + kOpenerTimerTickInMilliSeconds * 1000ULL);
+  }
+#else
+  HandleConnectionTimeOutTask(connection_object,
+                              connection_object->consumed_connection_id);
+#endif
+}
+
+void HandleConnectionTimeOutTask(void *object, EipUint32 value) {
+  ConnectionObject *connection_object = object;
+  /* the connection may have been closed or even reused in the meantime */
+  if ((kConnectionStateEstablished != connection_object->state)
+      || (value != connection_object->consumed_connection_id)) {
+    return;
+  }
+#ifdef OPENER_IO_THREAD
+  /* a watchdog reset of this thread may still be queued for the I/O thread */
+  RunInIoThread(ConfirmConnectionTimeOutTask, connection_object, value, false);
+#else
+  OPENER_ASSERT(NULL != connection_object->connection_timeout_function);
+  connection_object->connection_timeout_function(connection_object);
+#endif
+}
+
+#ifdef OPENER_IO_THREAD
+void ConfirmConnectionTimeOutTask(void *object, EipUint32 value) {
+  ConnectionObject *connection_object = object;
+
+  if (IsTimerQueued(&connection_object->inactivity_watchdog_timer)) {
+    return; /* closed and activated again in the meantime */
+  }
+  if (connection_object->inactivity_watchdog_time_out
+      > g_connection_manager_time) {
+    /* refreshed after the watchdog expired, RestartInactivityWatchdog did
+     * not queue the timer */
+    ScheduleConnectionTimer(&connection_object->inactivity_watchdog_timer,
+                            connection_object->inactivity_watchdog_time_out);
+    return;
+  }
+  if (kEipStatusOk
+      != RunInExplicitThread(CloseTimedOutConnectionTask, connection_object,
+                             value)) {
+    /* try again later */
+    ScheduleConnectionTimer(
+        &connection_object->inactivity_watchdog_timer,
+        g_connection_manager_time + kOpenerTimerTickInMilliSeconds * 1000ULL);
+  }
+}
+
+void CloseTimedOutConnectionTask(void *object, EipUint32 value) {
+  ConnectionObject *connection_object = object;
+  if ((kConnectionStateEstablished != connection_object->state)
+      || (value != connection_object->consumed_connection_id)) {
+    return;
+  }
+  OPENER_ASSERT(NULL != connection_object->connection_timeout_function);
+  connection_object->connection_timeout_function(connection_object);
+}
+#endif
+
+void HandleTransmissionTriggerTimer(ConnectionObject *connection_object) {
+  /* only established connections produce, the timer is queued again when
+   * the connection is activated. Only produce for the master connection, a
+   * new master takes the production over with HandOverConnectionProduction */
+  if ((kConnectionStateEstablished != connection_object->state)
+      || (0 == connection_object->expected_packet_rate)
+      || (kEipInvalidSocket
+          == connection_object->socket[kUdpCommuncationDirectionProducing])) {
+    return;
+  }
+
+  OPENER_ASSERT(NULL != connection_object->connection_send_data_function);
+  EipStatus eip_status = connection_object->connection_send_data_function(
+      connection_object);
+  if (eip_status == kEipStatusError) {
+    OPENER_TRACE_ERR("sending of UDP data in manage Connection failed\n");
+  }
+  g_production_load.last++;
+  /* the next deadline follows the previous one, so that lateness of a single
+   * production does not shift the following ones */
+  uint64_t missed_slots = 0;
+  MicroSeconds next_due_time = GetNextPeriodicDueTime(
+      connection_object->transmission_trigger_timer.due_time,
+      connection_object->expected_packet_rate, g_connection_manager_time,
+      &missed_slots);
+  if (0 != missed_slots) {
+    /* deadlines passed already, they are skipped instead of producing a burst */
+    connection_object->missed_production_slots += missed_slots;
+    OPENER_TRACE_WARN("connection manager: %u production slot(s) missed\n",
+                      (unsigned int) missed_slots);
+  }
+  ScheduleConnectionTimer(&connection_object->transmission_trigger_timer,
+                          next_due_time);
+  if (kConnectionTriggerTypeCyclicConnection
+      != (connection_object->transport_type_class_trigger
+          & kConnectionTriggerTypeProductionTriggerMask)) {
+    /* non cyclic connections have to reload the production inhibit timer */
+    connection_object->production_inhibit_end_time = g_connection_manager_time
+        + connection_object->production_inhibit_time * 1000;
+  }
+}
+
+MicroSeconds GetTimeToNextConnectionEvent(void) {
+  QueuedTimer *next_timer = TimerQueuePeek(&g_connection_timers);
+  if (NULL == next_timer) {
+    return ULLONG_MAX;
+  }
+  return (next_timer->due_time > g_connection_manager_time) ?
+      next_timer->due_time - g_connection_manager_time : 0;
+}
+
+void ScheduleConnectionTimer(QueuedTimer *timer, MicroSeconds due_time) {
+  if (0 != TimerQueueSchedule(&g_connection_timers, timer, due_time)) {
+    OPENER_TRACE_ERR(
+        "connection manager: timer queue full, raise OPENER_CONNECTION_TIMER_QUEUE_SIZE\n");
+  }
+}
+
+MicroSeconds DetermineProductionPhase(
+    const ConnectionObject *connection_object) {
+  EipUint32 fraction = 0; /* of the RPI in units of 2^-32 */
+
+  switch (g_production_phase_policy) {
+    case kProductionPhasePolicyEvenSpread:
+      /* every new connection is placed into the largest gap left by the
+       * others */
+      fraction = GetSpreadFraction(g_number_of_spread_productions++);
+      break;
+    case kProductionPhasePolicyHash:
+      fraction = ((EipUint32) connection_object->connection_serial_number
+          ^ connection_object->originator_serial_number
+          ^ ((EipUint32) connection_object->originator_vendor_id << 16))
+          * 2654435761U;
+      break;
+    case kProductionPhasePolicyExplicitOffset:
+      for (int i = 0; i < OPENER_PRODUCTION_PHASE_OFFSETS; i++) {
+        if ((0 != g_production_phase_offsets[i].input_assembly_id)
+            && (g_production_phase_offsets[i].input_assembly_id
+                == connection_object->produced_connection_path.instance_number)) {
+          return g_production_phase_offsets[i].offset
+              % connection_object->expected_packet_rate;
         }
       }
+      break;
+    default:
+      break;
+  }
+  return GetFractionOfPeriod(fraction, connection_object->expected_packet_rate);
+}
+
+void ConfigureProductionPhasePolicy(ProductionPhasePolicy policy) {
+  g_production_phase_policy = policy;
+}
+
+EipStatus ConfigureProductionPhaseOffset(unsigned int input_assembly_id,
+                                         MicroSeconds offset) {
+  int free_entry = -1;
+  for (int i = 0; i < OPENER_PRODUCTION_PHASE_OFFSETS; i++) {
+    if (input_assembly_id == g_production_phase_offsets[i].input_assembly_id) {
+      g_production_phase_offsets[i].offset = offset;
+      return kEipStatusOk;
+    }
+    if ((-1 == free_entry)
+        && (0 == g_production_phase_offsets[i].input_assembly_id)) {
+      free_entry = i;
     }
-    connection_object = connection_object->next_connection_object;
   }
+  if (-1 == free_entry) {
+    return kEipStatusError;
+  }
+  g_production_phase_offsets[free_entry].input_assembly_id = input_assembly_id;
+  g_production_phase_offsets[free_entry].offset = offset;
   return kEipStatusOk;
 }
 
+const ProductionLoad *GetProductionLoad(void) {
+  return &g_production_load;
+}
+
+void RunConnectionTask(ThreadTask task, ConnectionObject *connection_object,
+                       EipBool8 wait) {
+#ifdef OPENER_IO_THREAD
+  RunInIoThread(task, connection_object, 0, wait);
+#else
+  (void) wait; /* kill unused parameter warning */
+  task(connection_object, 0);
+#endif
+}
+
+void ActivateConnectionTask(void *object, EipUint32 value) {
+  ConnectionObject *connection_object = object;
+  (void) value; /* kill unused parameter warning */
+
+  connection_object->production_inhibit_end_time = g_connection_manager_time;
+
+  /*setup the preconsuption timer: max(ConnectionTimeoutMultiplier * EpectetedPacketRate, 10s) */
+  connection_object->inactivity_watchdog_time_out = g_connection_manager_time
+      + (((((MicroSeconds) connection_object->o_to_t_requested_packet_interval)
+          << (2 + connection_object->connection_timeout_multiplier)) > 10000000) ?
+          (((MicroSeconds) connection_object->o_to_t_requested_packet_interval)
+              << (2 + connection_object->connection_timeout_multiplier)) :
+          10000000);
+  ScheduleConnectionTimer(&connection_object->inactivity_watchdog_timer,
+                          connection_object->inactivity_watchdog_time_out);
+
+  /* connections sharing a multicast production get the production handed
+   * over with HandOverConnectionProduction */
+  if ((0 != connection_object->expected_packet_rate)
+      && (kEipInvalidSocket
+          != connection_object->socket[kUdpCommuncationDirectionProducing])) {
+    ScheduleConnectionTimer(
+        &connection_object->transmission_trigger_timer,
+        g_connection_manager_time
+            + DetermineProductionPhase(connection_object));
+  }
+
+  ConnectionObject **bucket = GetConnectionIdIndexBucket(
+      connection_object->consumed_connection_id);
+  connection_object->next_in_connection_id_index = *bucket;
+  *bucket = connection_object;
+}
+
+void DeactivateConnectionTask(void *object, EipUint32 value) {
+  ConnectionObject *connection_object = object;
+  (void) value; /* kill unused parameter warning */
+
+  TimerQueueCancel(&g_connection_timers,
+                   &connection_object->inactivity_watchdog_timer);
+  TimerQueueCancel(&g_connection_timers,
+                   &connection_object->transmission_trigger_timer);
+
+  ConnectionObject **bucket = GetConnectionIdIndexBucket(
+      connection_object->consumed_connection_id);
+  while (NULL != *bucket) {
+    if (connection_object == *bucket) {
+      *bucket = connection_object->next_in_connection_id_index;
+      break;
+    }
+    bucket = &(*bucket)->next_in_connection_id_index;
+  }
+  connection_object->next_in_connection_id_index = NULL;
+}
+
+/** @brief The connections of a production hand over */
+typedef struct {
+  ConnectionObject *previous_producer;
+  ConnectionObject *next_producer;
+} ProductionHandOver;
+
+void HandOverConnectionProductionTask(void *object, EipUint32 value) {
+  ProductionHandOver *hand_over = object;
+  (void) value; /* kill unused parameter warning */
+
+  hand_over->next_producer->eip_level_sequence_count_producing = hand_over
+      ->previous_producer->eip_level_sequence_count_producing;
+  hand_over->next_producer->sequence_count_producing = hand_over
+      ->previous_producer->sequence_count_producing;
+  ScheduleConnectionTimer(
+      &hand_over->next_producer->transmission_trigger_timer,
+      hand_over->previous_producer->transmission_trigger_timer.due_time);
+  TimerQueueCancel(&g_connection_timers,
+                   &hand_over->previous_producer->transmission_trigger_timer);
+}
+
+void HandOverConnectionProduction(ConnectionObject *previous_producer,
+                                  ConnectionObject *next_producer) {
+  ProductionHandOver hand_over = { previous_producer, next_producer };
+#ifdef OPENER_IO_THREAD
+  RunInIoThread(HandOverConnectionProductionTask, &hand_over, 0, true);
+#else
+  HandOverConnectionProductionTask(&hand_over, 0);
+#endif
+}
+
+void TriggerConnectionProductionTask(void *object, EipUint32 value) {
+  ConnectionObject *connection_object = object;
+  (void) value; /* kill unused parameter warning */
+
+  /* produce at the next allowed occurrence */
+  if (IsTimerQueued(&connection_object->transmission_trigger_timer)) {
+    ScheduleConnectionTimer(
+        &connection_object->transmission_trigger_timer,
+        (connection_object->production_inhibit_end_time
+            > g_connection_manager_time) ?
+            connection_object->production_inhibit_end_time :
+            g_connection_manager_time);
+  }
+}
+
+void ResetInactivityWatchdogTask(void *object, EipUint32 value) {
+  (void) value; /* kill unused parameter warning */
+  RestartInactivityWatchdog(object);
+}
+
+void ResetInactivityWatchdogTimer(ConnectionObject *connection_object) {
+  RunConnectionTask(ResetInactivityWatchdogTask, connection_object, false);
+}
+
+void RestartInactivityWatchdog(ConnectionObject *connection_object) {
+  connection_object->inactivity_watchdog_time_out = g_connection_manager_time
+      + (((MicroSeconds) connection_object->o_to_t_requested_packet_interval)
+          << (2 + connection_object->connection_timeout_multiplier));
+  /* a later time out is handled lazily when the queued timer expires, only
+   * the first reset after the initial 10s time out moves the timer */
+  if (IsTimerQueued(&connection_object->inactivity_watchdog_timer)
+      && (connection_object->inactivity_watchdog_time_out
+          < connection_object->inactivity_watchdog_timer.due_time)) {
+    ScheduleConnectionTimer(&connection_object->inactivity_watchdog_timer,
+                            connection_object->inactivity_watchdog_time_out);
+  }
+}
+
 /* TODO: Update Documentation  INT8 assembleFWDOpenResponse(S_CIP_ConnectionObject *pa_pstConnObj, S_CIP_MR_Response * pa_MRResponse, EIP_UINT8 pa_nGeneralStatus, EIP_UINT16 pa_nExtendedStatus,
  void * deleteMeSomeday, EIP_UINT8 * pa_msg)
  *   create FWDOpen response dependent on status.
@@ -608,11 +1061,10 @@ EipStatus ManageConnections(MilliSeconds elapsed_time) {
  */
 EipStatus AssembleForwardOpenResponse(
     ConnectionObject *connection_object,
+    CipCommonPacketFormatData *cip_common_packet_format_data,
     CipMessageRouterResponse * message_router_response, EipUint8 general_status,
     EipUint16 extended_status) {
   /* write reply information in CPF struct dependent of pa_status */
-  CipCommonPacketFormatData *cip_common_packet_format_data =
-      &g_common_packet_format_data_item;
   EipByte *message = message_router_response->data;
   cip_common_packet_format_data->item_count = 2;
   cip_common_packet_format_data->data_item.type_id =
@@ -620,7 +1072,6 @@ EipStatus AssembleForwardOpenResponse(
 
   AddNullAddressItem(cip_common_packet_format_data);
 
-  message_router_response->reply_service = (0x80 | kForwardOpen);
   message_router_response->general_status = general_status;
 
   if (kCipErrorSuccess == general_status) {
@@ -730,12 +1181,11 @@ void AddNullAddressItem(
 EipStatus AssembleForwardCloseResponse(
     EipUint16 connection_serial_number, EipUint16 originatior_vendor_id,
     EipUint32 originator_serial_number,
+    CipCommonPacketFormatData *common_data_packet_format_data,
     CipMessageRouterRequest *message_router_request,
     CipMessageRouterResponse *message_router_response,
     EipUint16 extended_error_code) {
   /* write reply information in CPF struct dependent of pa_status */
-  CipCommonPacketFormatData *common_data_packet_format_data =
-      &g_common_packet_format_data_item;
   EipByte *message = message_router_response->data;
   common_data_packet_format_data->item_count = 2;
   common_data_packet_format_data->data_item.type_id =
@@ -769,18 +1219,21 @@ EipStatus AssembleForwardCloseResponse(
   return kEipStatusOkSend;
 }
 
+ConnectionObject **GetConnectionIdIndexBucket(EipUint32 connection_id) {
+  /* multiplicative hashing, target chosen IDs differ only in the low bits */
+  return &g_connection_id_index[((connection_id * 2654435761U) >> 16)
+      & (OPENER_CONNECTION_ID_INDEX_SIZE - 1)];
+}
+
 ConnectionObject* GetConnectedObject(EipUint32 connection_id) {
-  ConnectionObject* active_connection_object_list_item =
-      g_active_connection_list;
-  while (NULL != active_connection_object_list_item) {
-    if (active_connection_object_list_item->state
-        == kConnectionStateEstablished) {
-      if (active_connection_object_list_item->consumed_connection_id
-          == connection_id)
-        return active_connection_object_list_item;
-    }
-    active_connection_object_list_item = active_connection_object_list_item
-        ->next_connection_object;
+  ConnectionObject* connection_object = *GetConnectionIdIndexBucket(
+      connection_id);
+  /* the index holds the active connections, only established ones are found */
+  while (NULL != connection_object) {
+    if ((kConnectionStateEstablished == connection_object->state)
+        && (connection_object->consumed_connection_id == connection_id))
+      return connection_object;
+    connection_object = connection_object->next_in_connection_id_index;
   }
   return NULL;
 }
@@ -905,17 +1358,21 @@ EipUint8 ParseConnectionPath(ConnectionObject *connection_object,
   int originator_to_target_connection_type;
   int target_to_originator_connection_type;
 
+  int header_length =
+      (kLargeForwardOpen == message_router_request->service) ?
+          g_kLargeForwardOpenHeaderLength : g_kForwardOpenHeaderLength;
+
   /* with 256 we mark that we haven't got a PIT segment */
   connection_object->production_inhibit_time = 256;
 
-  if ((g_kForwardOpenHeaderLength + remaining_path_size * 2)
+  if ((header_length + remaining_path_size * 2)
       < message_router_request->data_length) {
     /* the received packet is larger than the data in the path */
     *extended_error = 0;
     return kCipErrorTooMuchData;
   }
 
-  if ((g_kForwardOpenHeaderLength + remaining_path_size * 2)
+  if ((header_length + remaining_path_size * 2)
       > message_router_request->data_length) {
     /*there is not enough data in received packet */
     *extended_error = 0;
@@ -1170,6 +1627,10 @@ void AddNewActiveConnection(ConnectionObject *pa_pstConn) {
   }
   g_active_connection_list = pa_pstConn;
   g_active_connection_list->state = kConnectionStateEstablished;
+
+  pa_pstConn->inactivity_watchdog_timer.data = pa_pstConn;
+  pa_pstConn->transmission_trigger_timer.data = pa_pstConn;
+  RunConnectionTask(ActivateConnectionTask, pa_pstConn, true);
 }
 
 void RemoveFromActiveConnections(ConnectionObject *pa_pstConn) {
@@ -1186,6 +1647,9 @@ void RemoveFromActiveConnections(ConnectionObject *pa_pstConn) {
   pa_pstConn->first_connection_object = NULL;
   pa_pstConn->next_connection_object = NULL;
   pa_pstConn->state = kConnectionStateNonExistent;
+
+  /* the connection object may be reused as soon as the timers are stopped */
+  RunConnectionTask(DeactivateConnectionTask, pa_pstConn, true);
 }
 
 EipBool8 IsConnectedOutputAssembly(EipUint32 pa_nInstanceNr) {
@@ -1250,13 +1714,12 @@ EipStatus TriggerConnections(unsigned int pa_unOutputAssembly,
       if (kConnectionTriggerTypeApplicationTriggeredConnection
           == (pstRunner->transport_type_class_trigger
               & kConnectionTriggerTypeProductionTriggerMask)) {
-        /* produce at the next allowed occurrence */
-        pstRunner->transmission_trigger_timer = pstRunner
-            ->production_inhibit_timer;
+        RunConnectionTask(TriggerConnectionProductionTask, pstRunner, false);
         nRetVal = kEipStatusOk;
       }
       break;
     }
+    pstRunner = pstRunner->next_connection_object;
   }
   return nRetVal;
 }
@@ -1264,6 +1727,13 @@ EipStatus TriggerConnections(unsigned int pa_unOutputAssembly,
 void InitializeConnectionManagerData() {
   memset(g_astConnMgmList, 0,
          g_kNumberOfConnectableObjects * sizeof(ConnectionManagementHandling));
+  memset(g_connection_id_index, 0, sizeof(g_connection_id_index));
+  TimerQueueInit(&g_connection_timers, g_connection_timer_storage,
+                 OPENER_CONNECTION_TIMER_QUEUE_SIZE);
+  g_production_phase_policy = kProductionPhasePolicyEvenSpread;
+  g_number_of_spread_productions = 0;
+  memset(g_production_phase_offsets, 0, sizeof(g_production_phase_offsets));
+  memset(&g_production_load, 0, sizeof(g_production_load));
   InitializeClass3ConnectionData();
   InitializeIoConnectionData();
 }
@@ -10,6 +10,7 @@
 #include "opener_api.h"
 #include "typedefs.h"
 #include "ciptypes.h"
+#include "timerqueue.h"
 
 /**
  * @brief Sets the routing type of a connection, either
@@ -72,6 +73,12 @@ typedef enum {
 #define SEQ_LEQ16(a, b) ((short)((a) - (b)) <= 0)
 #define SEQ_GEQ16(a, b) ((short)((a) - (b)) >= 0)
 
+/** @brief Maximum length of the CPF items and headers in front of the
+ * produced data: item count, sequenced address item, data item header, class
+ * 1 sequence count and run/idle header
+ */
+#define MAX_SIZE_OF_PRODUCED_FRAME_HEADER (2 + 12 + 4 + 2 + 4)
+
 /** @brief States of a connection */
 typedef enum {
   kConnectionStateNonExistent = 0,
@@ -133,7 +140,7 @@ typedef struct connection_object {
   EipByte device_net_initial_comm_characteristcs;
   EipUint16 produced_connection_size;
   EipUint16 consumed_connection_size;
-  EipUint16 expected_packet_rate;
+  EipUint32 expected_packet_rate; /**< in microseconds */
 
   /*conditional*/
   EipUint32 produced_connection_id;
@@ -155,9 +162,11 @@ typedef struct connection_object {
   EipUint32 originator_serial_number;
   EipUint16 connection_timeout_multiplier;
   EipUint32 o_to_t_requested_packet_interval;
-  EipUint16 o_to_t_network_connection_parameter;
+  EipUint16 o_to_t_network_connection_parameter; /**< in the layout of the
+   forward open, the size is kept in consumed_connection_size */
   EipUint32 t_to_o_requested_packet_interval;
-  EipUint16 t_to_o_network_connection_parameter;
+  EipUint16 t_to_o_network_connection_parameter; /**< in the layout of the
+   forward open, the size is kept in produced_connection_size */
   EipByte transport_type_class_trigger;
   EipUint8 connection_path_size;
   CipElectronicKey electronic_key;
@@ -186,18 +195,43 @@ typedef struct connection_object {
   EipUint16 sequence_count_consuming; /* sequence Count for Class 1 Producing
    Connections */
 
-  EipInt32 transmission_trigger_timer;
-  EipInt32 inactivity_watchdog_timer;
+  /** @brief Header of the productions in front of the produced data, built
+   * when the connection is opened. A production only fills in the sequence
+   * numbers and the run/idle header, the produced data is sent straight from
+   * the assembly.
+   */
+  EipUint8 produced_frame_header[MAX_SIZE_OF_PRODUCED_FRAME_HEADER];
+  EipUint16 produced_data_offset; /**< offset of the data of the connected
+   data item in produced_frame_header */
+
+  /** @brief Due time of the next production. Productions are scheduled
+   * against absolute deadlines, the next one is due one expected packet rate
+   * after the previous deadline.
+   */
+  QueuedTimer transmission_trigger_timer;
+
+  /** @brief Number of production deadlines which passed without a production
+   * because the device was too late
+   */
+  EipUint32 missed_production_slots;
+
+  /** @brief Check of the inactivity watchdog. Received data only advances
+   * inactivity_watchdog_time_out, the timer is moved there when it expires.
+   */
+  QueuedTimer inactivity_watchdog_timer;
+
+  /** @brief Time at which the connection times out if no data is received */
+  MicroSeconds inactivity_watchdog_time_out;
 
   /** @brief Minimal time between the production of two application triggered
    * or change of state triggered I/O connection messages
    */
   EipUint16 production_inhibit_time;
 
-  /** @brief Timer for the production inhibition of application triggered or
+  /** @brief End of the production inhibition of application triggered or
    * change-of-state I/O connections.
    */
-  EipInt32 production_inhibit_timer;
+  MicroSeconds production_inhibit_end_time;
 
   struct sockaddr_in remote_address; /* socket address for produce */
   struct sockaddr_in originator_address; /* the address of the originator that
@@ -216,6 +250,9 @@ typedef struct connection_object {
   struct connection_object *next_connection_object;
   struct connection_object *first_connection_object;
 
+  /** next connection in the same bucket of the connection ID index */
+  struct connection_object *next_in_connection_id_index;
+
   EipUint16 correct_originator_to_target_size;
   EipUint16 correct_target_to_originator_size;
 } ConnectionObject;
@@ -284,4 +321,23 @@ void AddNewActiveConnection(ConnectionObject *connection_object);
 /* TODO: Missing documentation */
 void RemoveFromActiveConnections(ConnectionObject *connection_object);
 
+/** @brief Restarts the inactivity watchdog of the connection after data has
+ * been received
+ *
+ * @param connection_object pointer to the connection object which received data
+ */
+void ResetInactivityWatchdogTimer(ConnectionObject *connection_object);
+
+/** @brief Hands the production of a multicast connection over to another
+ * connection
+ *
+ * The next connection continues the sequence counts and the production
+ * schedule of the previous one. The producing socket and address have to be
+ * handed over by the caller.
+ * @param previous_producer pointer to the connection producing so far
+ * @param next_producer pointer to the connection producing from now on
+ */
+void HandOverConnectionProduction(ConnectionObject *previous_producer,
+                                  ConnectionObject *next_producer);
+
 #endif /* OPENER_CIPCONNECTIONMANAGER_H_ */
@@ -59,6 +59,14 @@ void SetDeviceStatus(EipUint16 status) {
   status_ = status;
 }
 
+static EipStatus Reset(CipInstance *instance,
+                       CipMessageRouterRequest *message_router_request,
+                       CipMessageRouterResponse *message_router_response);
+
+/* the class, generated from cipidentity.cipdict.cmake, refers to the
+ * attributes above and to Reset */
+#include "cipidentity_dictionary.h"
+
 /** Reset service
  *
  * @param instance
@@ -119,36 +127,8 @@ static EipStatus Reset(CipInstance *instance, /* pointer to instance*/
  * @returns EIP_ERROR if the class could not be created, otherwise EIP_OK
  */
 EipStatus CipIdentityInit() {
-  CipClass *class;
-  CipInstance *instance;
-
-  class = CreateCipClass(kIdentityClassCode, 0, /* # of non-default class attributes */
-                         MASK4(1, 2, 6, 7), /* class getAttributeAll mask		CIP spec 5-2.3.2 */
-                         0, /* # of class services*/
-                         7, /* # of instance attributes*/
-                         MASK7(1, 2, 3, 4, 5, 6, 7), /* instance getAttributeAll mask	CIP spec 5-2.3.2 */
-                         1, /* # of instance services*/
-                         1, /* # of instances*/
-                         "identity", /* class name (for debug)*/
-                         1); /* class revision*/
-
-  if (class == 0)
-    return kEipStatusError;
-
-  instance = GetCipInstance(class, 1);
-
-  InsertAttribute(instance, 1, kCipUint, &vendor_id_, kGetableSingleAndAll);
-  InsertAttribute(instance, 2, kCipUint, &device_type_, kGetableSingleAndAll);
-  InsertAttribute(instance, 3, kCipUint, &product_code_, kGetableSingleAndAll);
-  InsertAttribute(instance, 4, kCipUsintUsint, &revision_,
-                  kGetableSingleAndAll);
-  InsertAttribute(instance, 5, kCipWord, &status_, kGetableSingleAndAll);
-  InsertAttribute(instance, 6, kCipUdint, &serial_number_,
-                  kGetableSingleAndAll);
-  InsertAttribute(instance, 7, kCipShortString, &product_name_,
-                  kGetableSingleAndAll);
-
-  InsertService(class, kReset, &Reset, "Reset");
-
-  return kEipStatusOk;
+  /* the identity object is fixed, its tables are generated at build time */
+  OPENER_ASSERT(
+      kIdentityClassCode == (int) g_identity_dictionary_class.class_id);
+  return RegisterStaticCipClass(&g_identity_dictionary_class);
 }
@@ -0,0 +1,19 @@
+#######################################
+# Static dictionary of the Identity   #
+# object, see cipidentity.c           #
+#######################################
+cip_dictionary_class( identity CLASS_ID 0x01 REVISION 1
+                      CLASS_GET_ALL 1 2 6 7           # CIP spec 5-2.3.2
+                      INSTANCE_GET_ALL 1 2 3 4 5 6 7  # CIP spec 5-2.3.2
+                    )
+
+cip_dictionary_service( INSTANCE kReset Reset )
+
+cip_dictionary_instance( 1 )
+cip_dictionary_attribute( 1 kCipUint &vendor_id_ kGetableSingleAndAll )
+cip_dictionary_attribute( 2 kCipUint &device_type_ kGetableSingleAndAll )
+cip_dictionary_attribute( 3 kCipUint &product_code_ kGetableSingleAndAll )
+cip_dictionary_attribute( 4 kCipUsintUsint &revision_ kGetableSingleAndAll )
+cip_dictionary_attribute( 5 kCipWord &status_ kGetableSingleAndAll )
+cip_dictionary_attribute( 6 kCipUdint &serial_number_ kGetableSingleAndAll )
+cip_dictionary_attribute( 7 kCipShortString &product_name_ kGetableSingleAndAll )
@@ -27,9 +27,6 @@ typedef enum {
   PointToPoint = 2 /**< Connection is a point to point connection */
 } CommunicationEndpointCardinality;
 
-/*The port to be used per default for I/O messages on UDP.*/
-const int kOpenerEipIoUdpPort = 0x08AE;
-
 /* producing multicast connection have to consider the rules that apply for
  * application connection types.
  */
@@ -67,6 +64,10 @@ void HandleIoConnectionTimeOut(ConnectionObject *connection_object);
  */
 EipStatus SendConnectedData(ConnectionObject *connection_object);
 
+EipUint16 GetProducedDataLength(const ConnectionObject *connection_object);
+
+void BuildProducedFrame(ConnectionObject *connection_object);
+
 EipStatus HandleReceivedIoConnectionData(ConnectionObject *connection_object,
                                          EipUint8 *data, EipUint16 data_length);
 
@@ -76,9 +77,19 @@ unsigned int g_config_data_length = 0;
 
 EipUint32 g_run_idle_state; /**< buffer for holding the run idle information. */
 
+/** Position of the sequence number of the sequenced address item in the
+ * produced frame */
+const size_t kProducedFrameSequenceNumberOffset = 2 + 4 + 4;
+
+/** Largest consumed connection size fitting into the UDP receive buffers
+ * behind the item count, the sequenced address item and the data item header */
+const EipUint16 kMaximumConsumedConnectionSize = PC_OPENER_UDP_BUFFER_SIZE
+    - (2 + 12 + 4);
+
 /**** Implementation ****/
 EipStatus EstablishIoConnction(ConnectionObject *connection_object,
-                         EipUint16 *extended_error) {
+                               RequestContext *context,
+                               EipUint16 *extended_error) {
   int originator_to_target_connection_type,
       target_to_originator_connection_type;
   EipStatus eip_status = kEipStatusOk;
@@ -188,6 +199,15 @@ EipStatus EstablishIoConnction(ConnectionObject *connection_object,
               kConnectionManagerStatusCodeErrorInvalidOToTConnectionSize;
           return kCipErrorConnectionFailure;
         }
+        if (kMaximumConsumedConnectionSize
+            < io_connection_object->consumed_connection_size) {
+          /* the consumed data would not fit into the receive buffers */
+          connection_object->correct_originator_to_target_size =
+              kMaximumConsumedConnectionSize;
+          *extended_error =
+              kConnectionManagerStatusCodeErrorInvalidOToTConnectionSize;
+          return kCipErrorConnectionFailure;
+        }
       } else {
         *extended_error =
             kConnectionManagerStatusCodeInvalidConsumingApllicationPath;
@@ -251,11 +271,15 @@ EipStatus EstablishIoConnction(ConnectionObject *connection_object,
       }
     }
 
-    eip_status = OpenCommunicationChannels(io_connection_object);
+    eip_status = OpenCommunicationChannels(io_connection_object, context);
     if (kEipStatusOk != eip_status) {
       *extended_error = 0; /*TODO find out the correct extended error code*/
       return eip_status;
     }
+
+    if (NULL != io_connection_object->producing_instance) {
+      BuildProducedFrame(io_connection_object);
+    }
   }
 
   AddNewActiveConnection(io_connection_object);
@@ -291,7 +315,8 @@ EipStatus OpenConsumingPointToPointConnection(
   /*addr.in_port = htons(nUDPPort++);*/
   addr.sin_port = htons(kOpenerEipIoUdpPort);
 
-  socket = CreateUdpSocket(kUdpCommuncationDirectionConsuming, &addr); /* the address is only needed for bind used if consuming */
+  socket = CreateUdpSocket(kUdpCommuncationDirectionConsuming, &addr,
+                           &connection_object->originator_address); /* the address is only needed for bind used if consuming */
   if (socket == kEipInvalidSocket) {
     OPENER_TRACE_ERR(
         "cannot create UDP socket in OpenPointToPointConnection\n");
@@ -337,7 +362,8 @@ EipStatus OpenProducingPointToPointConnection(
   connection_object->remote_address.sin_port = port;
 
   socket = CreateUdpSocket(kUdpCommuncationDirectionProducing,
-                           &connection_object->remote_address); /* the address is only needed for bind used if consuming */
+                           &connection_object->remote_address,
+                           &connection_object->originator_address); /* the address is only needed for bind used if consuming */
   if (socket == kEipInvalidSocket) {
     OPENER_TRACE_ERR(
         "cannot create UDP socket in OpenPointToPointConnection\n");
@@ -369,10 +395,9 @@ EipStatus OpenProducingMulticastConnection(
   /* we have a connection reuse the data and the socket */
 
   j = 0; /* allocate an unused sockaddr struct to use */
-  if (g_common_packet_format_data_item.address_info_item[0].type_id == 0) { /* it is not used yet */
+  if (common_packet_format_data->address_info_item[0].type_id == 0) { /* it is not used yet */
     j = 0;
-  } else if (g_common_packet_format_data_item.address_info_item[1].type_id
-      == 0) {
+  } else if (common_packet_format_data->address_info_item[1].type_id == 0) {
     j = 1;
   }
 
@@ -420,7 +445,7 @@ EipStatus OpenMulticastConnection(
   int socket;
 
 
-  if (0 != g_common_packet_format_data_item.address_info_item[0].type_id) {
+  if (0 != common_packet_format_data->address_info_item[0].type_id) {
     if ((kUdpCommuncationDirectionConsuming == direction)
         && (kCipItemIdSocketAddressInfoOriginatorToTarget
             == common_packet_format_data->address_info_item[0].type_id)) {
@@ -429,7 +454,7 @@ EipStatus OpenMulticastConnection(
     } else {
       j = 1;
       /* if the type is not zero (not used) or if a given type it has to be the correct one */
-      if ((0 != g_common_packet_format_data_item.address_info_item[1].type_id)
+      if ((0 != common_packet_format_data->address_info_item[1].type_id)
           && (!((kUdpCommuncationDirectionConsuming == direction)
               && (kCipItemIdSocketAddressInfoOriginatorToTarget
                   == common_packet_format_data->address_info_item[0].type_id)))) {
@@ -466,7 +491,8 @@ EipStatus OpenMulticastConnection(
   socket_address.sin_port = common_packet_format_data->address_info_item[j]
       .sin_port;
 
-  socket = CreateUdpSocket(direction, &socket_address); /* the address is only needed for bind used if consuming */
+  socket = CreateUdpSocket(direction, &socket_address,
+                           &connection_object->originator_address); /* the address is only needed for bind used if consuming */
   if (socket == kEipInvalidSocket) {
     OPENER_TRACE_ERR("cannot create UDP socket in OpenMulticastConnection\n");
     return kEipStatusError;
@@ -545,14 +571,10 @@ void CloseIoConnection(ConnectionObject *connection_object) {
         memcpy(&(next_non_control_master_connection->remote_address),
                &(connection_object->remote_address),
                sizeof(next_non_control_master_connection->remote_address));
-        next_non_control_master_connection->eip_level_sequence_count_producing =
-            connection_object->eip_level_sequence_count_producing;
-        next_non_control_master_connection->sequence_count_producing =
-            connection_object->sequence_count_producing;
         connection_object->socket[kUdpCommuncationDirectionProducing] =
             kEipInvalidSocket;
-        next_non_control_master_connection->transmission_trigger_timer =
-            connection_object->transmission_trigger_timer;
+        HandOverConnectionProduction(connection_object,
+                                     next_non_control_master_connection);
       } else { /* this was the last master connection close all listen only connections listening on the port */
         CloseAllConnectionsForInputWithSameType(
             connection_object->connection_path.connection_point[1],
@@ -594,8 +616,8 @@ void HandleIoConnectionTimeOut(ConnectionObject *connection_object) {
                 connection_object->socket[kUdpCommuncationDirectionProducing];
             connection_object->socket[kUdpCommuncationDirectionProducing] =
                 kEipInvalidSocket;
-            next_non_control_master_connection->transmission_trigger_timer =
-                connection_object->transmission_trigger_timer;
+            HandOverConnectionProduction(connection_object,
+                                         next_non_control_master_connection);
           } else { /* this was the last master connection close all listen only connections listening on the port */
             CloseAllConnectionsForInputWithSameType(
                 connection_object->connection_path.connection_point[1],
@@ -612,37 +634,74 @@ void HandleIoConnectionTimeOut(ConnectionObject *connection_object) {
   connection_object->connection_close_function(connection_object);
 }
 
-EipStatus SendConnectedData(ConnectionObject *connection_object) {
-  CipCommonPacketFormatData *common_packet_format_data;
-  EipUint16 reply_length;
-  EipUint8 *message_data_reply_buffer;
-
-  /* TODO think of adding an own send buffer to each connection object in order to preset up the whole message on connection opening and just change the variable data items e.g., sequence number */
+/** @brief Length of the connected data item of the productions: the class 1
+ * sequence count, the run/idle header and the produced data */
+EipUint16 GetProducedDataLength(const ConnectionObject *connection_object) {
+  CipByteArray *producing_instance_attributes =
+      (CipByteArray *) connection_object->producing_instance->attributes->data;
+  EipUint16 data_length = producing_instance_attributes->length;
 
-  common_packet_format_data = &g_common_packet_format_data_item; /* TODO think on adding a CPF data item to the S_CIP_ConnectionObject in order to remove the code here or even better allocate memory in the connection object for storing the message to send and just change the application data*/
+  if (kOpenerProducedDataHasRunIdleHeader) {
+    data_length += 4;
+  }
+  if ((connection_object->transport_type_class_trigger & 0x0F) == 1) {
+    data_length += 2;
+  }
+  return data_length;
+}
 
-  connection_object->eip_level_sequence_count_producing++;
+/** @brief Assembles the CPF items of the productions into the frame header
+ * of the connection, the produced connection ID has to be set
+ *
+ * @param connection_object the producing I/O connection
+ */
+void BuildProducedFrame(ConnectionObject *connection_object) {
+  CipCommonPacketFormatData common_packet_format_data;
 
-  /* assembleCPFData */
-  common_packet_format_data->item_count = 2;
+  common_packet_format_data.item_count = 2;
   if ((connection_object->transport_type_class_trigger & 0x0F) != 0) { /* use Sequenced Address Items if not Connection Class 0 */
-    common_packet_format_data->address_item.type_id = kCipItemIdSequencedAddressItem;
-    common_packet_format_data->address_item.length = 8;
-    common_packet_format_data->address_item.data.sequence_number =
-        connection_object->eip_level_sequence_count_producing;
+    common_packet_format_data.address_item.type_id =
+        kCipItemIdSequencedAddressItem;
+    common_packet_format_data.address_item.length = 8;
+    common_packet_format_data.address_item.data.sequence_number = 0;
   } else {
-    common_packet_format_data->address_item.type_id = kCipItemIdConnectionAddress;
-    common_packet_format_data->address_item.length = 4;
-
+    common_packet_format_data.address_item.type_id =
+        kCipItemIdConnectionAddress;
+    common_packet_format_data.address_item.length = 4;
   }
-  common_packet_format_data->address_item.data.connection_identifier =
+  common_packet_format_data.address_item.data.connection_identifier =
       connection_object->produced_connection_id;
 
-  common_packet_format_data->data_item.type_id = kCipItemIdConnectedDataItem;
+  common_packet_format_data.data_item.type_id = kCipItemIdConnectedDataItem;
+  common_packet_format_data.data_item.length = 0;
+
+  /* set AddressInfo Items to invalid Type */
+  common_packet_format_data.address_info_item[0].type_id = 0;
+  common_packet_format_data.address_info_item[1].type_id = 0;
+
+  int header_length = AssembleIOMessage(
+      &common_packet_format_data, connection_object->produced_frame_header);
+
+  /* the data item length is fixed, only the data changes */
+  EipUint8 *data_length_field =
+      &connection_object->produced_frame_header[header_length - 2];
+  AddIntToMessage(GetProducedDataLength(connection_object), &data_length_field);
+
+  connection_object->produced_data_offset = header_length;
+}
 
+EipStatus SendConnectedData(ConnectionObject *connection_object) {
+  EipUint8 *message;
   CipByteArray *producing_instance_attributes =
       (CipByteArray *) connection_object->producing_instance->attributes->data;
-  common_packet_format_data->data_item.length = 0;
+
+  connection_object->eip_level_sequence_count_producing++;
+  if ((connection_object->transport_type_class_trigger & 0x0F) != 0) { /* Sequenced Address Item */
+    message = &connection_object
+        ->produced_frame_header[kProducedFrameSequenceNumberOffset];
+    AddDintToMessage(connection_object->eip_level_sequence_count_producing,
+                     &message);
+  }
 
   /* notify the application that data will be sent immediately after the call */
   if (BeforeAssemblyDataSend(connection_object->producing_instance)) {
@@ -650,44 +709,24 @@ EipStatus SendConnectedData(ConnectionObject *connection_object) {
     connection_object->sequence_count_producing++;
   }
 
-  /* set AddressInfo Items to invalid Type */
-  common_packet_format_data->address_info_item[0].type_id = 0;
-  common_packet_format_data->address_info_item[1].type_id = 0;
-
-  reply_length = AssembleIOMessage(common_packet_format_data,
-                                   &g_message_data_reply_buffer[0]);
-
-  message_data_reply_buffer = &g_message_data_reply_buffer[reply_length - 2];
-  common_packet_format_data->data_item.length = producing_instance_attributes
-      ->length;
-  if (kOpenerProducedDataHasRunIdleHeader) {
-    common_packet_format_data->data_item.length += 4;
-  }
-
+  message = &connection_object
+      ->produced_frame_header[connection_object->produced_data_offset];
   if ((connection_object->transport_type_class_trigger & 0x0F) == 1) {
-    common_packet_format_data->data_item.length += 2;
-    AddIntToMessage(common_packet_format_data->data_item.length,
-                    &message_data_reply_buffer);
-    AddIntToMessage(connection_object->sequence_count_producing,
-                    &message_data_reply_buffer);
-  } else {
-    AddIntToMessage(common_packet_format_data->data_item.length,
-                    &message_data_reply_buffer);
+    AddIntToMessage(connection_object->sequence_count_producing, &message);
   }
 
   if (kOpenerProducedDataHasRunIdleHeader) {
-    AddDintToMessage(g_run_idle_state, &(message_data_reply_buffer));
+    AddDintToMessage(g_run_idle_state, &message);
   }
 
-  memcpy(message_data_reply_buffer, producing_instance_attributes->data,
-         producing_instance_attributes->length);
-
-  reply_length += common_packet_format_data->data_item.length;
-
-  return SendUdpData(
+  /* the produced data is sent from the assembly's buffer */
+  return SendUdpDataGathered(
       &connection_object->remote_address,
       connection_object->socket[kUdpCommuncationDirectionProducing],
-      &g_message_data_reply_buffer[0], reply_length);
+      connection_object->produced_frame_header,
+      message - connection_object->produced_frame_header,
+      producing_instance_attributes->data,
+      producing_instance_attributes->length);
 }
 
 EipStatus HandleReceivedIoConnectionData(ConnectionObject *connection_object,
@@ -723,12 +762,12 @@ EipStatus HandleReceivedIoConnectionData(ConnectionObject *connection_object,
   return kEipStatusOk;
 }
 
-EipStatus OpenCommunicationChannels(ConnectionObject *connection_object) {
+EipStatus OpenCommunicationChannels(ConnectionObject *connection_object,
+                                    RequestContext *context) {
 
   EipStatus eip_status = kEipStatusOk;
-  /*get pointer to the CPF data, currently we have just one global instance of the struct. This may change in the future*/
   CipCommonPacketFormatData *common_packet_format_data =
-      &g_common_packet_format_data_item;
+      &context->common_packet_format_data;
 
   CommunicationEndpointCardinality originator_to_target_connection_type = (connection_object
       ->o_to_t_network_connection_parameter & 0x6000) >> 13;
@@ -42,28 +42,37 @@
 
 #include "opener_api.h"
 #include "cipconnectionmanager.h"
+#include "cpf.h"
+
+/** @brief The port to be used per default for I/O messages on UDP */
+static const int kOpenerEipIoUdpPort = 0x08AE;
 
 /** @brief Setup all data in order to establish an IO connection
  *
  * This function can be called after all data has been parsed from the forward open request
  * @param connection_object pointer to the connection object structure holding the parsed data from the forward open request
+ * @param context the Forward Open request
  * @param extended_error the extended error code in case an error happened
  * @return general status on the establishment
  *    - EIP_OK ... on success
  *    - On an error the general status code to be put into the response
  */
 EipStatus EstablishIoConnction(ConnectionObject *connection_object,
-                         EipUint16 *extended_error);
+                               RequestContext *context,
+                               EipUint16 *extended_error);
 
 /** @brief Take the data given in the connection object structure and open the necessary communication channels
  *
- * This function will use the g_stCPFDataItem!
+ * The socket address info items of the request's CPF data are replaced by the
+ * ones of the reply.
  * @param connection_object pointer to the connection object data
+ * @param context the Forward Open request
  * @return general status on the open process
  *    - EIP_OK ... on success
  *    - On an error the general status code to be put into the response
  */
-EipStatus OpenCommunicationChannels(ConnectionObject *connection_object);
+EipStatus OpenCommunicationChannels(ConnectionObject *connection_object,
+                                    RequestContext *context);
 
 /** @brief close the communication channels of the given connection and remove it
  * from the active connections list.
@@ -3,6 +3,8 @@
  * All rights reserved. 
  *
  ******************************************************************************/
+#include <string.h>
+
 #include "opener_api.h"
 #include "cipcommon.h"
 #include "cipmessagerouter.h"
@@ -10,8 +12,18 @@
 #include "ciperror.h"
 #include "trace.h"
 
-CipMessageRouterRequest g_message_router_request;
-CipMessageRouterResponse g_message_router_response;
+#ifndef OPENER_CLASS_REGISTRY_TABLE_SIZE
+/** @brief Class IDs below this limit are looked up in a table indexed by the
+ * class ID, this covers the standard objects and the vendor specific range
+ * 0x64 - 0xC7 */
+#define OPENER_CLASS_REGISTRY_TABLE_SIZE 0x100
+#endif
+
+#ifndef OPENER_CLASS_REGISTRY_HASH_SIZE
+/** @brief Number of buckets of the hash finding the classes with larger class
+ * IDs, has to be a power of two */
+#define OPENER_CLASS_REGISTRY_HASH_SIZE 16
+#endif
 
 /** @brief A class registry list node
  *
@@ -19,15 +31,44 @@ CipMessageRouterResponse g_message_router_response;
  * for small devices with very limited memory it could make sense to change this list into an
  * array with a given max size for removing the need for having to dynamically allocate 
  * memory. The size of the array could be a parameter in the platform config file.
+ *
+ * The list keeps the registration order, the classes are found through
+ * g_class_table and g_class_hash.
  */
 typedef struct cip_message_router_object {
   struct cip_message_router_object *next; /*< link */
+  struct cip_message_router_object *next_in_bucket; /*< link of the hash bucket */
   CipClass *cip_class; /*< object */
 } CipMessageRouterObject;
 
 /** @brief Pointer to first registered object in MessageRouter*/
 CipMessageRouterObject *g_first_object = 0;
 
+/** @brief Pointer to the last registered object, new classes are appended
+ * behind it */
+CipMessageRouterObject *g_last_object = 0;
+
+/** @brief Registered classes with class IDs below
+ * OPENER_CLASS_REGISTRY_TABLE_SIZE indexed by their class ID */
+CipMessageRouterObject *g_class_table[OPENER_CLASS_REGISTRY_TABLE_SIZE];
+
+/** @brief Registered classes with larger class IDs hashed by their class ID,
+ * each bucket is linked by next_in_bucket */
+CipMessageRouterObject *g_class_hash[OPENER_CLASS_REGISTRY_HASH_SIZE];
+
+/** @brief Returns the slot of the class registry holding the class with the
+ * given ID, a bucket of g_class_hash for class IDs beyond g_class_table
+ *
+ *  @param class_id Class code to be looked up
+ *  @return Pointer to the table entry or to the head of the bucket
+ */
+static CipMessageRouterObject **GetClassRegistrySlot(EipUint32 class_id) {
+  if (OPENER_CLASS_REGISTRY_TABLE_SIZE > class_id) {
+    return &g_class_table[class_id];
+  }
+  return &g_class_hash[class_id & (OPENER_CLASS_REGISTRY_HASH_SIZE - 1)];
+}
+
 /** @brief Register an Class to the message router
  *  @param cip_class Pointer to a class object to be registered.
  *  @return status      0 .. success
@@ -48,6 +89,37 @@ CipError CreateMessageRouterRequestStructure(
     EipUint8 *data, EipInt16 data_length,
     CipMessageRouterRequest *message_router_request);
 
+/** @brief Parses a request and passes it to the class it addresses
+ *
+ * The request's context has to be set, the response data has to point to the
+ * place where the response data is to be encoded.
+ *
+ *  @param data the request starting with the service code
+ *  @param data_length number of bytes of the request
+ *  @param message_router_request the request structure to be filled
+ *  @param message_router_response the response of the addressed class or the
+ *  error response of the message router
+ *  @return the return value of the service, kEipStatusOkSend for error
+ *  responses
+ */
+EipStatus RouteMessageRouterRequest(
+    EipUint8 *data, int data_length,
+    CipMessageRouterRequest *message_router_request,
+    CipMessageRouterResponse *message_router_response);
+
+/** @brief Multiple Service Packet service of the message router
+ *
+ * Passes every embedded request to the class it addresses and packs the
+ * replies into one response: the number of replies, their offsets and the
+ * replies. The embedded services reply into a scratch buffer, the response
+ * fails with kCipErrorReplyDataTooLarge if the replies exceed the capacity of
+ * the response. An embedded Multiple Service Packet is answered with
+ * kCipErrorServiceNotSupported.
+ */
+EipStatus MultipleServicePacket(
+    CipInstance *instance, CipMessageRouterRequest *message_router_request,
+    CipMessageRouterResponse *message_router_response);
+
 EipStatus CipMessageRouterInit() {
   CipClass *message_router;
 
@@ -57,16 +129,15 @@ EipStatus CipMessageRouterInit() {
                                   0, /* # of class services*/
                                   0, /* # of instance attributes*/
                                   0xffffffff, /* instance getAttributeAll mask*/
-                                  0, /* # of instance services*/
+                                  1, /* # of instance services*/
                                   1, /* # of instances*/
                                   "message router", /* class name*/
                                   1); /* revision */
   if (message_router == 0)
     return kEipStatusError;
 
-  /* reserved for future use -> set to zero */
-  g_message_router_response.reserved = 0;
-  g_message_router_response.data = g_message_data_reply_buffer; /* set reply buffer, using a fixed buffer (about 100 bytes) */
+  InsertService(message_router, kMultipleServicePacket, &MultipleServicePacket,
+                "MultipleServicePacket");
 
   return kEipStatusOk;
 }
@@ -79,14 +150,17 @@ EipStatus CipMessageRouterInit() {
  *      0 .. Class not registered
  */
 CipMessageRouterObject *GetRegisteredObject(EipUint32 class_id) {
-  CipMessageRouterObject *object = g_first_object; /* get pointer to head of class registration list */
+  CipMessageRouterObject *object = *GetClassRegistrySlot(class_id);
 
-  while (NULL != object) /* for each entry in list*/
+  if (OPENER_CLASS_REGISTRY_TABLE_SIZE > class_id) {
+    return object;
+  }
+  while (NULL != object) /* for each entry in the bucket*/
   {
     OPENER_ASSERT(object->cip_class != NULL);
     if (object->cip_class->class_id == class_id)
       return object; /* return registration node if it matches class ID*/
-    object = object->next;
+    object = object->next_in_bucket;
   }
   return 0;
 }
@@ -101,81 +175,117 @@ CipClass *GetCipClass(EipUint32 class_id) {
 }
 
 CipInstance *GetCipInstance(CipClass *cip_class, EipUint32 instance_number) {
-  CipInstance *instance; /* pointer to linked list of instances from the class object*/
+  CipInstance **index = cip_class->instance_index; /* the instances sorted by their number */
+  EipUint32 low = 0;
+  EipUint32 high = cip_class->instance_index_length;
 
   if (instance_number == 0)
     return (CipInstance *) cip_class; /* if the instance number is zero, return the class object itself*/
 
-  for (instance = cip_class->instances; instance; instance = instance->next) /* follow the list*/
+  /* instances numbered consecutively from 1 are found at their position */
+  if ((instance_number <= high)
+      && (index[instance_number - 1]->instance_number == instance_number))
+    return index[instance_number - 1];
+
+  while (low < high) /* binary search for sparse instance numbers */
   {
-    if (instance->instance_number == instance_number)
-      return instance; /* if the number matches, return the instance*/
+    EipUint32 middle = low + (high - low) / 2;
+    if (index[middle]->instance_number == instance_number)
+      return index[middle]; /* if the number matches, return the instance*/
+    if (index[middle]->instance_number < instance_number)
+      low = middle + 1;
+    else
+      high = middle;
   }
 
   return NULL;
 }
 
 EipStatus RegisterCipClass(CipClass *cip_class) {
-  CipMessageRouterObject **message_router_object = &g_first_object;
+  CipMessageRouterObject *message_router_object =
+      (CipMessageRouterObject *) CipCalloc(1, sizeof(CipMessageRouterObject)); /* create a new node for the end of the list*/
+  if (message_router_object == 0)
+    return kEipStatusError; /* check for memory error*/
 
-  while (*message_router_object)
-    message_router_object = &(*message_router_object)->next; /* follow the list until p points to an empty link (list end)*/
+  message_router_object->cip_class = cip_class; /* fill in the new node*/
+  message_router_object->next = NULL;
 
-  *message_router_object = (CipMessageRouterObject *) CipCalloc(
-      1, sizeof(CipMessageRouterObject)); /* create a new node at the end of the list*/
-  if (*message_router_object == 0)
-    return kEipStatusError; /* check for memory error*/
+  if (NULL == g_last_object) {
+    g_first_object = message_router_object;
+  } else {
+    g_last_object->next = message_router_object;
+  }
+  g_last_object = message_router_object;
 
-  (*message_router_object)->cip_class = cip_class; /* fill in the new node*/
-  (*message_router_object)->next = NULL;
+  /* a class registered twice keeps being found with its first registration */
+  if (NULL == GetRegisteredObject(cip_class->class_id)) {
+    CipMessageRouterObject **slot = GetClassRegistrySlot(cip_class->class_id);
+    message_router_object->next_in_bucket = *slot;
+    *slot = message_router_object;
+  }
 
   return kEipStatusOk;
 }
 
-EipStatus NotifyMR(EipUint8 *data, int data_length) {
-  EipStatus eip_status = kEipStatusOkSend;
-  EipByte nStatus;
+EipStatus RegisterStaticCipClass(const CipClass *cip_class) {
+  OPENER_ASSERT(cip_class->is_static);
+  /* the tables are read-only, the message router only reads them */
+  return RegisterCipClass((CipClass *) cip_class);
+}
 
-  g_message_router_response.data = g_message_data_reply_buffer; /* set reply buffer, using a fixed buffer (about 100 bytes) */
+EipStatus NotifyMR(RequestContext *context, EipUint8 *data, int data_length) {
+  context->message_router_request.context = context;
 
   OPENER_TRACE_INFO("notifyMR: routing unconnected message\n");
+  return RouteMessageRouterRequest(data, data_length,
+                                   &context->message_router_request,
+                                   &context->message_router_response);
+}
+
+EipStatus RouteMessageRouterRequest(
+    EipUint8 *data, int data_length,
+    CipMessageRouterRequest *message_router_request,
+    CipMessageRouterResponse *message_router_response) {
+  EipStatus eip_status = kEipStatusOkSend;
+  EipByte nStatus;
+
   if (kCipErrorSuccess
       != (nStatus = CreateMessageRouterRequestStructure(
-          data, data_length, &g_message_router_request))) { /* error from create MR structure*/
+          data, data_length, message_router_request))) { /* error from create MR structure*/
     OPENER_TRACE_ERR("notifyMR: error from createMRRequeststructure\n");
-    g_message_router_response.general_status = nStatus;
-    g_message_router_response.size_of_additional_status = 0;
-    g_message_router_response.reserved = 0;
-    g_message_router_response.data_length = 0;
-    g_message_router_response.reply_service = (0x80
-        | g_message_router_request.service);
+    message_router_response->general_status = nStatus;
+    message_router_response->size_of_additional_status = 0;
+    message_router_response->reserved = 0;
+    message_router_response->data_length = 0;
+    message_router_response->reply_service = (0x80
+        | message_router_request->service);
   } else {
     /* forward request to appropriate Object if it is registered*/
     CipMessageRouterObject *registered_object;
 
     registered_object = GetRegisteredObject(
-        g_message_router_request.request_path.class_id);
+        message_router_request->request_path.class_id);
     if (registered_object == 0) {
       OPENER_TRACE_ERR(
           "notifyMR: sending CIP_ERROR_OBJECT_DOES_NOT_EXIST reply, class id 0x%x is not registered\n",
-          (unsigned ) g_message_router_request.request_path.class_id);
-      g_message_router_response.general_status =
+          (unsigned ) message_router_request->request_path.class_id);
+      message_router_response->general_status =
           kCipErrorPathDestinationUnknown; /*according to the test tool this should be the correct error flag instead of CIP_ERROR_OBJECT_DOES_NOT_EXIST;*/
-      g_message_router_response.size_of_additional_status = 0;
-      g_message_router_response.reserved = 0;
-      g_message_router_response.data_length = 0;
-      g_message_router_response.reply_service = (0x80
-          | g_message_router_request.service);
+      message_router_response->size_of_additional_status = 0;
+      message_router_response->reserved = 0;
+      message_router_response->data_length = 0;
+      message_router_response->reply_service = (0x80
+          | message_router_request->service);
     } else {
       /* call notify function from Object with ClassID (gMRRequest.RequestPath.ClassID)
-       object will or will not make an reply into gMRResponse*/
-      g_message_router_response.reserved = 0;
+       object will or will not make an reply into the response*/
+      message_router_response->reserved = 0;
       OPENER_ASSERT(NULL != registered_object->cip_class);
       OPENER_TRACE_INFO("notifyMR: calling notify function of class '%s'\n",
                         registered_object->cip_class->class_name);
       eip_status = NotifyClass(registered_object->cip_class,
-                               &g_message_router_request,
-                               &g_message_router_response);
+                               message_router_request,
+                               message_router_response);
 
 #ifdef OPENER_TRACE_ENABLED
       if (eip_status == kEipStatusError) {
@@ -197,6 +307,114 @@ EipStatus NotifyMR(EipUint8 *data, int data_length) {
   return eip_status;
 }
 
+EipStatus MultipleServicePacket(
+    CipInstance *instance, CipMessageRouterRequest *message_router_request,
+    CipMessageRouterResponse *message_router_response) {
+  RequestContext *context = message_router_request->context;
+  EipUint8 *request = message_router_request->data; /* offsets count from here */
+  EipUint8 *message = request;
+  EipUint8 *reply = message_router_response->data;
+  EipUint8 *reply_end = reply + message_router_response->data_capacity;
+  EipUint8 *next_reply;
+  EipUint8 reply_data[PC_OPENER_ETHERNET_BUFFER_SIZE]; /* the embedded services reply in here */
+  CipMessageRouterRequest embedded_request;
+  CipMessageRouterResponse embedded_response;
+  int number_of_services;
+  int i, j;
+
+  (void) instance; /*suppress compiler warning */
+
+  message_router_response->reply_service = (0x80
+      | message_router_request->service);
+  message_router_response->general_status = kCipErrorSuccess;
+  message_router_response->size_of_additional_status = 0;
+  message_router_response->reserved = 0;
+  message_router_response->data_length = 0;
+
+  if (2 > message_router_request->data_length) {
+    message_router_response->general_status = kCipErrorNotEnoughData;
+    return kEipStatusOkSend;
+  }
+  number_of_services = GetIntFromMessage(&message);
+  if (2 + 2 * number_of_services > message_router_request->data_length) {
+    message_router_response->general_status = kCipErrorNotEnoughData;
+    return kEipStatusOkSend;
+  }
+
+  next_reply = reply + 2 + 2 * number_of_services; /* behind the offsets */
+  if (next_reply > reply_end) {
+    message_router_response->general_status = kCipErrorReplyDataTooLarge;
+    return kEipStatusOkSend;
+  }
+  message = reply;
+  AddIntToMessage(number_of_services, &message);
+
+  for (i = 0; i < number_of_services; i++) {
+    EipUint8 *offset = request + 2 + 2 * i;
+    int start = GetIntFromMessage(&offset);
+    int end =
+        (i + 1 < number_of_services) ?
+            GetIntFromMessage(&offset) : message_router_request->data_length;
+
+    if ((start < 2 + 2 * number_of_services) || (start >= end)
+        || (end > message_router_request->data_length)) {
+      OPENER_TRACE_WARN("multiple service packet: invalid offset of request %d\n",
+                        i);
+      message_router_response->general_status = kCipErrorInvalidParameter;
+      return kEipStatusOkSend;
+    }
+
+    embedded_request.context = context;
+    embedded_response.data = reply_data;
+    /* the data may take what is left of the reply behind a reply header
+     * without additional status */
+    embedded_response.data_capacity = reply_end - next_reply - 4;
+    if (embedded_response.data_capacity > (EipInt16) sizeof(reply_data)) {
+      embedded_response.data_capacity = sizeof(reply_data);
+    }
+    embedded_response.reply_service = (0x80 | request[start]);
+    embedded_response.general_status = kCipErrorSuccess;
+    embedded_response.data_length = 0;
+    embedded_response.size_of_additional_status = 0;
+    if (kMultipleServicePacket == request[start]) {
+      /* nesting is refused, every level would take a reply_data buffer from
+       * the stack */
+      embedded_response.general_status = kCipErrorServiceNotSupported;
+    } else {
+      RouteMessageRouterRequest(request + start, end - start,
+                                &embedded_request, &embedded_response);
+    }
+
+    if (next_reply + 4 + 2 * embedded_response.size_of_additional_status
+        + embedded_response.data_length > reply_end) {
+      OPENER_TRACE_WARN("multiple service packet: reply %d does not fit\n", i);
+      message_router_response->general_status = kCipErrorReplyDataTooLarge;
+      return kEipStatusOkSend;
+    }
+
+    message = reply + 2 + 2 * i;
+    AddIntToMessage(next_reply - reply, &message); /* the offset of the reply */
+
+    message = next_reply;
+    *message++ = embedded_response.reply_service;
+    *message++ = 0; /* reserved */
+    *message++ = embedded_response.general_status;
+    *message++ = embedded_response.size_of_additional_status;
+    for (j = 0; j < embedded_response.size_of_additional_status; j++) {
+      AddIntToMessage(embedded_response.additional_status[j], &message);
+    }
+    memcpy(message, reply_data, embedded_response.data_length);
+    next_reply = message + embedded_response.data_length;
+
+    if (kCipErrorSuccess != embedded_response.general_status) {
+      message_router_response->general_status = kCipErrorEmbeddedServiceError;
+    }
+  }
+
+  message_router_response->data_length = next_reply - reply;
+  return kEipStatusOkSend;
+}
+
 CipError CreateMessageRouterRequestStructure(
     EipUint8 *data, EipInt16 data_length,
     CipMessageRouterRequest *message_router_request) {
@@ -230,6 +448,11 @@ void DeleteAllClasses(void) {
     message_router_object_to_delete = message_router_object;
     message_router_object = message_router_object->next;
 
+    if (message_router_object_to_delete->cip_class->is_static) { /* the tables of a generated dictionary are not allocated */
+      CipFree(message_router_object_to_delete);
+      continue;
+    }
+
     instance = message_router_object_to_delete->cip_class->instances;
     while (NULL != instance) {
       instance_to_delete = instance;
@@ -241,6 +464,12 @@ void DeleteAllClasses(void) {
       CipFree(instance_to_delete);
     }
 
+    CipFree(message_router_object_to_delete->cip_class->instance_index);
+    CipFree(message_router_object_to_delete->cip_class->attribute_slots);
+    CipFree(
+        message_router_object_to_delete->cip_class->m_stSuper.cip_class
+            ->attribute_slots);
+
     /*clear meta class data*/
     CipFree(
         message_router_object_to_delete->cip_class->m_stSuper.cip_class
@@ -256,4 +485,7 @@ void DeleteAllClasses(void) {
     CipFree(message_router_object_to_delete);
   }
   g_first_object = NULL;
+  g_last_object = NULL;
+  memset(g_class_table, 0, sizeof(g_class_table));
+  memset(g_class_hash, 0, sizeof(g_class_hash));
 }
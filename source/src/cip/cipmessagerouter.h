@@ -8,16 +8,10 @@
 
 #include "typedefs.h"
 #include "ciptypes.h"
+#include "cpf.h"
 
 static const int kCipMessageRouterClassCode = 0x02;
 
-/** @brief Structure for storing the Response generated by an explict message.
- * 
- *  This buffer will be used for storing the result. The response message will be generated
- *  by assembleLinearMsg. 
- */
-extern CipMessageRouterResponse g_message_router_response;
-
 /* public functions */
 
 /** @brief Initialize the data structures of the message router
@@ -31,14 +25,17 @@ void DeleteAllClasses(void);
 
 /** @brief Notify the MessageRouter that an explicit message (connected or unconnected)
  *  has been received. This function will be called from the encapsulation layer.
- *  The CPF structure is already parsed an can be accessed via the global variable:
- *  g_stCPFDataItem.
+ *  The CPF structure is already parsed and can be accessed via the context.
+ *  The response is stored in the message router response of the context, the
+ *  caller points its data to the place of the response data in the reply frame
+ *  and sets the data capacity to the room left in the frame.
+ *  @param context the request being handled
  *  @param data pointer to the data buffer of the message directly at the beginning of the CIP part.
  *  @param data_length number of bytes in the data buffer
  *  @return  EIP_ERROR on fault
  *           EIP_OK on success           
  */
-EipStatus NotifyMR(EipUint8 *data, int data_length);
+EipStatus NotifyMR(RequestContext *context, EipUint8 *data, int data_length);
 
 /*! Register a class at the message router.
  *  In order that the message router can deliver
@@ -50,4 +47,17 @@ EipStatus NotifyMR(EipUint8 *data, int data_length);
  */
 EipStatus RegisterCipClass(CipClass *object);
 
+/** @brief Register a class of a generated object dictionary at the message
+ * router.
+ *
+ * The class, its instances, attributes and services are const tables
+ * generated from a declarative description at build time, see
+ * opener_cip_dictionary in OpENer.cmake. They are neither extended by
+ * AddCipInstances, InsertAttribute and InsertService nor freed by
+ * DeleteAllClasses.
+ *  @param cip_class the generated class to be registered
+ *  @return kEipStatusOk on success
+ */
+EipStatus RegisterStaticCipClass(const CipClass *cip_class);
+
 #endif /* OPENER_CIPMESSAGEROUTER_H_ */
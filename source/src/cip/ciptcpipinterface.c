@@ -213,6 +213,11 @@ EipStatus GetAttributeSingleTcpIpInterface(
     message_router_response->general_status = kCipErrorSuccess;
     message_router_response->size_of_additional_status = 0;
 
+    if (8 > message_router_response->data_capacity) {
+      message_router_response->general_status = kCipErrorReplyDataTooLarge;
+      return status;
+    }
+
     message_router_response->data_length += EncodeData(
         kCipUsint, &(g_multicast_configuration.alloc_control), &message);
     message_router_response->data_length += EncodeData(
@@ -241,6 +246,7 @@ EipStatus GetAttributeAllTcpIpInterface(
     CipMessageRouterResponse *message_router_response) {
 
   EipUint8 *response = message_router_response->data; /* pointer into the reply */
+  EipInt16 data_capacity = message_router_response->data_capacity;
   CipAttributeStruct *attribute = instance->attributes;
 
   for (int j = 0; j < instance->cip_class->number_of_attributes; j++) /* for each instance attribute of this class */
@@ -252,16 +258,31 @@ EipStatus GetAttributeAllTcpIpInterface(
       message_router_request->request_path.attribute_number = attribute_number;
 
       if (8 == attribute_number) { /* insert 6 zeros for the required empty safety network number according to Table 5-3.10 */
+        if (6 > data_capacity - (message_router_response->data - response)) {
+          message_router_response->data = response;
+          message_router_response->data_length = 0;
+          message_router_response->general_status = kCipErrorReplyDataTooLarge;
+          return kEipStatusOkSend;
+        }
         memset(message_router_response->data, 0, 6);
         message_router_response->data += 6;
       }
 
+      message_router_response->data_capacity = data_capacity
+          - (message_router_response->data - response);
       if (kEipStatusOkSend
           != GetAttributeSingleTcpIpInterface(instance, message_router_request,
                                               message_router_response)) {
         message_router_response->data = response;
+        message_router_response->data_capacity = data_capacity;
         return kEipStatusError;
       }
+      if (kCipErrorSuccess != message_router_response->general_status) {
+        message_router_response->data = response;
+        message_router_response->data_capacity = data_capacity;
+        message_router_response->data_length = 0;
+        return kEipStatusOkSend;
+      }
       message_router_response->data += message_router_response->data_length;
     }
     attribute++;
@@ -269,6 +290,7 @@ EipStatus GetAttributeAllTcpIpInterface(
   message_router_response->data_length = message_router_response->data
       - response;
   message_router_response->data = response;
+  message_router_response->data_capacity = data_capacity;
 
   return kEipStatusOkSend;
 }
@@ -142,7 +142,8 @@ typedef enum {
   kForwardOpen = 0x54,
   kForwardClose = 0x4E,
   kUnconnectedSend = 0x52,
-  kGetConnectionOwner = 0x5A
+  kGetConnectionOwner = 0x5A,
+  kLargeForwardOpen = 0x5B
 /* End CIP object-specific services */
 } CIPServiceCode;
 
@@ -240,6 +241,8 @@ typedef struct {
    specified in CIP Specification, Volume 1*/
 } CipElectronicKey;
 
+struct request_context;
+
 /** @brief CIP Message Router Request
  *
  */
@@ -248,6 +251,9 @@ typedef struct {
   CipEpath request_path;
   EipInt16 data_length;
   CipOctet *data;
+  struct request_context *context; /**< the explicit request the message has
+   been received with, gives services access to the CPF items and the
+   originator */
 } CipMessageRouterRequest;
 
 #define MAX_SIZE_OF_ADD_STATUS 2 /* for now we support extended status codes up to 2 16bit values there is mostly only one 16bit value used */
@@ -269,6 +275,8 @@ typedef struct {
   EipInt16 data_length; /**< Supportative non-CIP variable, gives length of data segment */
   CipOctet *data; /**< Array of octet; Response data per object definition from
    request */
+  EipInt16 data_capacity; /**< Supportative non-CIP variable, number of bytes
+   available for the data segment */
 } CipMessageRouterResponse;
 
 typedef struct {
@@ -309,8 +317,22 @@ typedef struct cip_class {
    returned by getAttributeAll*/
   EipUint16 number_of_services; /**< number of services supported*/
   CipInstance *instances; /**< pointer to the list of instances*/
+  CipInstance *last_instance; /**< the instance added last, the end of the
+   list of instances */
+  CipInstance **instance_index; /**< the instances sorted by their instance
+   number, see GetCipInstance */
+  EipUint32 instance_index_length; /**< number of instances in the index */
+  EipUint32 instance_index_capacity; /**< number of allocated index entries */
+  EipUint16 *attribute_slots; /**< position + 1 of the attribute with the
+   given number in the attributes of the instances, 0 if not defined */
+  EipUint16 number_of_attribute_slots; /**< entries of attribute_slots */
   struct cip_service_struct *services; /**< pointer to the array of services*/
+  EipUint16 service_slots[256]; /**< position + 1 of the service with the
+   given code in services, 0 if not supported */
   char *class_name; /**< class name */
+  EipBool8 is_static; /**< the class is a const table of a generated object
+   dictionary, see RegisterStaticCipClass; its instances, attributes and
+   services are fixed */
 } CipClass;
 
 /** @ingroup CIP_API
@@ -20,30 +20,44 @@ const size_t item_data_type_id_field_length = 2; /**< The size of the item count
 
 const size_t sequenced_address_item_length = 8;
 
-CipCommonPacketFormatData g_common_packet_format_data_item; /**< CPF global data items */
-
-int NotifyCommonPacketFormat(EncapsulationData *receive_data,
+/** Offset of the message router response data in the reply buffer of an
+ * unconnected reply: interface handle and timeout, item count, null address
+ * item, data item header and message router response header */
+const size_t kUnconnectedReplyDataOffset = 6 + 2 + 4 + 4 + 4;
+/** Offset of the message router response data in the reply buffer of a
+ * connected reply, which has a connected address item and a sequence number */
+const size_t kConnectedReplyDataOffset = 6 + 2 + 8 + 4 + 2 + 4;
+
+int NotifyCommonPacketFormat(RequestContext *context,
+                             EncapsulationData *receive_data,
                              EipUint8 *reply_buffer) {
   int return_value = kEipStatusError;
+  CipCommonPacketFormatData *common_packet_format_data =
+      &context->common_packet_format_data;
 
   if ((return_value = CreateCommonPacketFormatStructure(
       receive_data->current_communication_buffer_position,
-      receive_data->data_length, &g_common_packet_format_data_item))
+      receive_data->data_length, common_packet_format_data))
       == kEipStatusError) {
     OPENER_TRACE_ERR("notifyCPF: error from createCPFstructure\n");
   } else {
     return_value = kEipStatusOk; /* In cases of errors we normally need to send an error response */
-    if (g_common_packet_format_data_item.address_item.type_id
+    if (common_packet_format_data->address_item.type_id
         == kCipItemIdNullAddress) /* check if NullAddressItem received, otherwise it is no unconnected message and should not be here*/
         { /* found null address item*/
-      if (g_common_packet_format_data_item.data_item.type_id
+      if (common_packet_format_data->data_item.type_id
           == kCipItemIdUnconnectedDataItem) { /* unconnected data item received*/
-        return_value = NotifyMR(
-            g_common_packet_format_data_item.data_item.data,
-            g_common_packet_format_data_item.data_item.length);
+        context->message_router_response.data = reply_buffer
+            + kUnconnectedReplyDataOffset;
+        context->message_router_response.data_capacity = context->reply_buffer
+            + sizeof(context->reply_buffer)
+            - context->message_router_response.data;
+        return_value = NotifyMR(context,
+                                common_packet_format_data->data_item.data,
+                                common_packet_format_data->data_item.length);
         if (return_value != kEipStatusError) {
           return_value = AssembleLinearMessage(
-              &g_message_router_response, &g_common_packet_format_data_item,
+              &context->message_router_response, common_packet_format_data,
               reply_buffer);
         }
       } else {
@@ -61,44 +75,47 @@ int NotifyCommonPacketFormat(EncapsulationData *receive_data,
   return return_value;
 }
 
-int NotifyConnectedCommonPacketFormat(EncapsulationData *received_data,
+int NotifyConnectedCommonPacketFormat(RequestContext *context,
+                                      EncapsulationData *received_data,
                                       EipUint8 *reply_buffer) {
+  CipCommonPacketFormatData *common_packet_format_data =
+      &context->common_packet_format_data;
 
   int return_value = CreateCommonPacketFormatStructure(
       received_data->current_communication_buffer_position,
-      received_data->data_length, &g_common_packet_format_data_item);
+      received_data->data_length, common_packet_format_data);
 
   if (kEipStatusError == return_value) {
     OPENER_TRACE_ERR("notifyConnectedCPF: error from createCPFstructure\n");
   } else {
     return_value = kEipStatusError; /* For connected explicit messages status always has to be 0*/
-    if (g_common_packet_format_data_item.address_item.type_id
+    if (common_packet_format_data->address_item.type_id
         == kCipItemIdConnectionAddress) /* check if ConnectedAddressItem received, otherwise it is no connected message and should not be here*/
         { /* ConnectedAddressItem item */
       ConnectionObject *connection_object = GetConnectedObject(
-          g_common_packet_format_data_item.address_item.data
-              .connection_identifier);
+          common_packet_format_data->address_item.data.connection_identifier);
       if (NULL != connection_object) {
-        /* reset the watchdog timer */
-        connection_object->inactivity_watchdog_timer = (connection_object
-            ->o_to_t_requested_packet_interval / 1000)
-            << (2 + connection_object->connection_timeout_multiplier);
+        ResetInactivityWatchdogTimer(connection_object);
 
         /*TODO check connection id  and sequence count    */
-        if (g_common_packet_format_data_item.data_item.type_id
+        if (common_packet_format_data->data_item.type_id
             == kCipItemIdConnectedDataItem) { /* connected data item received*/
-          EipUint8 *pnBuf = g_common_packet_format_data_item.data_item.data;
-          g_common_packet_format_data_item.address_item.data.sequence_number =
+          EipUint8 *pnBuf = common_packet_format_data->data_item.data;
+          common_packet_format_data->address_item.data.sequence_number =
               (EipUint32) GetIntFromMessage(&pnBuf);
+          context->message_router_response.data = reply_buffer
+              + kConnectedReplyDataOffset;
+          context->message_router_response.data_capacity =
+              context->reply_buffer + sizeof(context->reply_buffer)
+                  - context->message_router_response.data;
           return_value = NotifyMR(
-              pnBuf, g_common_packet_format_data_item.data_item.length - 2);
+              context, pnBuf, common_packet_format_data->data_item.length - 2);
 
           if (return_value != kEipStatusError) {
-            g_common_packet_format_data_item.address_item.data
-                .connection_identifier = connection_object
-                ->produced_connection_id;
+            common_packet_format_data->address_item.data.connection_identifier =
+                connection_object->produced_connection_id;
             return_value = AssembleLinearMessage(
-                &g_message_router_response, &g_common_packet_format_data_item,
+                &context->message_router_response, common_packet_format_data,
                 reply_buffer);
           }
         } else {
@@ -497,7 +514,29 @@ int EncodeUnconnectedDataItemLength(
 }
 
 /**
- * @brief Encodes the Message Router Response data
+ * @brief Moves the Message Router Response data to its place behind the
+ * response header
+ *
+ * The services encode the data in place, it only has to be moved if
+ * additional status words are sent in front of it. This has to be done before
+ * the header is encoded, which would overwrite the data otherwise.
+ *
+ * @param message_router_response Router Response message to be processed
+ * @param message Message frame position of the response header
+ */
+void PlaceMessageRouterResponseData(
+    CipMessageRouterResponse* message_router_response, EipUint8* message) {
+  EipUint8 *data = message + 4
+      + 2 * message_router_response->size_of_additional_status;
+  if (data != message_router_response->data) {
+    memmove(data, message_router_response->data,
+            message_router_response->data_length);
+  }
+}
+
+/**
+ * @brief Encodes the Message Router Response data, which has been placed by
+ * PlaceMessageRouterResponseData
  *
  * @param size Current size of the message buffer
  * @param message_router_response Router Response message to be processed
@@ -506,10 +545,8 @@ int EncodeUnconnectedDataItemLength(
 int EncodeMessageRouterResponseData(
     int size, CipMessageRouterResponse* message_router_response,
     EipUint8** message) {
-  for (int i = 0; i < message_router_response->data_length; i++) {
-    size += AddSintToMessage((message_router_response->data)[i], &*message);
-  }
-  return size;
+  *message += message_router_response->data_length;
+  return size + message_router_response->data_length;
 }
 
 /**
@@ -613,7 +650,7 @@ int AssembleLinearMessage(
         message_size = EncodeConnectedDataItemLength(message_router_response,
                                                      &message, message_size);
         message_size = EncodeSequenceNumber(message_size,
-                                            &g_common_packet_format_data_item,
+                                            common_packet_format_data_item,
                                             &message);
 
       } else { /* Unconnected Item */
@@ -623,6 +660,7 @@ int AssembleLinearMessage(
       }
 
       /* write message router response into linear memory */
+      PlaceMessageRouterResponseData(message_router_response, message);
       message_size = EncodeReplyService(message_size, &message,
                                         message_router_response);
       message_size = EncodeReservedFieldOfLengthByte(message_size, &message,
@@ -679,7 +717,6 @@ int AssembleLinearMessage(
 
 int AssembleIOMessage(CipCommonPacketFormatData *common_packet_format_data_item,
                       EipUint8 *message) {
-  return AssembleLinearMessage(0, common_packet_format_data_item,
-                               &g_message_data_reply_buffer[0]);
+  return AssembleLinearMessage(0, common_packet_format_data_item, message);
 }
 
@@ -9,6 +9,7 @@
 #include "typedefs.h"
 #include "ciptypes.h"
 #include "encap.h"
+#include "opener_user_conf.h"
 
 /** @ingroup ENCAP
  * @brief CPF is Common Packet Format
@@ -68,15 +69,38 @@ typedef struct {
   SocketAddressInfoItem address_info_item[2];
 } CipCommonPacketFormatData;
 
+/** @ingroup ENCAP
+ * @brief State of an explicit request while it is handled
+ *
+ * The thread receiving a request provides the context, usually on its stack,
+ * and hands it down to the encapsulation layer, the message router and the
+ * services. Nothing of a request is kept in global variables, so requests
+ * can be handled by several threads at the same time.
+ */
+typedef struct request_context {
+  int socket; /**< the TCP connection the request has been received on */
+  struct sockaddr_in originator_address; /**< the peer of the TCP connection */
+  CipCommonPacketFormatData common_packet_format_data; /**< the CPF items of the
+   request, the items of the reply are assembled in place */
+  CipMessageRouterRequest message_router_request;
+  CipMessageRouterResponse message_router_response; /**< the services encode
+   the response data directly into reply_buffer */
+  EipUint8 reply_buffer[PC_OPENER_ETHERNET_BUFFER_SIZE]; /**< the encapsulation
+   frame sent as reply */
+} RequestContext;
+
 /** @ingroup ENCAP
  * Parse the CPF data from a received unconnected explicit message and
  * hand the data on to the message router 
  *
+ * @param  context the request being handled
  * @param  received_data pointer to the encapsulation structure with the received message
- * @param  reply_buffer reply buffer
+ * @param  reply_buffer reply buffer, the services encode the response data
+ * directly into it behind the CPF items
  * @return number of bytes to be sent back. < 0 if nothing should be sent
  */
-int NotifyCommonPacketFormat(EncapsulationData *received_data,
+int NotifyCommonPacketFormat(RequestContext *context,
+                             EncapsulationData *received_data,
                              EipUint8 *reply_buffer);
 
 /** @ingroup ENCAP
@@ -84,11 +108,14 @@ int NotifyCommonPacketFormat(EncapsulationData *received_data,
  * the connection status, update any timers, and hand the data on to 
  * the message router 
  *
+ * @param  context the request being handled
  * @param  received_data pointer to the encapsulation structure with the received message
- * @param  reply_buffer reply buffer
+ * @param  reply_buffer reply buffer, the services encode the response data
+ * directly into it behind the CPF items
  * @return number of bytes to be sent back. < 0 if nothing should be sent
  */
-int NotifyConnectedCommonPacketFormat(EncapsulationData *received_data,
+int NotifyConnectedCommonPacketFormat(RequestContext *context,
+                                      EncapsulationData *received_data,
                                       EipUint8 *reply_buffer);
 
 /** @ingroup ENCAP
@@ -119,6 +146,7 @@ int AssembleIOMessage(
 
 /** @ingroup ENCAP
  * Copy data from MRResponse struct and CPFDataItem into linear memory in message for transmission over in encapsulation.
+ * Response data already encoded at its place in message is not copied.
  * @param  message_router_response	pointer to message router response which has to be aligned into linear memory.
  * @param  common_packet_format_data_item	pointer to CPF structure which has to be aligned into linear memory.
  * @param  message		pointer to linear memory.
@@ -130,11 +158,4 @@ int AssembleLinearMessage(
     CipCommonPacketFormatData *common_packet_format_data_item,
     EipUint8 *message);
 
-/** @ingroup ENCAP
- * @brief Data storage for the any CPF data
- * Currently we are single threaded and need only one CPF at the time.
- * For future extensions towards multithreading maybe more CPF data items may be necessary
- */
-extern CipCommonPacketFormatData g_common_packet_format_data_item;
-
 #endif /* OPENER_CPF_H_ */
@@ -70,7 +70,7 @@ typedef enum {
 
 /** @brief Delayed Encapsulation Message structure */
 typedef struct {
-  EipInt32 time_out; /**< time out in milli seconds */
+  QueuedTimer timer; /**< due time of the response in micro seconds */
   int socket; /**< associated socket */
   struct sockaddr_in receiver;
   EipByte message[ENCAP_MAX_DELAYED_ENCAP_MESSAGE_SIZE];
@@ -81,8 +81,21 @@ EncapsulationInterfaceInformation g_interface_information;
 
 int g_registered_sessions[OPENER_NUMBER_OF_SUPPORTED_SESSIONS];
 
+/** The slice of g_registered_sessions used by the calling thread */
+static OPENER_THREAD_LOCAL int g_first_session = 0;
+static OPENER_THREAD_LOCAL int g_end_of_sessions =
+    OPENER_NUMBER_OF_SUPPORTED_SESSIONS;
+
 DelayedEncapsulationMessage g_delayed_encapsulation_messages[ENCAP_NUMBER_OF_SUPPORTED_DELAYED_ENCAP_MESSAGES];
 
+/** Time of the encapsulation layer in micro seconds, advanced by
+ * ManageEncapsulationMessages */
+MicroSeconds g_encapsulation_time = 0;
+
+/** Pending delayed messages ordered by their due times */
+TimerQueue g_delayed_encapsulation_message_timers;
+QueuedTimer *g_delayed_encapsulation_message_timer_storage[ENCAP_NUMBER_OF_SUPPORTED_DELAYED_ENCAP_MESSAGES];
+
 /*** private functions ***/
 void HandleReceivedListServicesCommand(EncapsulationData *receive_data);
 
@@ -100,10 +113,11 @@ void HandleReceivedRegisterSessionCommand(int socket,
 EipStatus HandleReceivedUnregisterSessionCommand(
     EncapsulationData *receive_data);
 
-EipStatus HandleReceivedSendUnitDataCommand(EncapsulationData *receive_data);
+EipStatus HandleReceivedSendUnitDataCommand(RequestContext *context,
+                                            EncapsulationData *receive_data);
 
 EipStatus HandleReceivedSendRequestResponseDataCommand(
-    EncapsulationData *receive_data);
+    RequestContext *context, EncapsulationData *receive_data);
 
 int GetFreeSessionIndex(void);
 
@@ -136,7 +150,12 @@ void EncapsulationInit(void) {
 
   for (unsigned int i = 0; i < ENCAP_NUMBER_OF_SUPPORTED_DELAYED_ENCAP_MESSAGES; i++) {
     g_delayed_encapsulation_messages[i].socket = -1;
+    g_delayed_encapsulation_messages[i].timer.data =
+        &(g_delayed_encapsulation_messages[i]);
   }
+  TimerQueueInit(&g_delayed_encapsulation_message_timers,
+                 g_delayed_encapsulation_message_timer_storage,
+                 ENCAP_NUMBER_OF_SUPPORTED_DELAYED_ENCAP_MESSAGES);
 
   /*TODO make the interface information configurable*/
   /* initialize interface information */
@@ -148,7 +167,7 @@ void EncapsulationInit(void) {
   strcpy((char *) g_interface_information.name_of_service, "Communications");
 }
 
-int HandleReceivedExplictTcpData(int socket, EipUint8 *buffer,
+int HandleReceivedExplictTcpData(RequestContext *context, EipUint8 *buffer,
                                  unsigned int length, int *remaining_bytes) {
   EipStatus return_value = kEipStatusOk;
   EncapsulationData encapsulation_data;
@@ -157,6 +176,10 @@ int HandleReceivedExplictTcpData(int socket, EipUint8 *buffer,
   /* returns how many bytes are left after the encapsulated data*/
   *remaining_bytes = CreateEncapsulationStructure(buffer, length,
                                                   &encapsulation_data);
+  /* the request is decoded in place, the reply is assembled in the reply
+   * buffer behind a copy of the request's header */
+  memcpy(context->reply_buffer, buffer, ENCAPSULATION_HEADER_LENGTH);
+  encapsulation_data.communication_buffer_start = context->reply_buffer;
 
   if (kEncapsulationHeaderOptionsFlag == encapsulation_data.options) /*TODO generate appropriate error response*/
   {
@@ -185,7 +208,8 @@ int HandleReceivedExplictTcpData(int socket, EipUint8 *buffer,
           break;
 
         case (kEncapsulationCommandRegisterSession):
-          HandleReceivedRegisterSessionCommand(socket, &encapsulation_data);
+          HandleReceivedRegisterSessionCommand(context->socket,
+                                               &encapsulation_data);
           break;
 
         case (kEncapsulationCommandUnregisterSession):
@@ -195,11 +219,12 @@ int HandleReceivedExplictTcpData(int socket, EipUint8 *buffer,
 
         case (kEncapsulationCommandSendRequestReplyData):
           return_value = HandleReceivedSendRequestResponseDataCommand(
-              &encapsulation_data);
+              context, &encapsulation_data);
           break;
 
         case (kEncapsulationCommandSendUnitData):
-          return_value = HandleReceivedSendUnitDataCommand(&encapsulation_data);
+          return_value = HandleReceivedSendUnitDataCommand(context,
+                                                           &encapsulation_data);
           break;
 
         default:
@@ -292,8 +317,8 @@ int EncapsulateData(const EncapsulationData *const send_data) {
  *  @param receive_data pointer to structure with received data
  */
 void HandleReceivedListServicesCommand(EncapsulationData *receive_data) {
-  EipUint8 *communication_buffer = receive_data
-      ->current_communication_buffer_position;
+  EipUint8 *communication_buffer =
+      &receive_data->communication_buffer_start[ENCAPSULATION_HEADER_LENGTH];
 
   receive_data->data_length = g_interface_information.length + 2;
 
@@ -311,15 +336,15 @@ void HandleReceivedListServicesCommand(EncapsulationData *receive_data) {
 }
 
 void HandleReceivedListInterfacesCommand(EncapsulationData *receive_data) {
-  EipUint8 *communication_buffer = receive_data
-      ->current_communication_buffer_position;
+  EipUint8 *communication_buffer =
+      &receive_data->communication_buffer_start[ENCAPSULATION_HEADER_LENGTH];
   receive_data->data_length = 2;
   AddIntToMessage(0x0000, &communication_buffer); /* copy Interface data to msg for sending */
 }
 
 void HandleReceivedListIdentityCommandTcp(EncapsulationData * receive_data) {
   receive_data->data_length = EncapsulateListIdentyResponseMessage(
-      receive_data->current_communication_buffer_position);
+      &receive_data->communication_buffer_start[ENCAPSULATION_HEADER_LENGTH]);
 }
 
 void HandleReceivedListIdentityCommandUdp(int socket,
@@ -404,7 +429,11 @@ void DetermineDelayTime(EipByte *buffer_start,
   } else if (kListIdentityMinimumDelayTime > maximum_delay_time) { /* if maximum_delay_time is between 1 and 500ms set it to 500ms */
     maximum_delay_time = kListIdentityMinimumDelayTime;
   }
-  delayed_message_buffer->time_out = (maximum_delay_time * rand()) / RAND_MAX; /* Sets delay time between 0 and maximum_delay_time */
+  /* Sets delay time between 0 and maximum_delay_time */
+  TimerQueueSchedule(
+      &g_delayed_encapsulation_message_timers, &delayed_message_buffer->timer,
+      g_encapsulation_time
+          + ((EipInt64) maximum_delay_time * 1000 * rand()) / RAND_MAX);
 }
 
 /* @brief Check supported protocol, generate session handle, send replay back to originator.
@@ -424,7 +453,7 @@ void HandleReceivedRegisterSessionCommand(int socket,
   if ((0 < protocol_version) && (protocol_version <= kSupportedProtocolVersion)
       && (0 == nOptionFlag)) { /*Option field should be zero*/
     /* check if the socket has already a session open */
-    for (int i = 0; i < OPENER_NUMBER_OF_SUPPORTED_SESSIONS; ++i) {
+    for (int i = g_first_session; i < g_end_of_sessions; ++i) {
       if (g_registered_sessions[i] == socket) {
         /* the socket has already registered a session this is not allowed*/
         receive_data->session_handle = i + 1; /*return the already assigned session back, the cip spec is not clear about this needs to be tested*/
@@ -455,6 +484,11 @@ void HandleReceivedRegisterSessionCommand(int socket,
     receive_data->status = kEncapsulationProtocolUnsupportedProtocol;
   }
 
+  /* the reply repeats the protocol version and the options flags */
+  receive_data_buffer =
+      &receive_data->communication_buffer_start[ENCAPSULATION_HEADER_LENGTH];
+  AddIntToMessage(protocol_version, &receive_data_buffer);
+  AddIntToMessage(nOptionFlag, &receive_data_buffer);
   receive_data->data_length = 4;
 }
 
@@ -466,8 +500,8 @@ EipStatus HandleReceivedUnregisterSessionCommand(
     EncapsulationData *receive_data) {
   int i;
 
-  if ((0 < receive_data->session_handle)
-      && (receive_data->session_handle <= OPENER_NUMBER_OF_SUPPORTED_SESSIONS)) {
+  if ((g_first_session < receive_data->session_handle)
+      && (receive_data->session_handle <= g_end_of_sessions)) {
     i = receive_data->session_handle - 1;
     if (kEipInvalidSocket != g_registered_sessions[i]) {
       IApp_CloseSocket_tcp(g_registered_sessions[i]);
@@ -483,9 +517,11 @@ EipStatus HandleReceivedUnregisterSessionCommand(
 }
 
 /** @brief Call Connection Manager.
+ *  @param context The request being handled
  *  @param receive_data Pointer to structure with data and header information.
  */
-EipStatus HandleReceivedSendUnitDataCommand(EncapsulationData *receive_data) {
+EipStatus HandleReceivedSendUnitDataCommand(RequestContext *context,
+                                            EncapsulationData *receive_data) {
   EipInt16 send_size;
   EipStatus return_value = kEipStatusOkSend;
 
@@ -498,10 +534,16 @@ EipStatus HandleReceivedSendUnitDataCommand(EncapsulationData *receive_data) {
 
     if (kSessionStatusValid == CheckRegisteredSessions(receive_data)) /* see if the EIP session is registered*/
     {
+#ifdef OPENER_TCP_WORKERS
+      LockCipObjects();
+#endif
       send_size =
           NotifyConnectedCommonPacketFormat(
-              receive_data,
+              context, receive_data,
               &receive_data->communication_buffer_start[ENCAPSULATION_HEADER_LENGTH]);
+#ifdef OPENER_TCP_WORKERS
+      UnlockCipObjects();
+#endif
 
       if (0 < send_size) { /* need to send reply */
         receive_data->data_length = send_size;
@@ -517,12 +559,13 @@ EipStatus HandleReceivedSendUnitDataCommand(EncapsulationData *receive_data) {
 }
 
 /** @brief Call UCMM or Message Router if UCMM not implemented.
+ *  @param context The request being handled
  *  @param receive_data Pointer to structure with data and header information.
  *  @return status 	0 .. success.
  * 					-1 .. error
  */
 EipStatus HandleReceivedSendRequestResponseDataCommand(
-    EncapsulationData *receive_data) {
+    RequestContext *context, EncapsulationData *receive_data) {
   EipInt16 send_size;
   EipStatus return_value = kEipStatusOkSend;
 
@@ -535,10 +578,16 @@ EipStatus HandleReceivedSendRequestResponseDataCommand(
 
     if (kSessionStatusValid == CheckRegisteredSessions(receive_data)) /* see if the EIP session is registered*/
     {
+#ifdef OPENER_TCP_WORKERS
+      LockCipObjects();
+#endif
       send_size =
           NotifyCommonPacketFormat(
-              receive_data,
+              context, receive_data,
               &receive_data->communication_buffer_start[ENCAPSULATION_HEADER_LENGTH]);
+#ifdef OPENER_TCP_WORKERS
+      UnlockCipObjects();
+#endif
 
       if (send_size >= 0) { /* need to send reply */
         receive_data->data_length = send_size;
@@ -558,7 +607,7 @@ EipStatus HandleReceivedSendRequestResponseDataCommand(
  * 			kInvalidSession .. no free session available
  */
 int GetFreeSessionIndex(void) {
-  for (int session_index = 0; session_index < OPENER_NUMBER_OF_SUPPORTED_SESSIONS; session_index++) {
+  for (int session_index = g_first_session; session_index < g_end_of_sessions; session_index++) {
     if (kEipInvalidSocket == g_registered_sessions[session_index]) {
       return session_index;
     }
@@ -597,8 +646,8 @@ EipInt16 CreateEncapsulationStructure(EipUint8 *receive_buffer,
  *  		kInvalidSession .. invalid session -> return unsupported command received
  */
 SessionStatus CheckRegisteredSessions(EncapsulationData *receive_data) {
-  if ((0 < receive_data->session_handle)
-      && (receive_data->session_handle <= OPENER_NUMBER_OF_SUPPORTED_SESSIONS)) {
+  if ((g_first_session < receive_data->session_handle)
+      && (receive_data->session_handle <= g_end_of_sessions)) {
     if (kEipInvalidSocket
         != g_registered_sessions[receive_data->session_handle - 1]) {
       return kSessionStatusValid;
@@ -609,7 +658,7 @@ SessionStatus CheckRegisteredSessions(EncapsulationData *receive_data) {
 
 void CloseSession(int socket) {
   int i;
-  for (i = 0; i < OPENER_NUMBER_OF_SUPPORTED_SESSIONS; ++i) {
+  for (i = g_first_session; i < g_end_of_sessions; ++i) {
     if (g_registered_sessions[i] == socket) {
       IApp_CloseSocket_tcp(socket);
       g_registered_sessions[i] = kEipInvalidSocket;
@@ -619,7 +668,7 @@ void CloseSession(int socket) {
 }
 
 void EncapsulationShutDown(void) {
-  for (int i = 0; i < OPENER_NUMBER_OF_SUPPORTED_SESSIONS; ++i) {
+  for (int i = g_first_session; i < g_end_of_sessions; ++i) {
     if (kEipInvalidSocket != g_registered_sessions[i]) {
       IApp_CloseSocket_tcp(g_registered_sessions[i]);
       g_registered_sessions[i] = kEipInvalidSocket;
@@ -627,19 +676,22 @@ void EncapsulationShutDown(void) {
   }
 }
 
-void ManageEncapsulationMessages(MilliSeconds elapsed_time) {
-  for (unsigned int i = 0; i < ENCAP_NUMBER_OF_SUPPORTED_DELAYED_ENCAP_MESSAGES; i++) {
-    if (kEipInvalidSocket != g_delayed_encapsulation_messages[i].socket) {
-      g_delayed_encapsulation_messages[i].time_out -=
-          elapsed_time;
-      if (0 > g_delayed_encapsulation_messages[i].time_out) {
-        /* If delay is reached or passed, send the UDP message */
-        SendUdpData(&(g_delayed_encapsulation_messages[i].receiver),
-                    g_delayed_encapsulation_messages[i].socket,
-                    &(g_delayed_encapsulation_messages[i].message[0]),
-                    g_delayed_encapsulation_messages[i].message_size);
-        g_delayed_encapsulation_messages[i].socket = -1;
-      }
-    }
+void SetEncapsulationSessionSlice(int first_session, int number_of_sessions) {
+  g_first_session = first_session;
+  g_end_of_sessions = first_session + number_of_sessions;
+}
+
+void ManageEncapsulationMessages(MicroSeconds elapsed_time) {
+  QueuedTimer *timer;
+
+  g_encapsulation_time += elapsed_time;
+  while (NULL
+      != (timer = TimerQueuePopDue(&g_delayed_encapsulation_message_timers,
+                                   g_encapsulation_time))) {
+    DelayedEncapsulationMessage *delayed_message = timer->data;
+    /* If delay is reached or passed, send the UDP message */
+    SendUdpData(&(delayed_message->receiver), delayed_message->socket,
+                &(delayed_message->message[0]), delayed_message->message_size);
+    delayed_message->socket = -1;
   }
 }
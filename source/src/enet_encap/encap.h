@@ -44,8 +44,8 @@ typedef struct encapsulation_data {
   CipUdint status;
   CipOctet sender_context[8]; /**< length of 8, according to the specification */
   CipUdint options;
-  EipUint8 *communication_buffer_start; /**< Pointer to the communication buffer used for this message */
-  EipUint8 *current_communication_buffer_position; /**< The current position in the communication buffer during the decoding process */
+  EipUint8 *communication_buffer_start; /**< Pointer to the buffer the reply is assembled in, it starts with the header of the request */
+  EipUint8 *current_communication_buffer_position; /**< The current position in the received request during the decoding process */
 } EncapsulationData;
 
 typedef struct encapsulation_interface_information {
@@ -68,9 +68,24 @@ void EncapsulationInit(void);
  * @brief Shutdown the encapsulation layer.
  *
  * This means that all open sessions including their sockets are closed.
+ * Only the sessions of the calling thread's slice are closed, see
+ * SetEncapsulationSessionSlice.
  */
 void EncapsulationShutDown(void);
 
+/** @ingroup ENCAP
+ * @brief Restricts the sessions of the calling thread to a slice of the
+ * session table
+ *
+ * A thread serving TCP connections besides the main thread registers its
+ * sessions in a slice it owns exclusively, session handles outside of the
+ * slice are invalid for it. The main thread uses the whole table by default.
+ *
+ * @param first_session Index of the first session of the slice
+ * @param number_of_sessions Number of sessions in the slice
+ */
+void SetEncapsulationSessionSlice(int first_session, int number_of_sessions);
+
 /** @ingroup ENCAP
  * @brief Handle delayed encapsulation message responses
  *
@@ -78,6 +93,6 @@ void EncapsulationShutDown(void);
  * message. This functions checks if messages need to be sent and performs the
  * sending.
  */
-void ManageEncapsulationMessages(MilliSeconds elapsed_time);
+void ManageEncapsulationMessages(MicroSeconds elapsed_time);
 
 #endif /* OPENER_ENCAP_H_ */
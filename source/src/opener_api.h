@@ -232,6 +232,17 @@ void InsertService(CipClass *cip_class_to_add_service, EipUint8 service_code,
  */
 int EncodeData(EipUint8 cip_data_type, void *cip_data, EipUint8 **cip_message);
 
+/** @ingroup CIP_API
+ * @brief Get the number of bytes EncodeData would produce for the data.
+ *
+ * This function may be used in own services to check that the data fits into
+ * the response before encoding it.
+ *  @param cip_data_type the cip type to encode
+ *  @param cip_data pointer to data value.
+ *  @return length of the encoded data in bytes
+ */
+int GetEncodedDataLength(EipUint8 cip_data_type, void *cip_data);
+
 /** @ingroup CIP_API
  * @brief Retrieve the given data according to CIP encoding from the message
  * buffer.
@@ -268,17 +279,22 @@ CipInstance *CreateAssemblyObject(EipUint32 instance_number, EipByte *data,
 
 struct connection_object;
 
+struct request_context;
+
 /** @ingroup CIP_API
  * @brief Function prototype for handling the opening of connections
  *
  * @param connection_object The connection object which is opening the
  * connection
+ * @param context The Forward Open request, its CPF items receive the socket
+ * address info items of the reply
  * @param extended_error_code The returned error code of the connection object
  *
  * @return CIP error code
  */
 typedef EipStatus (*OpenConnectionFunction)(
-    struct connection_object *connection_object, EipUint16 *extended_error_code);
+    struct connection_object *connection_object,
+    struct request_context *context, EipUint16 *extended_error_code);
 
 /** @ingroup CIP_API
  * @brief Function prototype for handling the closing of connections
@@ -391,16 +407,18 @@ void ConfigureListenOnlyConnectionPoint(unsigned int connection_number,
  * @brief Notify the encapsulation layer that an explicit message has been
  * received via TCP.
  *
- * @param socket_handle socket handle from which data is received.
- * @param buffer buffer that contains the received data. This buffer will also
- * contain the response if one is to be sent.
- * @param buffer length of the data in buffer.
+ * @param context the request, the caller sets the socket and the originator
+ * address. The reply buffer of the context will contain the response if one
+ * is to be sent.
+ * @param buffer buffer that contains the received data, it is decoded in
+ * place and has to stay unchanged until the function returns.
+ * @param buffer_length length of the data in buffer.
  * @param number_of_remaining_bytes return how many bytes of the input are left
  * over after we're done here
  * @return length of reply that need to be sent back
  */
-int HandleReceivedExplictTcpData(int socket, EipUint8 *buffer,
-                                 unsigned int buffer_length,
+int HandleReceivedExplictTcpData(struct request_context *context,
+                                 EipUint8 *buffer, unsigned int buffer_length,
                                  int *number_of_remaining_bytes);
 
 /** @ingroup CIP_API
@@ -441,13 +459,106 @@ HandleReceivedConnectedData(EipUint8 *received_data, int received_data_length,
  * WatchdogTimeout) have timed out.
  *
  * If the a timeout occurs the function performs the necessary action. This
- * function should be called periodically once every OPENER_TIMER_TICK
+ * function should be called at the latest after
+ * GetTimeToNextConnectionEvent() and at least once every OPENER_TIMER_TICK
  * milliseconds.
  *
+ * @param elapsed_time time since the last call in microseconds
+ * @return EIP_OK on success
+ */
+EipStatus
+ManageConnections(MicroSeconds elapsed_time);
+
+/** @ingroup CIP_API
+ * @brief Handle the expired connection timers, i.e., the productions and the
+ * inactivity watchdogs.
+ *
+ * Called by ManageConnections. With OPENER_IO_THREAD ManageConnections leaves
+ * the connection timers to the I/O thread of the platform, which calls this
+ * function instead.
+ *
+ * @param elapsed_time time since the last call in microseconds
  * @return EIP_OK on success
  */
 EipStatus
-ManageConnections(MilliSeconds elapsed_time);
+ManageConnectionTimers(MicroSeconds elapsed_time);
+
+/** @ingroup CIP_API
+ * @brief Get the time until the next production or inactivity watchdog time
+ * out of the active connections.
+ *
+ * @return time in microseconds counted from the last call of
+ * ManageConnections, 0 if a connection is already due
+ */
+MicroSeconds GetTimeToNextConnectionEvent(void);
+
+/** @brief Policies for the phase of the first production of a connection
+ * within its RPI
+ */
+typedef enum {
+  kProductionPhasePolicyImmediate = 0, /**< produce at once, connections with
+   the same RPI produce in the same tick */
+  kProductionPhasePolicyEvenSpread, /**< spread the connections evenly over
+   the RPI in the order they are established */
+  kProductionPhasePolicyHash, /**< phase derived from the connection serial
+   number, independent of the order the connections are established */
+  kProductionPhasePolicyExplicitOffset /**< offsets configured with
+   ConfigureProductionPhaseOffset */
+} ProductionPhasePolicy;
+
+#ifndef OPENER_PRODUCTION_PHASE_OFFSETS
+/** @brief Number of input assemblies for which an explicit production phase
+ * offset can be configured */
+#define OPENER_PRODUCTION_PHASE_OFFSETS 8
+#endif
+
+#ifndef OPENER_PRODUCTION_LOAD_HISTOGRAM_SIZE
+/** @brief Number of entries of ProductionLoad::histogram */
+#define OPENER_PRODUCTION_LOAD_HISTOGRAM_SIZE 16
+#endif
+
+/** @brief Transmit load of the connection manager */
+typedef struct {
+  EipUint32 last; /**< productions of the last ManageConnections call */
+  EipUint32 maximum; /**< most productions of a single call */
+  /** number of ManageConnections calls which sent the index number of
+   * productions, the last entry counts all calls with more productions */
+  EipUint32 histogram[OPENER_PRODUCTION_LOAD_HISTOGRAM_SIZE];
+} ProductionLoad;
+
+/** @ingroup CIP_API
+ * @brief Selects how the first productions of new connections are placed
+ * within their RPI.
+ *
+ * Spreading the phases avoids that connections with the same RPI produce in
+ * the same tick and burst onto the network. The default is
+ * kProductionPhasePolicyEvenSpread. Connections established before the call
+ * keep their phases.
+ *
+ * @param policy the policy for new connections
+ */
+void ConfigureProductionPhasePolicy(ProductionPhasePolicy policy);
+
+/** @ingroup CIP_API
+ * @brief Configures the production phase of connections producing the given
+ * input assembly, used with kProductionPhasePolicyExplicitOffset.
+ *
+ * Connections of input assemblies without configured offset produce at once.
+ * @param input_assembly_id ID of the T-to-O point
+ * @param offset delay of the first production in microseconds, taken modulo
+ * the RPI of the connection
+ * @return kEipStatusOk on success, kEipStatusError if already
+ * OPENER_PRODUCTION_PHASE_OFFSETS assemblies have an offset
+ */
+EipStatus ConfigureProductionPhaseOffset(unsigned int input_assembly_id,
+                                         MicroSeconds offset);
+
+/** @ingroup CIP_API
+ * @brief Get the number of productions sent per ManageConnections call.
+ *
+ * @return the transmit load statistics since the stack initialization
+ */
+const ProductionLoad *GetProductionLoad(void);
 
 /** @ingroup CIP_API
  * @brief Trigger the production of an application triggered connection.
@@ -622,13 +733,14 @@ void RunIdleChanged(EipUint32 run_idle_value);
  *     originator.
  *     Attention: For consuming connection the network layer has to set the
  * pa_pstAddr->sin_addr.s_addr to the correct address of the originator.
- * FIXME add an additional parameter that can be used by the CIP stack to
- * request the originators sockaddr_in data.
+ * @param originator_address the address of the originator which opens the
+ * connection
  * @return socket identifier on success
  *         -1 on error
  */
 int CreateUdpSocket(UdpCommuncationDirection communication_direction,
-                    struct sockaddr_in *socket_data);
+                    struct sockaddr_in *socket_data,
+                    const struct sockaddr_in *originator_address);
 
 /** @ingroup CIP_CALLBACK_API
  * @brief create a producing or consuming UDP socket
@@ -643,6 +755,25 @@ EipStatus
 SendUdpData(struct sockaddr_in *socket_data, int socket, EipUint8 *data,
             EipUint16 data_length);
 
+/** @ingroup CIP_CALLBACK_API
+ * @brief Send a datagram gathered from a header and a payload buffer
+ *
+ * The payload is sent straight from the given buffer where the platform
+ * supports it, e.g. the produced data from the assembly's buffer.
+ *
+ * @param socket_data pointer to the "send to" address
+ * @param socket_handle socket descriptor to send on
+ * @param header pointer to the first part of the data to send
+ * @param header_length length of the header
+ * @param payload pointer to the data following the header
+ * @param payload_length length of the payload
+ * @return  EIP_SUCCESS on success
+ */
+EipStatus
+SendUdpDataGathered(struct sockaddr_in *socket_data, int socket,
+                    EipUint8 *header, EipUint16 header_length,
+                    EipUint8 *payload, EipUint16 payload_length);
+
 /** @ingroup CIP_CALLBACK_API
  * @brief Close the given socket and clean up the stack
  *
@@ -650,6 +781,64 @@ SendUdpData(struct sockaddr_in *socket_data, int socket, EipUint8 *data,
  */
 void CloseSocket(int socket);
 
+/** @brief A task handed from one thread of the stack to another
+ *
+ * @param object the object the task works on
+ * @param value an additional parameter of the task
+ */
+typedef void (*ThreadTask)(void *object, EipUint32 value);
+
+#ifdef OPENER_IO_THREAD
+/** @ingroup CIP_CALLBACK_API
+ * @brief Run a task in the I/O thread
+ *
+ * With OPENER_IO_THREAD the I/O thread of the platform owns the connection
+ * timers, the connection ID index and the I/O sockets. The explicit messaging
+ * thread changes them only through tasks queued to the I/O thread. If the I/O
+ * thread is not running the task is run at once.
+ *
+ * @param task the task to be run
+ * @param object the object passed to the task
+ * @param value the value passed to the task
+ * @param wait if true the function returns after the task has been run,
+ * otherwise as soon as it has been queued
+ */
+void RunInIoThread(ThreadTask task, void *object, EipUint32 value,
+                   EipBool8 wait);
+
+/** @ingroup CIP_CALLBACK_API
+ * @brief Run a task in the explicit messaging thread, called from the I/O
+ * thread
+ *
+ * The I/O thread never waits for the explicit messaging thread, the task is
+ * only queued.
+ *
+ * @param task the task to be run
+ * @param object the object passed to the task
+ * @param value the value passed to the task
+ * @return kEipStatusOk if the task has been queued, kEipStatusError if the
+ * queue is full
+ */
+EipStatus RunInExplicitThread(ThreadTask task, void *object, EipUint32 value);
+#endif
+
+#ifdef OPENER_TCP_WORKERS
+/** @ingroup CIP_CALLBACK_API
+ * @brief Acquire exclusive access to the CIP objects
+ *
+ * With OPENER_TCP_WORKERS explicit messages are handled by several threads.
+ * The message router, the connection manager and the application's
+ * ManageConnections part run with this lock held only. Calls of RunInIoThread
+ * are serialized by it as well. The lock is not recursive.
+ */
+void LockCipObjects(void);
+
+/** @ingroup CIP_CALLBACK_API
+ * @brief Release the lock acquired with LockCipObjects
+ */
+void UnlockCipObjects(void);
+#endif
+
 /** @mainpage OpENer - Open Source EtherNet/IP(TM) Communication Stack
  *Documentation
  *
@@ -761,19 +950,21 @@ void CloseSocket(int socket);
  *   - Receive explicit message data on connected TCP sockets and the UPD socket
  *     for port AF12hex. The received data has to be hand over to Ethernet
  *     encapsulation layer with the functions: \n
- *      int HandleReceivedExplictTCPData(int socket_handle, EIP_UINT8* buffer, int
- * buffer_length, int *number_of_remaining_bytes),\n
+ *      int HandleReceivedExplictTCPData(struct request_context *context,
+ * EIP_UINT8* buffer, int buffer_length, int *number_of_remaining_bytes),\n
  *      int HandleReceivedExplictUDPData(int socket_handle, struct sockaddr_in
  * *from_address, EIP_UINT8* buffer, unsigned int buffer_length, int
  * *number_of_remaining_bytes).\n
  *     Depending if the data has been received from a TCP or from a UDP socket.
  *     As a result of this function a response may have to be sent. The data to
- *     be sent is in the given buffer pa_buf.
+ *     be sent is in the reply buffer of the context for TCP and in the given
+ *     buffer for UDP.
  *   - Create UDP sending and receiving sockets for implicit connected
  * messages\n
  *     OpENer will use to call-back function int CreateUdpSocket(
  *     UdpCommuncationDirection connection_direction,
- *     struct sockaddr_in *pa_pstAddr)
+ *     struct sockaddr_in *pa_pstAddr,
+ *     const struct sockaddr_in *originator_address)
  *     for informing the platform specific code that a new connection is
  *     established and new sockets are necessary
  *   - Receive implicit connected data on a receiving UDP socket\n
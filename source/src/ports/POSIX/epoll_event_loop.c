@@ -0,0 +1,316 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Rockwell Automation, Inc.
+ * All rights reserved.
+ *
+ ******************************************************************************/
+
+/** @file epoll_event_loop.c
+ *  @brief epoll based event loop backend of the generic network handler
+ *
+ *  Each registered socket carries its handler, so dispatching costs O(ready
+ *  sockets) instead of O(highest socket) as with select(), and the number of
+ *  sockets is not limited by FD_SETSIZE. epoll_wait() only takes timeouts in
+ *  milliseconds, so the wait is bounded by a timerfd instead.
+ */
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "generic_networkhandler.h"
+
+#include "opener_error.h"
+#include "trace.h"
+
+#ifndef OPENER_EPOLL_MAX_EVENTS
+/** @brief Maximum number of readiness events fetched with one epoll_wait */
+#define OPENER_EPOLL_MAX_EVENTS 64
+#endif
+
+/** @brief Handler registration of a socket, indexed by the descriptor */
+typedef struct {
+  SocketEventHandler handler; /**< readiness handler */
+  DatagramEventHandler datagram_handler; /**< if set, datagrams are received by the event loop */
+  StreamEventHandler stream_handler; /**< if set, stream data is received by the event loop */
+  SocketEventHandler writable_handler; /**< if set, reading is paused until the socket is writable */
+  EipUint32 generation; /**< incremented on each (un)registration, to detect stale events */
+} EpollSocketRegistration;
+
+/** @brief epoll instance of the calling thread, every thread running an event
+ * loop has its own */
+static OPENER_THREAD_LOCAL int g_epoll_handle = -1;
+
+/** @brief Timer ending the wait of EventLoopDispatchEvents in microseconds */
+static OPENER_THREAD_LOCAL int g_epoll_timer = -1;
+
+static OPENER_THREAD_LOCAL EpollSocketRegistration *g_epoll_registrations = NULL;
+static OPENER_THREAD_LOCAL size_t g_number_of_epoll_registrations = 0;
+
+/** @brief Encodes socket and registration generation into the epoll user data
+ *
+ * Events fetched by one epoll_wait may refer to a socket which has been closed
+ * and reused by a handler running before, the generation allows to drop them.
+ */
+static uint64_t EncodeEpollEventData(int socket) {
+  return ((uint64_t) g_epoll_registrations[socket].generation << 32)
+      | (EipUint32) socket;
+}
+
+/** @brief Ensures that the registration table can hold the given descriptor
+ *
+ * @param socket The descriptor to be stored
+ * @return kEipStatusOk on success, kEipStatusError if no memory is available
+ */
+static EipStatus ReserveEpollRegistration(int socket) {
+  if ((size_t) socket < g_number_of_epoll_registrations) {
+    return kEipStatusOk;
+  }
+
+  size_t new_size =
+      g_number_of_epoll_registrations ? g_number_of_epoll_registrations : 64;
+  while (new_size <= (size_t) socket) {
+    new_size *= 2;
+  }
+
+  EpollSocketRegistration *new_registrations = realloc(
+      g_epoll_registrations, new_size * sizeof(EpollSocketRegistration));
+  if (NULL == new_registrations) {
+    OPENER_TRACE_ERR("networkhandler: no memory for epoll registrations\n");
+    return kEipStatusError;
+  }
+  memset(&new_registrations[g_number_of_epoll_registrations], 0,
+         (new_size - g_number_of_epoll_registrations)
+             * sizeof(EpollSocketRegistration));
+
+  g_epoll_registrations = new_registrations;
+  g_number_of_epoll_registrations = new_size;
+  return kEipStatusOk;
+}
+
+static EipStatus AddEpollSocket(int socket, SocketEventHandler handler,
+                                DatagramEventHandler datagram_handler,
+                                StreamEventHandler stream_handler);
+
+/** @brief Sets the events the registered socket is watched for, events of the
+ * former setting which are already fetched are dropped
+ *
+ * @param socket The socket to be watched
+ * @param operation EPOLL_CTL_ADD or EPOLL_CTL_MOD
+ * @param events EPOLLIN or EPOLLOUT
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+static EipStatus WatchEpollSocket(int socket, int operation, EipUint32 events) {
+  g_epoll_registrations[socket].generation++;
+  struct epoll_event event = { .events = events, .data.u64 =
+      EncodeEpollEventData(socket) };
+
+  if (-1 == epoll_ctl(g_epoll_handle, operation, socket, &event)) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error adding socket %d to epoll: %d - %s\n",
+                     socket, error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+/** @brief Acknowledges the expiration of the wait timer */
+static void HandleEpollTimer(int timer) {
+  uint64_t number_of_expirations;
+  if (-1 == read(timer, &number_of_expirations, sizeof(number_of_expirations))) {
+    /* the timer has been rearmed before it was read, nothing to acknowledge */
+  }
+}
+
+EipStatus EventLoopInitialize(void) {
+  g_epoll_handle = epoll_create(OPENER_EPOLL_MAX_EVENTS); /* the size is only a hint */
+  if (-1 == g_epoll_handle) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error creating epoll instance: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+
+  g_epoll_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+  if (-1 == g_epoll_timer) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error creating the epoll timer: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+  return AddEpollSocket(g_epoll_timer, HandleEpollTimer, NULL, NULL);
+}
+
+void EventLoopShutdown(void) {
+  if (-1 != g_epoll_timer) {
+    close(g_epoll_timer);
+    g_epoll_timer = -1;
+  }
+  if (-1 != g_epoll_handle) {
+    close(g_epoll_handle);
+    g_epoll_handle = -1;
+  }
+  free(g_epoll_registrations);
+  g_epoll_registrations = NULL;
+  g_number_of_epoll_registrations = 0;
+}
+
+/** @brief Checks if a handler is registered for the given descriptor */
+static EipBool8 IsEpollSocketRegistered(int socket) {
+  return (0 <= socket) && ((size_t) socket < g_number_of_epoll_registrations)
+      && ((NULL != g_epoll_registrations[socket].handler)
+          || (NULL != g_epoll_registrations[socket].datagram_handler)
+          || (NULL != g_epoll_registrations[socket].stream_handler));
+}
+
+/** @brief Registers the socket with either a readiness, a datagram or a
+ * stream handler
+ *
+ * @param socket The socket to be watched
+ * @param handler Readiness handler or NULL
+ * @param datagram_handler Datagram handler or NULL
+ * @param stream_handler Stream handler or NULL
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+static EipStatus AddEpollSocket(int socket, SocketEventHandler handler,
+                                DatagramEventHandler datagram_handler,
+                                StreamEventHandler stream_handler) {
+  if ((0 > socket) || (kEipStatusOk != ReserveEpollRegistration(socket))) {
+    return kEipStatusError;
+  }
+
+  int operation = EPOLL_CTL_ADD;
+  if (IsEpollSocketRegistered(socket)) {
+    operation = EPOLL_CTL_MOD;
+  }
+
+  if (kEipStatusOk != WatchEpollSocket(socket, operation, EPOLLIN)) {
+    return kEipStatusError;
+  }
+
+  g_epoll_registrations[socket].handler = handler;
+  g_epoll_registrations[socket].datagram_handler = datagram_handler;
+  g_epoll_registrations[socket].stream_handler = stream_handler;
+  g_epoll_registrations[socket].writable_handler = NULL;
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopAddSocket(int socket, SocketEventHandler handler) {
+  return AddEpollSocket(socket, handler, NULL, NULL);
+}
+
+EipStatus EventLoopAddDatagramSocket(int socket, DatagramEventHandler handler) {
+  return AddEpollSocket(socket, NULL, handler, NULL);
+}
+
+EipStatus EventLoopAddStreamSocket(int socket, StreamEventHandler handler) {
+  return AddEpollSocket(socket, NULL, NULL, handler);
+}
+
+void EventLoopRemoveSocket(int socket) {
+  if (!IsEpollSocketRegistered(socket)) {
+    return; /* not registered */
+  }
+
+  /* the event argument is ignored, but must not be NULL for kernels < 2.6.9 */
+  struct epoll_event event = { 0 };
+  epoll_ctl(g_epoll_handle, EPOLL_CTL_DEL, socket, &event);
+
+  g_epoll_registrations[socket].handler = NULL;
+  g_epoll_registrations[socket].datagram_handler = NULL;
+  g_epoll_registrations[socket].stream_handler = NULL;
+  g_epoll_registrations[socket].writable_handler = NULL;
+  g_epoll_registrations[socket].generation++;
+}
+
+EipStatus EventLoopWatchWritable(int socket, SocketEventHandler handler) {
+  if (!IsEpollSocketRegistered(socket)
+      || (kEipStatusOk != WatchEpollSocket(socket, EPOLL_CTL_MOD, EPOLLOUT))) {
+    return kEipStatusError;
+  }
+  g_epoll_registrations[socket].writable_handler = handler;
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopDispatchEvents(MicroSeconds timeout) {
+  struct epoll_event events[OPENER_EPOLL_MAX_EVENTS];
+
+  int epoll_timeout = 0; /* a zero timer value would disarm the timer */
+  if (0 < timeout) {
+    struct itimerspec timer_value = { .it_value = { .tv_sec = timeout / 1000000,
+        .tv_nsec = (timeout % 1000000) * 1000 } };
+    if (-1 == timerfd_settime(g_epoll_timer, 0, &timer_value, NULL)) {
+      int error_code = GetSocketErrorNumber();
+      char* error_message = GetErrorMessage(error_code);
+      OPENER_TRACE_ERR("networkhandler: error arming the epoll timer: %d - %s\n",
+                       error_code, error_message);
+      free(error_message);
+      return kEipStatusError;
+    }
+    epoll_timeout = -1; /* the timer ends the wait */
+  }
+
+  int number_of_events = epoll_wait(g_epoll_handle, events,
+                                    OPENER_EPOLL_MAX_EVENTS, epoll_timeout);
+
+  if (-1 == number_of_events) {
+    if (EINTR == errno) { /* interrupted by a signal, go back into the loop */
+      return kEipStatusOk;
+    }
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error with epoll_wait: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+
+  for (int i = 0; i < number_of_events; i++) {
+    int socket = (int) (events[i].data.u64 & 0xFFFFFFFFU);
+    EipUint32 generation = (EipUint32) (events[i].data.u64 >> 32);
+
+    if (IsEpollSocketRegistered(socket)
+        && (generation == g_epoll_registrations[socket].generation)) {
+      SocketEventHandler writable_handler =
+          g_epoll_registrations[socket].writable_handler;
+      if (NULL != writable_handler) {
+        /* resume reading before the handler may pause it again */
+        g_epoll_registrations[socket].writable_handler = NULL;
+        WatchEpollSocket(socket, EPOLL_CTL_MOD, EPOLLIN);
+        writable_handler(socket);
+      } else if (NULL != g_epoll_registrations[socket].datagram_handler) {
+        ReceiveDatagram(socket, g_epoll_registrations[socket].datagram_handler);
+      } else if (NULL != g_epoll_registrations[socket].stream_handler) {
+        ReceiveStream(socket, g_epoll_registrations[socket].stream_handler);
+      } else {
+        g_epoll_registrations[socket].handler(socket);
+      }
+    } else {
+      OPENER_TRACE_INFO("socket: %d closed with pending message\n", socket);
+    }
+  }
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopSendDatagram(int socket, struct sockaddr_in *address,
+                                EipUint8 *data, size_t data_length) {
+  return SendDatagramImmediately(socket, address, data, data_length);
+}
+
+EipStatus EventLoopSendGatheredDatagram(int socket,
+                                        struct sockaddr_in *address,
+                                        EipUint8 *header, size_t header_length,
+                                        EipUint8 *payload,
+                                        size_t payload_length) {
+  return SendGatheredDatagramImmediately(socket, address, header, header_length,
+                                         payload, payload_length);
+}
+
+long EventLoopSendStream(int socket, EipUint8 *data, size_t data_length) {
+  return SendStreamImmediately(socket, data, data_length);
+}
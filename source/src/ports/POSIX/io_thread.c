@@ -0,0 +1,350 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Rockwell Automation, Inc.
+ * All rights reserved.
+ *
+ ******************************************************************************/
+#define _GNU_SOURCE /* pthread_setaffinity_np, pipe2, ppoll */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "io_thread.h"
+
+#include "opener_api.h"
+#include "opener_error.h"
+#include "spscqueue.h"
+#include "trace.h"
+
+/** @brief A task queued to one of the threads */
+typedef struct {
+  ThreadTask task;
+  void *object;
+  EipUint32 value;
+} QueuedThreadTask;
+
+/** @brief A consuming socket served by the I/O thread */
+typedef struct {
+  int socket;
+  DatagramEventHandler handler;
+} IoThreadSocket;
+
+static QueuedThreadTask g_io_thread_task_storage[OPENER_IO_THREAD_QUEUE_SIZE];
+static QueuedThreadTask g_explicit_thread_task_storage[OPENER_IO_THREAD_QUEUE_SIZE];
+static SpscQueue g_io_thread_tasks; /**< from the explicit messaging thread to the I/O thread */
+static SpscQueue g_explicit_thread_tasks; /**< from the I/O thread to the explicit messaging thread */
+
+/** pipes waking up the threads when tasks have been queued, [0] is read */
+static int g_io_thread_wake_up[2] = { -1, -1 };
+static int g_explicit_thread_wake_up[2] = { -1, -1 };
+
+/** tasks queued to and run by the I/O thread, a waiting caller spins until
+ * its task has been completed */
+static EipUint32 g_posted_io_thread_tasks = 0;
+static EipUint32 g_completed_io_thread_tasks = 0;
+
+static pthread_t g_io_thread;
+static EipBool8 g_is_io_thread_running = false; /**< written by the explicit messaging thread only */
+static EipBool8 g_is_io_thread_stopping = false;
+static __thread EipBool8 g_is_in_io_thread = false;
+
+/** the consuming sockets, changed by the I/O thread only */
+static IoThreadSocket g_io_thread_sockets[OPENER_IO_THREAD_SOCKETS];
+static int g_number_of_io_thread_sockets = 0;
+
+/** @brief Writes a byte to the pipe, a full pipe already wakes up the thread */
+static void WakeUpThread(int wake_up_pipe[2]) {
+  static const char wake_up = 0;
+  if ((1 != write(wake_up_pipe[1], &wake_up, sizeof(wake_up)))
+      && (EAGAIN != errno)) {
+    int error_code = errno;
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("io thread: could not wake up thread: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+  }
+}
+
+/** @brief Empties the wake up pipe */
+static void DrainWakeUpPipe(int wake_up_pipe[2]) {
+  char buffer[64];
+  while (0 < read(wake_up_pipe[0], buffer, sizeof(buffer))) {
+  }
+}
+
+/** @brief Runs the tasks queued to the I/O thread */
+static void RunIoThreadTasks(void) {
+  QueuedThreadTask queued_task;
+  while (0 == SpscQueuePop(&g_io_thread_tasks, &queued_task)) {
+    queued_task.task(queued_task.object, queued_task.value);
+    __atomic_add_fetch(&g_completed_io_thread_tasks, 1, __ATOMIC_RELEASE);
+  }
+}
+
+/** @brief Event loop handler of the explicit messaging thread's wake up pipe */
+static void HandleExplicitThreadWakeUp(int socket) {
+  QueuedThreadTask queued_task;
+  (void) socket; /* kill unused parameter warning */
+
+  DrainWakeUpPipe(g_explicit_thread_wake_up);
+  while (0 == SpscQueuePop(&g_explicit_thread_tasks, &queued_task)) {
+#ifdef OPENER_TCP_WORKERS
+    LockCipObjects();
+    queued_task.task(queued_task.object, queued_task.value);
+    UnlockCipObjects();
+#else
+    queued_task.task(queued_task.object, queued_task.value);
+#endif
+  }
+}
+
+void RunInIoThread(ThreadTask task, void *object, EipUint32 value,
+                   EipBool8 wait) {
+  if (!g_is_io_thread_running || g_is_in_io_thread) {
+    task(object, value);
+    return;
+  }
+
+  QueuedThreadTask queued_task = { task, object, value };
+  while (0 != SpscQueuePush(&g_io_thread_tasks, &queued_task)) {
+    sched_yield(); /* the I/O thread empties the queue at its next wake up */
+  }
+  EipUint32 ticket = ++g_posted_io_thread_tasks;
+  WakeUpThread(g_io_thread_wake_up);
+
+  if (wait) {
+    while ((EipInt32) (__atomic_load_n(&g_completed_io_thread_tasks,
+                                       __ATOMIC_ACQUIRE) - ticket) < 0) {
+      sched_yield();
+    }
+  }
+}
+
+EipStatus RunInExplicitThread(ThreadTask task, void *object, EipUint32 value) {
+  if (!g_is_in_io_thread) {
+    task(object, value);
+    return kEipStatusOk;
+  }
+
+  QueuedThreadTask queued_task = { task, object, value };
+  if (0 != SpscQueuePush(&g_explicit_thread_tasks, &queued_task)) {
+    return kEipStatusError;
+  }
+  WakeUpThread(g_explicit_thread_wake_up);
+  return kEipStatusOk;
+}
+
+/** @brief Adds the socket to the I/O thread's sockets, the result is returned
+ * in the socket's handler, which is NULL if the socket did not fit */
+static void AddIoThreadSocketTask(void *object, EipUint32 value) {
+  IoThreadSocket *io_thread_socket = object;
+  (void) value; /* kill unused parameter warning */
+
+  if (OPENER_IO_THREAD_SOCKETS <= g_number_of_io_thread_sockets) {
+    io_thread_socket->handler = NULL;
+    return;
+  }
+  g_io_thread_sockets[g_number_of_io_thread_sockets++] = *io_thread_socket;
+}
+
+static void RemoveIoThreadSocketTask(void *object, EipUint32 value) {
+  (void) object; /* kill unused parameter warning */
+
+  for (int i = 0; i < g_number_of_io_thread_sockets; i++) {
+    if ((int) value == g_io_thread_sockets[i].socket) {
+      g_io_thread_sockets[i] =
+          g_io_thread_sockets[--g_number_of_io_thread_sockets];
+      return;
+    }
+  }
+}
+
+EipStatus IoThreadAddSocket(int socket, DatagramEventHandler handler) {
+  IoThreadSocket io_thread_socket = { socket, handler };
+  RunInIoThread(AddIoThreadSocketTask, &io_thread_socket, 0, true);
+  if (NULL == io_thread_socket.handler) {
+    OPENER_TRACE_ERR(
+        "io thread: too many sockets, raise OPENER_IO_THREAD_SOCKETS\n");
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+void IoThreadRemoveSocket(int socket) {
+  RunInIoThread(RemoveIoThreadSocketTask, NULL, (EipUint32) socket, true);
+}
+
+/** @brief Gives the I/O thread its CPU and real-time priority, failing is not
+ * fatal */
+static void SetUpIoThreadScheduling(void) {
+#if OPENER_IO_THREAD_CPU >= 0
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(OPENER_IO_THREAD_CPU, &cpus);
+  int error_code = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  if (0 != error_code) {
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_WARN("io thread: could not pin thread to CPU %d: %d - %s\n",
+                      OPENER_IO_THREAD_CPU, error_code, error_message);
+    free(error_message);
+  }
+#endif
+#if OPENER_IO_THREAD_PRIORITY > 0
+  struct sched_param parameter = { .sched_priority = OPENER_IO_THREAD_PRIORITY };
+  int priority_error_code = pthread_setschedparam(pthread_self(), SCHED_FIFO,
+                                                  &parameter);
+  if (0 != priority_error_code) {
+    char* error_message = GetErrorMessage(priority_error_code);
+    OPENER_TRACE_WARN(
+        "io thread: could not set SCHED_FIFO priority %d: %d - %s\n",
+        OPENER_IO_THREAD_PRIORITY, priority_error_code, error_message);
+    free(error_message);
+  }
+#endif
+}
+
+/** @brief Time until the I/O thread has to call ManageConnectionTimers */
+static MicroSeconds GetIoThreadManagementTime(void) {
+  MicroSeconds management_time = GetTimeToNextConnectionEvent();
+  if (management_time > kOpenerTimerTickInMilliSeconds * 1000ULL) {
+    management_time = kOpenerTimerTickInMilliSeconds * 1000ULL;
+  }
+  return management_time;
+}
+
+static void *IoThreadMain(void *argument) {
+  struct pollfd poll_descriptors[1 + OPENER_IO_THREAD_SOCKETS];
+  IoThreadSocket ready_sockets[OPENER_IO_THREAD_SOCKETS];
+  MicroSeconds last_time = GetMicroSeconds();
+  MicroSeconds elapsed_time = 0;
+  (void) argument; /* kill unused parameter warning */
+
+  g_is_in_io_thread = true;
+
+  /* signals are handled by the explicit messaging thread */
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  SetUpIoThreadScheduling();
+  SetDatagramReceiveStatistics(
+      &g_network_status.io_thread_datagram_receive_statistics);
+
+  while (!__atomic_load_n(&g_is_io_thread_stopping, __ATOMIC_ACQUIRE)) {
+    MicroSeconds management_time = GetIoThreadManagementTime();
+    MicroSeconds timeout =
+        elapsed_time < management_time ? management_time - elapsed_time : 0;
+    struct timespec poll_timeout = { .tv_sec = timeout / 1000000ULL, .tv_nsec =
+        (timeout % 1000000ULL) * 1000ULL };
+
+    poll_descriptors[0].fd = g_io_thread_wake_up[0];
+    poll_descriptors[0].events = POLLIN;
+    int number_of_sockets = g_number_of_io_thread_sockets;
+    for (int i = 0; i < number_of_sockets; i++) {
+      poll_descriptors[1 + i].fd = g_io_thread_sockets[i].socket;
+      poll_descriptors[1 + i].events = POLLIN;
+      ready_sockets[i] = g_io_thread_sockets[i];
+    }
+
+    int ready = ppoll(poll_descriptors, 1 + number_of_sockets, &poll_timeout,
+                      NULL);
+    if ((0 > ready) && (EINTR != errno)) {
+      int error_code = errno;
+      char* error_message = GetErrorMessage(error_code);
+      OPENER_TRACE_ERR("io thread: error with ppoll: %d - %s\n", error_code,
+                       error_message);
+      free(error_message);
+    }
+
+    MicroSeconds actual_time = GetMicroSeconds();
+    elapsed_time += actual_time - last_time;
+    last_time = actual_time;
+
+    /* received data resets the inactivity watchdogs before they are checked,
+     * sockets are only removed by the tasks run afterwards */
+    for (int i = 0; (0 < ready) && (i < number_of_sockets); i++) {
+      if (0 != (poll_descriptors[1 + i].revents & (POLLIN | POLLERR))) {
+        ReceiveDatagram(ready_sockets[i].socket, ready_sockets[i].handler);
+      }
+    }
+
+    if ((0 < ready) && (0 != poll_descriptors[0].revents)) {
+      DrainWakeUpPipe(g_io_thread_wake_up);
+    }
+    RunIoThreadTasks();
+
+    if (elapsed_time >= GetIoThreadManagementTime()) {
+      BeginDatagramBatch();
+      ManageConnectionTimers(elapsed_time);
+      elapsed_time = 0;
+      EndDatagramBatch();
+    }
+  }
+
+  RunIoThreadTasks(); /* a waiting caller must not be left behind */
+  return NULL;
+}
+
+EipStatus IoThreadInitialize(void) {
+  SpscQueueInit(&g_io_thread_tasks, g_io_thread_task_storage,
+                sizeof(g_io_thread_task_storage[0]),
+                OPENER_IO_THREAD_QUEUE_SIZE);
+  SpscQueueInit(&g_explicit_thread_tasks, g_explicit_thread_task_storage,
+                sizeof(g_explicit_thread_task_storage[0]),
+                OPENER_IO_THREAD_QUEUE_SIZE);
+  g_posted_io_thread_tasks = 0;
+  g_completed_io_thread_tasks = 0;
+  g_number_of_io_thread_sockets = 0;
+
+  if ((0 != pipe2(g_io_thread_wake_up, O_NONBLOCK | O_CLOEXEC))
+      || (0 != pipe2(g_explicit_thread_wake_up, O_NONBLOCK | O_CLOEXEC))) {
+    int error_code = errno;
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("io thread: could not create wake up pipes: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+
+  /* tasks queued by the I/O thread are run by the event loop */
+  return EventLoopAddSocket(g_explicit_thread_wake_up[0],
+                            HandleExplicitThreadWakeUp);
+}
+
+EipStatus IoThreadStart(void) {
+  g_is_io_thread_stopping = false;
+  g_is_io_thread_running = true;
+  int error_code = pthread_create(&g_io_thread, NULL, IoThreadMain, NULL);
+  if (0 != error_code) {
+    g_is_io_thread_running = false;
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("io thread: could not start thread: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+void IoThreadStop(void) {
+  if (!g_is_io_thread_running) {
+    return;
+  }
+  __atomic_store_n(&g_is_io_thread_stopping, true, __ATOMIC_RELEASE);
+  WakeUpThread(g_io_thread_wake_up);
+  pthread_join(g_io_thread, NULL);
+  g_is_io_thread_running = false;
+
+  /* run what the I/O thread has left for the explicit messaging thread */
+  HandleExplicitThreadWakeUp(g_explicit_thread_wake_up[0]);
+  EventLoopRemoveSocket(g_explicit_thread_wake_up[0]);
+  for (int i = 0; i < 2; i++) {
+    close(g_io_thread_wake_up[i]);
+    close(g_explicit_thread_wake_up[i]);
+  }
+}
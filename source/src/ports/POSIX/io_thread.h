@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Rockwell Automation, Inc.
+ * All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef OPENER_IO_THREAD_H_
+#define OPENER_IO_THREAD_H_
+
+/** @file io_thread.h
+ * @brief Dedicated thread for the implicit (I/O) messaging
+ *
+ * With OPENER_IO_THREAD the stack runs in two threads. The main thread serves
+ * the event loop with the TCP and UDP listeners (explicit messaging) and opens
+ * and closes the connections. The I/O thread owns the consuming I/O sockets,
+ * the connection timers and the connection ID index; it consumes and produces
+ * the I/O data. The threads exchange tasks through two lock-free single
+ * producer single consumer queues, see RunInIoThread and RunInExplicitThread.
+ *
+ * The application callbacks of the I/O path (AfterAssemblyDataReceived,
+ * BeforeAssemblyDataSend and RunIdleChanged) are called from the I/O thread in
+ * this mode.
+ */
+
+#include "generic_networkhandler.h"
+
+/** @brief SCHED_FIFO priority of the I/O thread, 0 keeps the default
+ * scheduling policy */
+#ifndef OPENER_IO_THREAD_PRIORITY
+#define OPENER_IO_THREAD_PRIORITY 50
+#endif
+
+/** @brief CPU the I/O thread is pinned to, -1 allows all CPUs */
+#ifndef OPENER_IO_THREAD_CPU
+#define OPENER_IO_THREAD_CPU -1
+#endif
+
+/** @brief Number of tasks which can be queued to each of the threads, has to
+ * be a power of two */
+#ifndef OPENER_IO_THREAD_QUEUE_SIZE
+#define OPENER_IO_THREAD_QUEUE_SIZE 64
+#endif
+
+/** @brief Maximum number of consuming sockets served by the I/O thread: the
+ * shared port 2222 socket and the multicast consuming sockets */
+#ifndef OPENER_IO_THREAD_SOCKETS
+#define OPENER_IO_THREAD_SOCKETS (1 + OPENER_NUMBER_OF_MULTICAST_CONSUMING_SOCKETS)
+#endif
+
+/** @brief Sets up the task queues, to be called after EventLoopInitialize
+ *
+ *  @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus IoThreadInitialize(void);
+
+/** @brief Starts the I/O thread
+ *
+ * Until the thread is running the tasks for the I/O thread are run at once by
+ * the calling thread.
+ *
+ *  @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus IoThreadStart(void);
+
+/** @brief Stops the I/O thread and waits until it has ended */
+void IoThreadStop(void);
+
+/** @brief Adds a non-blocking consuming UDP socket to the sockets served by
+ * the I/O thread
+ *
+ *  @param socket The socket to be added
+ *  @param handler Handler called by the I/O thread for each received datagram
+ *  @return kEipStatusOk on success, kEipStatusError if no more sockets fit
+ */
+EipStatus IoThreadAddSocket(int socket, DatagramEventHandler handler);
+
+/** @brief Removes a socket from the sockets served by the I/O thread, the
+ * I/O thread does not touch the socket anymore when the function returns
+ *
+ *  @param socket The socket to be removed
+ */
+void IoThreadRemoveSocket(int socket);
+
+#endif /* OPENER_IO_THREAD_H_ */
@@ -0,0 +1,1005 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Rockwell Automation, Inc.
+ * All rights reserved.
+ *
+ ******************************************************************************/
+
+/** @file io_uring_event_loop.c
+ *  @brief io_uring based event loop backend of the generic network handler
+ *
+ *  Datagram sockets (UDP listeners and consuming I/O sockets) keep a multishot
+ *  recvmsg posted and TCP connections a recv, which is posted again after each
+ *  completion unless reading is paused by EventLoopWatchWritable. Both receive
+ *  into a ring of buffers provided to the kernel. All other sockets keep a multishot
+ *  poll posted. Sends are queued as
+ *  submission queue entries and submitted together with the wait for the next
+ *  completions, so one loop iteration costs a single system call regardless of
+ *  the number of received and sent packets. The sends of a TCP connection are
+ *  kept in a queue of their own, only its first send is posted so that the
+ *  data leaves in order.
+ *
+ *  The backend uses the raw system call interface of linux/io_uring.h and
+ *  needs Linux 6.0 or newer (multishot recvmsg, provided buffer rings).
+ */
+
+#define _GNU_SOURCE /* syscall() */
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "generic_networkhandler.h"
+
+#include "opener_error.h"
+#include "trace.h"
+
+#ifndef OPENER_IO_URING_QUEUE_DEPTH
+/** @brief Number of submission queue entries */
+#define OPENER_IO_URING_QUEUE_DEPTH 256
+#endif
+
+#ifndef OPENER_IO_URING_RECEIVE_BUFFERS
+/** @brief Number of receive buffers provided to the kernel, power of two */
+#define OPENER_IO_URING_RECEIVE_BUFFERS 64
+#endif
+
+#ifndef OPENER_IO_URING_SEND_SLOTS
+/** @brief Number of sends which may be queued at the same time */
+#define OPENER_IO_URING_SEND_SLOTS 64
+#endif
+
+#ifndef OPENER_IO_URING_STREAM_SEND_SLOTS
+/** @brief Number of send slots a single TCP connection may occupy, so that a
+ * peer not reading its replies cannot take all of them */
+#define OPENER_IO_URING_STREAM_SEND_SLOTS (OPENER_IO_URING_SEND_SLOTS / 4)
+#endif
+
+/** @brief Buffer group of the provided receive buffers */
+static const int kIoUringReceiveBufferGroup = 0;
+
+/** @brief Size of a provided receive buffer
+ *
+ * The kernel places the recvmsg header and the sender address in front of the
+ * payload, the payload keeps PC_OPENER_UDP_BUFFER_SIZE bytes so that replies
+ * can be assembled in place.
+ */
+#define IO_URING_RECEIVE_BUFFER_SIZE (sizeof(struct io_uring_recvmsg_out) \
+    + sizeof(struct sockaddr_in) + PC_OPENER_UDP_BUFFER_SIZE)
+
+/** @brief Kind of request a completion belongs to, stored in the user data */
+typedef enum {
+  kIoUringRequestPoll = 1,
+  kIoUringRequestReceive = 2,
+  kIoUringRequestSend = 3,
+  kIoUringRequestCancel = 4,
+  kIoUringRequestStreamReceive = 5,
+  kIoUringRequestStreamSend = 6
+} IoUringRequestType;
+
+/** @brief A queued send, owns a copy of the data until its completion */
+typedef struct IoUringSendSlot {
+  EipBool8 in_use;
+  size_t data_length;
+  struct sockaddr_in address;
+  struct iovec io_vector;
+  struct msghdr message_header;
+  int socket; /**< the TCP socket of a stream send */
+  size_t sent_length; /**< bytes of a stream send which have been sent */
+  struct IoUringSendSlot *next; /**< the next stream send of the socket */
+  EipUint8 data[PC_OPENER_ETHERNET_BUFFER_SIZE];
+} IoUringSendSlot;
+
+/** @brief Handler registration of a socket, indexed by the descriptor */
+typedef struct {
+  SocketEventHandler handler; /**< readiness handler, served by multishot poll */
+  DatagramEventHandler datagram_handler; /**< datagram handler, served by multishot recvmsg */
+  StreamEventHandler stream_handler; /**< stream handler, served by a recv posted again after each completion */
+  SocketEventHandler writable_handler; /**< if set, reading is paused until the socket can queue a send again */
+  EipBool8 is_receiving; /**< a recv of the stream handler is posted */
+  IoUringSendSlot *first_send; /**< the posted stream send, the others wait in the queue */
+  IoUringSendSlot *last_send;
+  int number_of_sends; /**< number of queued stream sends */
+  EipBool8 is_send_failed; /**< a stream send failed, the stream is broken */
+  EipUint32 generation; /**< incremented on each (un)registration, to detect stale completions */
+} IoUringSocketRegistration;
+
+/** @brief Mapped rings and state of the io_uring instance */
+typedef struct {
+  int ring_handle;
+
+  void *submission_ring;
+  size_t submission_ring_size;
+  unsigned *submission_head;
+  unsigned *submission_tail;
+  unsigned submission_ring_mask;
+  unsigned submission_ring_entries;
+  struct io_uring_sqe *submission_entries;
+  unsigned submission_local_tail; /**< tail including not yet submitted entries */
+  unsigned submission_submitted_tail; /**< tail handed to the kernel */
+
+  void *completion_ring;
+  size_t completion_ring_size;
+  unsigned *completion_head;
+  unsigned *completion_tail;
+  unsigned completion_ring_mask;
+  unsigned completion_ring_entries;
+  struct io_uring_cqe *completion_entries;
+
+  struct io_uring_buf_ring *receive_buffer_ring;
+  EipUint16 receive_buffer_ring_tail;
+  EipUint8 *receive_buffers;
+} IoUring;
+
+static IoUring g_io_uring = { .ring_handle = -1 };
+
+static IoUringSocketRegistration *g_io_uring_registrations = NULL;
+static size_t g_number_of_io_uring_registrations = 0;
+
+static IoUringSendSlot g_io_uring_send_slots[OPENER_IO_URING_SEND_SLOTS];
+
+/** @brief Number of sockets waiting to queue a stream send, see
+ * EventLoopWatchWritable */
+static int g_number_of_io_uring_send_waiters = 0;
+
+/** @brief Message header template for the multishot recvmsg requests, only
+ * the name and control lengths are evaluated by the kernel */
+static struct msghdr g_io_uring_receive_message_header = { .msg_namelen =
+    sizeof(struct sockaddr_in) };
+
+static uint64_t EncodeIoUringUserData(IoUringRequestType type,
+                                       EipUint32 generation, int index) {
+  return ((uint64_t) type << 56)
+      | ((uint64_t) (generation & 0x00FFFFFFU) << 32) | (EipUint32) index;
+}
+
+static IoUringRequestType GetIoUringRequestType(uint64_t user_data) {
+  return (IoUringRequestType) (user_data >> 56);
+}
+
+static EipUint32 GetIoUringGeneration(uint64_t user_data) {
+  return (EipUint32) ((user_data >> 32) & 0x00FFFFFFU);
+}
+
+static int GetIoUringIndex(uint64_t user_data) {
+  return (int) (user_data & 0xFFFFFFFFU);
+}
+
+static void TraceIoUringError(const char *operation, int error_code) {
+  char* error_message = GetErrorMessage(error_code);
+  OPENER_TRACE_ERR("networkhandler: io_uring %s failed: %d - %s\n", operation,
+                   error_code, error_message);
+  free(error_message);
+  (void) operation; /* only used by the traces */
+}
+
+/** @brief Hands all queued submission entries to the kernel, optionally waiting
+ * for completions
+ *
+ * @param wait_for_completion wait for at least one completion
+ * @param timeout maximum wait time in microseconds
+ * @return kEipStatusOk on success (also on timeout or interruption),
+ * kEipStatusError otherwise
+ */
+static EipStatus EnterIoUring(EipBool8 wait_for_completion,
+                              MicroSeconds timeout) {
+  unsigned number_to_submit = g_io_uring.submission_local_tail
+      - g_io_uring.submission_submitted_tail;
+  if ((0 == number_to_submit) && !wait_for_completion) {
+    return kEipStatusOk;
+  }
+
+  __atomic_store_n(g_io_uring.submission_tail, g_io_uring.submission_local_tail,
+                   __ATOMIC_RELEASE);
+  g_io_uring.submission_submitted_tail = g_io_uring.submission_local_tail;
+
+  struct __kernel_timespec timeout_value = { .tv_sec = timeout / 1000000,
+      .tv_nsec = (timeout % 1000000) * 1000 };
+  struct io_uring_getevents_arg wait_arguments = { .ts =
+      (uint64_t) (uintptr_t) &timeout_value };
+
+  unsigned flags = 0;
+  unsigned minimum_completions = 0;
+  void *arguments = NULL;
+  size_t arguments_size = 0;
+  if (wait_for_completion) {
+    flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    minimum_completions = 1;
+    arguments = &wait_arguments;
+    arguments_size = sizeof(wait_arguments);
+  }
+
+  if (0
+      > syscall(__NR_io_uring_enter, g_io_uring.ring_handle, number_to_submit,
+                minimum_completions, flags, arguments, arguments_size)) {
+    int error_code = GetSocketErrorNumber();
+    if ((EINTR == error_code) || (ETIME == error_code)
+        || (EBUSY == error_code) || (EAGAIN == error_code)) {
+      return kEipStatusOk; /* completions are reaped by the caller */
+    }
+    TraceIoUringError("enter", error_code);
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+/** @brief Returns a cleared submission queue entry, submits the queued entries
+ * if the submission queue is full
+ *
+ * @return The entry or NULL if the queue is still full
+ */
+static struct io_uring_sqe *GetIoUringSubmissionEntry(void) {
+  unsigned head = __atomic_load_n(g_io_uring.submission_head,
+                                  __ATOMIC_ACQUIRE);
+  if (g_io_uring.submission_local_tail - head
+      >= g_io_uring.submission_ring_entries) {
+    EnterIoUring(false, 0);
+    head = __atomic_load_n(g_io_uring.submission_head, __ATOMIC_ACQUIRE);
+    if (g_io_uring.submission_local_tail - head
+        >= g_io_uring.submission_ring_entries) {
+      OPENER_TRACE_ERR("networkhandler: io_uring submission queue full\n");
+      return NULL;
+    }
+  }
+
+  struct io_uring_sqe *entry = &g_io_uring.submission_entries[g_io_uring
+      .submission_local_tail & g_io_uring.submission_ring_mask];
+  memset(entry, 0, sizeof(*entry));
+  g_io_uring.submission_local_tail++;
+  return entry;
+}
+
+/** @brief Gives a receive buffer back to the kernel */
+static void RecycleIoUringReceiveBuffer(EipUint16 buffer_id) {
+  struct io_uring_buf *buffer =
+      &g_io_uring.receive_buffer_ring->bufs[g_io_uring.receive_buffer_ring_tail
+          & (OPENER_IO_URING_RECEIVE_BUFFERS - 1)];
+  buffer->addr = (uint64_t) (uintptr_t) (g_io_uring.receive_buffers
+      + buffer_id * IO_URING_RECEIVE_BUFFER_SIZE);
+  buffer->len = IO_URING_RECEIVE_BUFFER_SIZE;
+  buffer->bid = buffer_id;
+  g_io_uring.receive_buffer_ring_tail++;
+  __atomic_store_n(&g_io_uring.receive_buffer_ring->tail,
+                   g_io_uring.receive_buffer_ring_tail, __ATOMIC_RELEASE);
+}
+
+static EipBool8 IsIoUringSocketRegistered(int socket) {
+  return (0 <= socket) && ((size_t) socket < g_number_of_io_uring_registrations)
+      && ((NULL != g_io_uring_registrations[socket].handler)
+          || (NULL != g_io_uring_registrations[socket].datagram_handler)
+          || (NULL != g_io_uring_registrations[socket].stream_handler));
+}
+
+/** @brief Converts poll events into the mask of a poll request */
+static EipUint32 GetIoUringPollMask(EipUint32 events) {
+  if (kOpENerEndianessBig == GetEndianess()) { /* the kernel expects the 32 bit mask in little endian half words */
+    events = (events << 16) | (events >> 16);
+  }
+  return events;
+}
+
+/** @brief Posts the request serving the registration of the socket
+ *
+ * @param socket A registered socket
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+static EipStatus ArmIoUringSocket(int socket) {
+  IoUringSocketRegistration *registration = &g_io_uring_registrations[socket];
+  struct io_uring_sqe *entry = GetIoUringSubmissionEntry();
+  if (NULL == entry) {
+    return kEipStatusError;
+  }
+
+  entry->fd = socket;
+  if (NULL != registration->datagram_handler) {
+    entry->opcode = IORING_OP_RECVMSG;
+    entry->addr = (uint64_t) (uintptr_t) &g_io_uring_receive_message_header;
+    entry->len = 1;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = kIoUringReceiveBufferGroup;
+    entry->user_data = EncodeIoUringUserData(kIoUringRequestReceive,
+                                             registration->generation, socket);
+  } else if (NULL != registration->stream_handler) {
+    /* a single recv, so at most one chunk arrives after reading is paused */
+    entry->opcode = IORING_OP_RECV;
+    entry->len = PC_OPENER_UDP_BUFFER_SIZE;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    registration->is_receiving = true;
+    entry->buf_group = kIoUringReceiveBufferGroup;
+    entry->user_data = EncodeIoUringUserData(kIoUringRequestStreamReceive,
+                                             registration->generation, socket);
+  } else {
+    entry->opcode = IORING_OP_POLL_ADD;
+    entry->poll32_events = GetIoUringPollMask(POLLIN);
+    entry->len = IORING_POLL_ADD_MULTI;
+    entry->user_data = EncodeIoUringUserData(kIoUringRequestPoll,
+                                             registration->generation, socket);
+  }
+  return kEipStatusOk;
+}
+
+/** @brief Ensures that the registration table can hold the given descriptor */
+static EipStatus ReserveIoUringRegistration(int socket) {
+  if ((size_t) socket < g_number_of_io_uring_registrations) {
+    return kEipStatusOk;
+  }
+
+  size_t new_size =
+      g_number_of_io_uring_registrations ?
+          g_number_of_io_uring_registrations : 64;
+  while (new_size <= (size_t) socket) {
+    new_size *= 2;
+  }
+
+  IoUringSocketRegistration *new_registrations = realloc(
+      g_io_uring_registrations, new_size * sizeof(IoUringSocketRegistration));
+  if (NULL == new_registrations) {
+    OPENER_TRACE_ERR("networkhandler: no memory for io_uring registrations\n");
+    return kEipStatusError;
+  }
+  memset(&new_registrations[g_number_of_io_uring_registrations], 0,
+         (new_size - g_number_of_io_uring_registrations)
+             * sizeof(IoUringSocketRegistration));
+
+  g_io_uring_registrations = new_registrations;
+  g_number_of_io_uring_registrations = new_size;
+  return kEipStatusOk;
+}
+
+static EipStatus AddIoUringSocket(int socket, SocketEventHandler handler,
+                                  DatagramEventHandler datagram_handler,
+                                  StreamEventHandler stream_handler) {
+  if ((0 > socket) || (kEipStatusOk != ReserveIoUringRegistration(socket))) {
+    return kEipStatusError;
+  }
+
+  EventLoopRemoveSocket(socket); /* cancels the requests of a former registration */
+
+  g_io_uring_registrations[socket].generation++;
+  g_io_uring_registrations[socket].handler = handler;
+  g_io_uring_registrations[socket].datagram_handler = datagram_handler;
+  g_io_uring_registrations[socket].stream_handler = stream_handler;
+  g_io_uring_registrations[socket].writable_handler = NULL;
+  g_io_uring_registrations[socket].is_receiving = false;
+  g_io_uring_registrations[socket].is_send_failed = false;
+
+  if (kEipStatusOk != ArmIoUringSocket(socket)) {
+    g_io_uring_registrations[socket].handler = NULL;
+    g_io_uring_registrations[socket].datagram_handler = NULL;
+    g_io_uring_registrations[socket].stream_handler = NULL;
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+/** @brief Maps the rings of a freshly set up io_uring instance
+ *
+ * @param parameters The parameters returned by io_uring_setup
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+static EipStatus MapIoUringRings(struct io_uring_params *parameters) {
+  g_io_uring.submission_ring_size = parameters->sq_off.array
+      + parameters->sq_entries * sizeof(unsigned);
+  g_io_uring.completion_ring_size = parameters->cq_off.cqes
+      + parameters->cq_entries * sizeof(struct io_uring_cqe);
+  if (g_io_uring.completion_ring_size > g_io_uring.submission_ring_size) {
+    g_io_uring.submission_ring_size = g_io_uring.completion_ring_size;
+  }
+  g_io_uring.completion_ring_size = g_io_uring.submission_ring_size; /* both rings share one mapping */
+
+  g_io_uring.submission_ring = mmap(NULL, g_io_uring.submission_ring_size,
+                                    PROT_READ | PROT_WRITE, MAP_SHARED,
+                                    g_io_uring.ring_handle,
+                                    IORING_OFF_SQ_RING);
+  if (MAP_FAILED == g_io_uring.submission_ring) {
+    g_io_uring.submission_ring = NULL;
+    return kEipStatusError;
+  }
+  g_io_uring.completion_ring = g_io_uring.submission_ring;
+
+  g_io_uring.submission_entries = mmap(
+      NULL, parameters->sq_entries * sizeof(struct io_uring_sqe),
+      PROT_READ | PROT_WRITE, MAP_SHARED, g_io_uring.ring_handle,
+      IORING_OFF_SQES);
+  if (MAP_FAILED == g_io_uring.submission_entries) {
+    g_io_uring.submission_entries = NULL;
+    return kEipStatusError;
+  }
+
+  EipUint8 *submission_ring = g_io_uring.submission_ring;
+  g_io_uring.submission_head = (unsigned *) (submission_ring
+      + parameters->sq_off.head);
+  g_io_uring.submission_tail = (unsigned *) (submission_ring
+      + parameters->sq_off.tail);
+  g_io_uring.submission_ring_mask = *(unsigned *) (submission_ring
+      + parameters->sq_off.ring_mask);
+  g_io_uring.submission_ring_entries = parameters->sq_entries;
+
+  /* submission entries are always used in ring order */
+  unsigned *submission_array = (unsigned *) (submission_ring
+      + parameters->sq_off.array);
+  for (unsigned i = 0; i < parameters->sq_entries; i++) {
+    submission_array[i] = i;
+  }
+  g_io_uring.submission_local_tail = *g_io_uring.submission_tail;
+  g_io_uring.submission_submitted_tail = g_io_uring.submission_local_tail;
+
+  EipUint8 *completion_ring = g_io_uring.completion_ring;
+  g_io_uring.completion_head = (unsigned *) (completion_ring
+      + parameters->cq_off.head);
+  g_io_uring.completion_tail = (unsigned *) (completion_ring
+      + parameters->cq_off.tail);
+  g_io_uring.completion_ring_mask = *(unsigned *) (completion_ring
+      + parameters->cq_off.ring_mask);
+  g_io_uring.completion_ring_entries = parameters->cq_entries;
+  g_io_uring.completion_entries = (struct io_uring_cqe *) (completion_ring
+      + parameters->cq_off.cqes);
+  return kEipStatusOk;
+}
+
+/** @brief Allocates the receive buffers and registers them as provided buffer
+ * ring with the kernel
+ *
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+static EipStatus SetupIoUringReceiveBuffers(void) {
+  void *buffer_ring = NULL;
+  if (0
+      != posix_memalign(
+          &buffer_ring, sysconf(_SC_PAGESIZE),
+          OPENER_IO_URING_RECEIVE_BUFFERS * sizeof(struct io_uring_buf))) {
+    return kEipStatusError;
+  }
+  memset(buffer_ring, 0,
+         OPENER_IO_URING_RECEIVE_BUFFERS * sizeof(struct io_uring_buf));
+  g_io_uring.receive_buffer_ring = buffer_ring;
+
+  g_io_uring.receive_buffers = malloc(
+      OPENER_IO_URING_RECEIVE_BUFFERS * IO_URING_RECEIVE_BUFFER_SIZE);
+  if (NULL == g_io_uring.receive_buffers) {
+    return kEipStatusError;
+  }
+
+  struct io_uring_buf_reg buffer_registration = { .ring_addr =
+      (uint64_t) (uintptr_t) buffer_ring, .ring_entries =
+      OPENER_IO_URING_RECEIVE_BUFFERS, .bgid = kIoUringReceiveBufferGroup };
+  if (0
+      > syscall(__NR_io_uring_register, g_io_uring.ring_handle,
+                IORING_REGISTER_PBUF_RING, &buffer_registration, 1)) {
+    return kEipStatusError;
+  }
+
+  g_io_uring.receive_buffer_ring_tail = 0;
+  for (EipUint16 i = 0; i < OPENER_IO_URING_RECEIVE_BUFFERS; i++) {
+    RecycleIoUringReceiveBuffer(i);
+  }
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopInitialize(void) {
+  struct io_uring_params parameters;
+  memset(&parameters, 0, sizeof(parameters));
+  parameters.flags = IORING_SETUP_SUBMIT_ALL;
+
+  g_io_uring.ring_handle = syscall(__NR_io_uring_setup,
+                                   OPENER_IO_URING_QUEUE_DEPTH, &parameters);
+  if (0 > g_io_uring.ring_handle) {
+    g_io_uring.ring_handle = -1;
+    TraceIoUringError("setup", GetSocketErrorNumber());
+    return kEipStatusError;
+  }
+
+  if (!(parameters.features & IORING_FEAT_SINGLE_MMAP)
+      || !(parameters.features & IORING_FEAT_EXT_ARG)) {
+    OPENER_TRACE_ERR("networkhandler: kernel io_uring support is too old\n");
+    EventLoopShutdown();
+    return kEipStatusError;
+  }
+
+  if ((kEipStatusOk != MapIoUringRings(&parameters))
+      || (kEipStatusOk != SetupIoUringReceiveBuffers())) {
+    TraceIoUringError("ring setup", GetSocketErrorNumber());
+    EventLoopShutdown();
+    return kEipStatusError;
+  }
+
+  for (int i = 0; i < OPENER_IO_URING_SEND_SLOTS; i++) {
+    g_io_uring_send_slots[i].in_use = false;
+  }
+  return kEipStatusOk;
+}
+
+void EventLoopShutdown(void) {
+  if (-1 != g_io_uring.ring_handle) {
+    EnterIoUring(false, 0); /* hand out the queued sends */
+    close(g_io_uring.ring_handle);
+  }
+  if (NULL != g_io_uring.submission_entries) {
+    munmap(g_io_uring.submission_entries,
+           g_io_uring.submission_ring_entries * sizeof(struct io_uring_sqe));
+  }
+  if (NULL != g_io_uring.submission_ring) {
+    munmap(g_io_uring.submission_ring, g_io_uring.submission_ring_size);
+  }
+  free(g_io_uring.receive_buffer_ring);
+  free(g_io_uring.receive_buffers);
+  memset(&g_io_uring, 0, sizeof(g_io_uring));
+  g_io_uring.ring_handle = -1;
+
+  free(g_io_uring_registrations);
+  g_io_uring_registrations = NULL;
+  g_number_of_io_uring_registrations = 0;
+  g_number_of_io_uring_send_waiters = 0;
+}
+
+EipStatus EventLoopAddSocket(int socket, SocketEventHandler handler) {
+  return AddIoUringSocket(socket, handler, NULL, NULL);
+}
+
+EipStatus EventLoopAddDatagramSocket(int socket, DatagramEventHandler handler) {
+  return AddIoUringSocket(socket, NULL, handler, NULL);
+}
+
+EipStatus EventLoopAddStreamSocket(int socket, StreamEventHandler handler) {
+  return AddIoUringSocket(socket, NULL, NULL, handler);
+}
+
+/** @brief Releases the queued stream sends of the socket
+ *
+ * A posted send is released by its completion, which finds that it is no
+ * longer the first send of the socket.
+ *
+ * @param registration The registration of the socket
+ * @param is_first_posted the first send is posted
+ */
+static void DropIoUringStreamSends(IoUringSocketRegistration *registration,
+                                   EipBool8 is_first_posted) {
+  for (IoUringSendSlot *slot = registration->first_send; NULL != slot;
+      slot = slot->next) {
+    if ((slot != registration->first_send) || !is_first_posted) {
+      slot->in_use = false;
+    }
+  }
+  registration->first_send = NULL;
+  registration->last_send = NULL;
+  registration->number_of_sends = 0;
+}
+
+/** @brief Stops waiting for a send slot, see EventLoopWatchWritable */
+static SocketEventHandler TakeIoUringSendWaiter(
+    IoUringSocketRegistration *registration) {
+  SocketEventHandler writable_handler = registration->writable_handler;
+  if (NULL != writable_handler) {
+    registration->writable_handler = NULL;
+    g_number_of_io_uring_send_waiters--;
+  }
+  return writable_handler;
+}
+
+void EventLoopRemoveSocket(int socket) {
+  if (!IsIoUringSocketRegistered(socket)) {
+    return; /* not registered */
+  }
+
+  IoUringSocketRegistration *registration = &g_io_uring_registrations[socket];
+  registration->handler = NULL;
+  registration->datagram_handler = NULL;
+  registration->stream_handler = NULL;
+  TakeIoUringSendWaiter(registration);
+  registration->generation++;
+  /* the descriptor may be reused, the stream sends end with the session */
+  DropIoUringStreamSends(registration, true);
+
+  /* Queued datagram sends have to reach the socket before it is closed, and
+   * the posted requests hold a reference to the socket until they are
+   * canceled */
+  EnterIoUring(false, 0);
+  struct io_uring_sqe *entry = GetIoUringSubmissionEntry();
+  if (NULL != entry) {
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = socket;
+    entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    entry->user_data = EncodeIoUringUserData(kIoUringRequestCancel, 0, socket);
+  }
+  EnterIoUring(false, 0);
+}
+
+static IoUringSendSlot *GetFreeIoUringSendSlot(size_t data_length);
+
+/** @brief Checks if a stream send of the socket can be queued, a broken
+ * stream takes sends to report the failure */
+static EipBool8 CanQueueIoUringStreamSend(
+    const IoUringSocketRegistration *registration) {
+  if (registration->is_send_failed) {
+    return true;
+  }
+  return (OPENER_IO_URING_STREAM_SEND_SLOTS > registration->number_of_sends)
+      && (NULL != GetFreeIoUringSendSlot(0));
+}
+
+EipStatus EventLoopWatchWritable(int socket, SocketEventHandler handler) {
+  if (!IsIoUringSocketRegistered(socket)) {
+    return kEipStatusError;
+  }
+  /* The socket can take data as soon as it can queue a send again, the
+   * waiters are served by ResumeIoUringSendWaiters instead of a poll. The recv
+   * is not posted again, the one posted may still hand over data. */
+  if (NULL == g_io_uring_registrations[socket].writable_handler) {
+    g_number_of_io_uring_send_waiters++;
+  }
+  g_io_uring_registrations[socket].writable_handler = handler;
+  return kEipStatusOk;
+}
+
+/** @brief Resumes the sockets waiting for EventLoopWatchWritable which can
+ * queue a send again */
+static void ResumeIoUringSendWaiters(void) {
+  for (int socket = 0;
+      (0 < g_number_of_io_uring_send_waiters)
+          && ((size_t) socket < g_number_of_io_uring_registrations);
+      socket++) {
+    IoUringSocketRegistration *registration =
+        &g_io_uring_registrations[socket];
+    if ((NULL != registration->writable_handler)
+        && CanQueueIoUringStreamSend(registration)) {
+      SocketEventHandler writable_handler = TakeIoUringSendWaiter(
+          registration);
+      EipUint32 generation = registration->generation;
+      writable_handler(socket);
+      /* reading is resumed afterwards, a recv posted before would still
+       * complete if the handler pauses reading again */
+      if ((generation == registration->generation)
+          && (NULL == registration->writable_handler)
+          && !registration->is_receiving) {
+        ArmIoUringSocket(socket);
+      }
+    }
+  }
+}
+
+/** @brief Handles the completion of a multishot recvmsg
+ *
+ * @return 1 if a datagram has been handed to the handler, 0 otherwise
+ */
+static int HandleIoUringReceiveCompletion(struct io_uring_cqe *completion) {
+  int number_of_datagrams = 0;
+  int socket = GetIoUringIndex(completion->user_data);
+  EipBool8 is_current = IsIoUringSocketRegistered(socket)
+      && (GetIoUringGeneration(completion->user_data)
+          == (g_io_uring_registrations[socket].generation & 0x00FFFFFFU));
+
+  if (completion->flags & IORING_CQE_F_BUFFER) {
+    EipUint16 buffer_id = completion->flags >> IORING_CQE_BUFFER_SHIFT;
+    EipUint8 *buffer = g_io_uring.receive_buffers
+        + buffer_id * IO_URING_RECEIVE_BUFFER_SIZE;
+    struct io_uring_recvmsg_out *message = (struct io_uring_recvmsg_out *) buffer;
+    struct sockaddr_in *from_address = (struct sockaddr_in *) (message + 1);
+    EipUint8 *payload = (EipUint8 *) (message + 1) + sizeof(struct sockaddr_in)
+        + message->controllen;
+
+    if (is_current && (0 <= completion->res)) {
+      if (message->flags & MSG_TRUNC) {
+        OPENER_TRACE_WARN(
+            "networkhandler: too large datagram on socket %d dropped\n",
+            socket);
+      } else if (0 < message->payloadlen) { /* empty datagrams carry nothing to handle */
+        g_io_uring_registrations[socket].datagram_handler(
+            socket, from_address, payload, message->payloadlen);
+        number_of_datagrams = 1;
+      }
+    }
+    RecycleIoUringReceiveBuffer(buffer_id);
+  } else if (is_current && (-ENOBUFS != completion->res)) {
+    struct sockaddr_in from_address = { 0 };
+    errno = -completion->res; /* for GetSocketErrorNumber in the handler */
+    g_io_uring_registrations[socket].datagram_handler(socket, &from_address,
+                                                      NULL, -1);
+  }
+
+  /* the request has ended (e.g., out of buffers), post a new one */
+  if (!(completion->flags & IORING_CQE_F_MORE) && is_current
+      && IsIoUringSocketRegistered(socket)
+      && (GetIoUringGeneration(completion->user_data)
+          == (g_io_uring_registrations[socket].generation & 0x00FFFFFFU))) {
+    ArmIoUringSocket(socket);
+  }
+  return number_of_datagrams;
+}
+
+/** @brief Handles the completion of a recv on a stream socket */
+static void HandleIoUringStreamReceiveCompletion(
+    struct io_uring_cqe *completion) {
+  int socket = GetIoUringIndex(completion->user_data);
+  EipUint32 generation = GetIoUringGeneration(completion->user_data);
+  EipBool8 is_current = IsIoUringSocketRegistered(socket)
+      && (generation
+          == (g_io_uring_registrations[socket].generation & 0x00FFFFFFU));
+  if (is_current) {
+    g_io_uring_registrations[socket].is_receiving = false;
+  }
+
+  if (completion->flags & IORING_CQE_F_BUFFER) {
+    EipUint16 buffer_id = completion->flags >> IORING_CQE_BUFFER_SHIFT;
+    if (is_current) {
+      g_io_uring_registrations[socket].stream_handler(
+          socket,
+          g_io_uring.receive_buffers + buffer_id * IO_URING_RECEIVE_BUFFER_SIZE,
+          completion->res);
+    }
+    RecycleIoUringReceiveBuffer(buffer_id);
+  } else if (is_current && (-ENOBUFS != completion->res)) {
+    if (0 > completion->res) {
+      errno = -completion->res; /* for GetSocketErrorNumber in the handler */
+    }
+    g_io_uring_registrations[socket].stream_handler(socket, NULL,
+                                                    completion->res); /* closed by the peer or failed */
+    return;
+  }
+
+  if (IsIoUringSocketRegistered(socket)
+      && (generation
+          == (g_io_uring_registrations[socket].generation & 0x00FFFFFFU))
+      && (NULL == g_io_uring_registrations[socket].writable_handler)
+      && !g_io_uring_registrations[socket].is_receiving) {
+    ArmIoUringSocket(socket);
+  }
+}
+
+/** @brief Handles the completion of a multishot poll */
+static void HandleIoUringPollCompletion(struct io_uring_cqe *completion) {
+  int socket = GetIoUringIndex(completion->user_data);
+  EipUint32 generation = GetIoUringGeneration(completion->user_data);
+
+  if (!IsIoUringSocketRegistered(socket)
+      || (generation
+          != (g_io_uring_registrations[socket].generation & 0x00FFFFFFU))) {
+    OPENER_TRACE_INFO("socket: %d closed with pending message\n", socket);
+    return;
+  }
+
+  if (0 <= completion->res) {
+    g_io_uring_registrations[socket].handler(socket);
+  }
+
+  if (!(completion->flags & IORING_CQE_F_MORE)
+      && IsIoUringSocketRegistered(socket)
+      && (generation
+          == (g_io_uring_registrations[socket].generation & 0x00FFFFFFU))) {
+    ArmIoUringSocket(socket);
+  }
+}
+
+/** @brief Posts the part of a stream send which has not been sent yet */
+static EipStatus PostIoUringStreamSend(IoUringSendSlot *slot) {
+  struct io_uring_sqe *entry = GetIoUringSubmissionEntry();
+  if (NULL == entry) {
+    return kEipStatusError;
+  }
+  entry->opcode = IORING_OP_SEND;
+  entry->fd = slot->socket;
+  entry->addr = (uint64_t) (uintptr_t) &slot->data[slot->sent_length];
+  entry->len = slot->data_length - slot->sent_length;
+  entry->msg_flags = MSG_WAITALL; /* let the kernel retry short sends */
+  entry->user_data = EncodeIoUringUserData(kIoUringRequestStreamSend, 0,
+                                           slot - g_io_uring_send_slots);
+  return kEipStatusOk;
+}
+
+/** @brief Handles the completion of the first stream send of a socket and
+ * posts the next one */
+static void HandleIoUringStreamSendCompletion(struct io_uring_cqe *completion) {
+  IoUringSendSlot *slot = &g_io_uring_send_slots[GetIoUringIndex(
+      completion->user_data)];
+  IoUringSocketRegistration *registration =
+      &g_io_uring_registrations[slot->socket];
+
+  if (slot != registration->first_send) {
+    slot->in_use = false; /* the socket has been removed meanwhile */
+    return;
+  }
+
+  EipStatus status = kEipStatusError;
+  if (0 > completion->res) {
+    TraceIoUringError("send", -completion->res);
+  } else if (0 < completion->res) {
+    slot->sent_length += completion->res;
+    if (slot->sent_length < slot->data_length) {
+      status = PostIoUringStreamSend(slot); /* the rest goes before the next send */
+    } else {
+      registration->first_send = slot->next;
+      registration->number_of_sends--;
+      slot->in_use = false;
+      status = kEipStatusOk;
+      if (NULL == registration->first_send) {
+        registration->last_send = NULL;
+      } else {
+        status = PostIoUringStreamSend(registration->first_send);
+      }
+    }
+  }
+
+  if (kEipStatusOk != status) {
+    /* a gap in the stream breaks the framing, the next send reports it */
+    OPENER_TRACE_ERR("networkhandler: stream on fd %d is broken\n",
+                     slot->socket);
+    registration->is_send_failed = true;
+    DropIoUringStreamSends(registration, false);
+  }
+}
+
+/** @brief Releases the send slot of a completed datagram send */
+static void HandleIoUringSendCompletion(struct io_uring_cqe *completion) {
+  IoUringSendSlot *slot = &g_io_uring_send_slots[GetIoUringIndex(
+      completion->user_data)];
+
+  if (0 > completion->res) {
+    TraceIoUringError("send", -completion->res);
+  } else if ((size_t) completion->res != slot->data_length) {
+    OPENER_TRACE_WARN(
+        "networkhandler: not all data was sent, sent %d of %d\n",
+        completion->res, (int) slot->data_length);
+  }
+  slot->in_use = false;
+}
+
+EipStatus EventLoopDispatchEvents(MicroSeconds timeout) {
+  if (kEipStatusOk != EnterIoUring(true, timeout)) {
+    return kEipStatusError;
+  }
+
+  /* Completions are copied and consumed one by one, as handlers may queue new
+   * requests. The number is bounded so that the timers are served in time. */
+  int number_of_datagrams = 0;
+  unsigned head = *g_io_uring.completion_head;
+  for (unsigned i = 0; i < g_io_uring.completion_ring_entries; i++) {
+    if (head == __atomic_load_n(g_io_uring.completion_tail, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    struct io_uring_cqe completion = g_io_uring.completion_entries[head
+        & g_io_uring.completion_ring_mask];
+    head++;
+    __atomic_store_n(g_io_uring.completion_head, head, __ATOMIC_RELEASE);
+
+    switch (GetIoUringRequestType(completion.user_data)) {
+      case kIoUringRequestReceive:
+        number_of_datagrams += HandleIoUringReceiveCompletion(&completion);
+        break;
+      case kIoUringRequestStreamReceive:
+        HandleIoUringStreamReceiveCompletion(&completion);
+        break;
+      case kIoUringRequestPoll:
+        HandleIoUringPollCompletion(&completion);
+        break;
+      case kIoUringRequestSend:
+        HandleIoUringSendCompletion(&completion);
+        break;
+      case kIoUringRequestStreamSend:
+        HandleIoUringStreamSendCompletion(&completion);
+        break;
+      default: /* nothing to do for cancellations */
+        break;
+    }
+  }
+  CountDrainedDatagrams(number_of_datagrams);
+  ResumeIoUringSendWaiters();
+  return kEipStatusOk;
+}
+
+/** @brief Returns a free send slot or NULL if all sends slots are in use */
+static IoUringSendSlot *GetFreeIoUringSendSlot(size_t data_length) {
+  if (data_length > sizeof(g_io_uring_send_slots[0].data)) {
+    return NULL;
+  }
+  for (int i = 0; i < OPENER_IO_URING_SEND_SLOTS; i++) {
+    if (!g_io_uring_send_slots[i].in_use) {
+      return &g_io_uring_send_slots[i];
+    }
+  }
+  return NULL;
+}
+
+/** @brief Queues a datagram send of the given slot
+ *
+ * @param socket The socket to send on
+ * @param slot The filled send slot
+ * @return kEipStatusOk on success, kEipStatusError if the submission queue is full
+ */
+static EipStatus QueueIoUringSend(int socket, IoUringSendSlot *slot) {
+  struct io_uring_sqe *entry = GetIoUringSubmissionEntry();
+  if (NULL == entry) {
+    return kEipStatusError;
+  }
+
+  slot->io_vector.iov_base = slot->data;
+  slot->io_vector.iov_len = slot->data_length;
+  memset(&slot->message_header, 0, sizeof(slot->message_header));
+  slot->message_header.msg_name = &slot->address;
+  slot->message_header.msg_namelen = sizeof(slot->address);
+  slot->message_header.msg_iov = &slot->io_vector;
+  slot->message_header.msg_iovlen = 1;
+  entry->fd = socket;
+  entry->opcode = IORING_OP_SENDMSG;
+  entry->addr = (uint64_t) (uintptr_t) &slot->message_header;
+  entry->len = 1;
+  entry->user_data = EncodeIoUringUserData(kIoUringRequestSend, 0,
+                                           slot - g_io_uring_send_slots);
+  slot->in_use = true;
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopSendDatagram(int socket, struct sockaddr_in *address,
+                                EipUint8 *data, size_t data_length) {
+  IoUringSendSlot *slot = GetFreeIoUringSendSlot(data_length);
+  if (NULL != slot) {
+    memcpy(slot->data, data, data_length);
+    slot->data_length = data_length;
+    slot->address = *address;
+    if (kEipStatusOk == QueueIoUringSend(socket, slot)) {
+      return kEipStatusOk;
+    }
+  }
+  OPENER_TRACE_INFO("networkhandler: io_uring send queue exhausted\n");
+  return SendDatagramImmediately(socket, address, data, data_length);
+}
+
+EipStatus EventLoopSendGatheredDatagram(int socket,
+                                        struct sockaddr_in *address,
+                                        EipUint8 *header, size_t header_length,
+                                        EipUint8 *payload,
+                                        size_t payload_length) {
+  /* the send is deferred, so the datagram is gathered into the slot */
+  IoUringSendSlot *slot = GetFreeIoUringSendSlot(header_length
+      + payload_length);
+  if (NULL != slot) {
+    memcpy(slot->data, header, header_length);
+    if (0 < payload_length) {
+      memcpy(&slot->data[header_length], payload, payload_length);
+    }
+    slot->data_length = header_length + payload_length;
+    slot->address = *address;
+    if (kEipStatusOk == QueueIoUringSend(socket, slot)) {
+      return kEipStatusOk;
+    }
+  }
+  OPENER_TRACE_INFO("networkhandler: io_uring send queue exhausted\n");
+  return SendGatheredDatagramImmediately(socket, address, header, header_length,
+                                         payload, payload_length);
+}
+
+long EventLoopSendStream(int socket, EipUint8 *data, size_t data_length) {
+  if (!IsIoUringSocketRegistered(socket)) {
+    return SendStreamImmediately(socket, data, data_length);
+  }
+  IoUringSocketRegistration *registration = &g_io_uring_registrations[socket];
+  if (registration->is_send_failed) {
+    return -1;
+  }
+
+  /* sending around the queue would reorder the stream, the caller waits for
+   * a free slot instead */
+  IoUringSendSlot *slot = GetFreeIoUringSendSlot(data_length);
+  if ((NULL == slot)
+      || (OPENER_IO_URING_STREAM_SEND_SLOTS <= registration->number_of_sends)) {
+    return 0;
+  }
+  memcpy(slot->data, data, data_length);
+  slot->data_length = data_length;
+  slot->socket = socket;
+  slot->sent_length = 0;
+  slot->next = NULL;
+
+  if (NULL == registration->first_send) {
+    if (kEipStatusOk != PostIoUringStreamSend(slot)) {
+      return -1;
+    }
+    registration->first_send = slot;
+  } else {
+    registration->last_send->next = slot;
+  }
+  registration->last_send = slot;
+  registration->number_of_sends++;
+  slot->in_use = true;
+  return data_length;
+}
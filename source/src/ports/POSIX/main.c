@@ -24,6 +24,14 @@ void LeaveStack(int signal);
  */
 int g_end_stack = 0;
 
+#ifdef OPENER_CIP_ARENA_SIZE
+/******************************************************************************/
+/** @brief Releases the memory of the CIP objects taken from the arena of the
+ * sample application, to be called after ShutdownCipStack
+ */
+void ReleaseCipArena(void);
+#endif
+
 /******************************************************************************/
 int main(int argc, char *arg[]) {
   EipUint8 my_mac_address[6];
@@ -83,6 +91,10 @@ int main(int argc, char *arg[]) {
   }
   /* close remaining sessions and connections, cleanup used data */
   ShutdownCipStack();
+#ifdef OPENER_CIP_ARENA_SIZE
+  /* DeleteAllClasses left the arena's blocks, release them in one go */
+  ReleaseCipArena();
+#endif
 
   return -1;
 }
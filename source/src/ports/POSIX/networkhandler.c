@@ -3,6 +3,8 @@
  * All rights reserved.
  *
  ******************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <time.h>
@@ -33,3 +35,16 @@ void CloseSocketPlatform(int socket_handle) {
     shutdown(socket_handle, SHUT_RDWR);
     close(socket_handle);
 }
+
+EipStatus SetSocketToNonBlocking(int socket_handle) {
+  int flags = fcntl(socket_handle, F_GETFL, 0);
+  if ((-1 == flags)
+      || (-1 == fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK))) {
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+EipBool8 SocketErrorIsWouldBlock(int error_code) {
+  return (EAGAIN == error_code) || (EWOULDBLOCK == error_code);
+}
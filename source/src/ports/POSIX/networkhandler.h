@@ -15,6 +15,21 @@ EipStatus NetworkHandlerInitializePlatform(void);
 
 void CloseSocketPlatform(int socket_handle);
 
+/** @brief Switches the given socket to non-blocking operation
+ *
+ *  @param socket_handle The socket to be switched
+ *  @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus SetSocketToNonBlocking(int socket_handle);
+
+/** @brief Checks if a socket error number reports that a non-blocking
+ *  operation would have blocked
+ *
+ *  @param error_code The error number as returned by GetSocketErrorNumber
+ *  @return true if the operation would have blocked
+ */
+EipBool8 SocketErrorIsWouldBlock(int error_code);
+
 /** @brief This function shall return the current time in microseconds relative to epoch, and shall be implemented in a port specific networkhandler
  *
  *  @return Current time relative to epoch as MicroSeconds
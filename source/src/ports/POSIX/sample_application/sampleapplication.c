@@ -8,6 +8,13 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef OPENER_CIP_ARENA_SIZE
+#include <stdint.h>
+
+#include "arena.h"
+#include "trace.h"
+#endif
+
 #define DEMO_APP_INPUT_ASSEMBLY_NUM                100 //0x064
 #define DEMO_APP_OUTPUT_ASSEMBLY_NUM               150 //0x096
 #define DEMO_APP_CONFIG_ASSEMBLY_NUM               151 //0x097
@@ -22,6 +29,13 @@ EipUint8 g_assembly_data096[32]; /* Output */
 EipUint8 g_assembly_data097[10]; /* Config */
 EipUint8 g_assembly_data09A[32]; /* Explicit */
 
+#ifdef OPENER_CIP_ARENA_SIZE
+/* memory of the CIP objects, sealed when the stack is initialized */
+static unsigned char g_cip_arena_storage[OPENER_CIP_ARENA_SIZE];
+static Arena g_cip_arena = { g_cip_arena_storage, sizeof(g_cip_arena_storage),
+  0, 0 };
+#endif
+
 EipStatus ApplicationInitialization(void) {
   /* create 3 assembly object instances*/
   /*INPUT*/
@@ -58,6 +72,12 @@ EipStatus ApplicationInitialization(void) {
                                      DEMO_APP_INPUT_ASSEMBLY_NUM,
                                      DEMO_APP_CONFIG_ASSEMBLY_NUM);
 
+#ifdef OPENER_CIP_ARENA_SIZE
+  /* the application is initialized at last, the CIP objects are complete */
+  OPENER_TRACE_INFO("CIP objects use %zu of %zu bytes of the arena\n",
+                    g_cip_arena.used, g_cip_arena.capacity);
+  ArenaSeal(&g_cip_arena);
+#endif
   return kEipStatusOk;
 }
 
@@ -129,6 +149,39 @@ EipStatus ResetDeviceToInitialConfiguration(void) {
   return kEipStatusOk;
 }
 
+#ifdef OPENER_CIP_ARENA_SIZE
+
+void *
+CipCalloc(unsigned int number_of_elements, unsigned size_of_element) {
+  if (g_cip_arena.is_sealed) {
+    OPENER_TRACE_WARN("CipCalloc: allocation of %u bytes after the stack "
+                      "initialization\n", number_of_elements * size_of_element);
+  } else if ((0 == size_of_element)
+      || (number_of_elements <= SIZE_MAX / size_of_element)) {
+    void *data = ArenaAllocate(&g_cip_arena,
+                               (size_t) number_of_elements * size_of_element);
+    if (NULL != data) {
+      return data;
+    }
+    OPENER_TRACE_WARN("CipCalloc: arena exhausted, increase "
+                      "OPENER_CIP_ARENA_SIZE\n");
+  }
+  return calloc(number_of_elements, size_of_element);
+}
+
+void CipFree(void *data) {
+  /* the blocks of the arena are released at once by ReleaseCipArena */
+  if (!ArenaContains(&g_cip_arena, data)) {
+    free(data);
+  }
+}
+
+void ReleaseCipArena(void) {
+  ArenaReset(&g_cip_arena);
+}
+
+#else
+
 void *
 CipCalloc(unsigned int number_of_elements, unsigned size_of_element) {
   return calloc(number_of_elements, size_of_element);
@@ -138,6 +191,8 @@ void CipFree(void *data) {
   free(data);
 }
 
+#endif /* OPENER_CIP_ARENA_SIZE */
+
 void RunIdleChanged(EipUint32 run_idle_value) {
   (void) run_idle_value;
 }
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Rockwell Automation, Inc.
+ * All rights reserved.
+ *
+ ******************************************************************************/
+#define _GNU_SOURCE /* pthread_setaffinity_np, pipe2 */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tcp_workers.h"
+
+#include "opener_api.h"
+#include "opener_error.h"
+#include "encap.h"
+#include "trace.h"
+
+#if (OPENER_TCP_WORKERS > OPENER_NUMBER_OF_SUPPORTED_SESSIONS) \
+    || (OPENER_TCP_WORKERS > OPENER_NUMBER_OF_TCP_CONNECTIONS)
+#error "every TCP worker needs at least one session and one TCP connection"
+#endif
+
+/** @brief Sessions and TCP connections served by one worker */
+#define OPENER_SESSIONS_PER_TCP_WORKER \
+  (OPENER_NUMBER_OF_SUPPORTED_SESSIONS / OPENER_TCP_WORKERS)
+#define OPENER_TCP_CONNECTIONS_PER_TCP_WORKER \
+  (OPENER_NUMBER_OF_TCP_CONNECTIONS / OPENER_TCP_WORKERS)
+
+/** @brief A worker thread with its listener */
+typedef struct {
+  pthread_t thread;
+  int index; /**< selects the worker's slices of the sessions and buffers */
+  int listener; /**< the worker's listener on port 0xAF12 */
+  EipBool8 is_running;
+} TcpWorker;
+
+static TcpWorker g_tcp_workers[OPENER_TCP_WORKERS];
+
+static EipBool8 g_are_tcp_workers_stopping = false;
+
+/** pipe waking up the workers to stop, [0] is read; it is never drained so
+ * that it wakes up every worker */
+static int g_tcp_workers_wake_up[2] = { -1, -1 };
+
+static pthread_mutex_t g_cip_object_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void LockCipObjects(void) {
+  pthread_mutex_lock(&g_cip_object_lock);
+}
+
+void UnlockCipObjects(void) {
+  pthread_mutex_unlock(&g_cip_object_lock);
+}
+
+/** @brief Event loop handler of the stop pipe, the worker's loop checks
+ * g_are_tcp_workers_stopping */
+static void HandleTcpWorkerWakeUp(int socket) {
+  (void) socket; /* kill unused parameter warning */
+}
+
+/** @brief Pins the worker to its CPU, failing is not fatal */
+static void SetUpTcpWorkerScheduling(const TcpWorker *worker) {
+#if OPENER_TCP_WORKER_FIRST_CPU >= 0
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(OPENER_TCP_WORKER_FIRST_CPU + worker->index, &cpus);
+  int error_code = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  if (0 != error_code) {
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_WARN("tcp worker: could not pin worker %d to CPU %d: %d - %s\n",
+                      worker->index,
+                      OPENER_TCP_WORKER_FIRST_CPU + worker->index, error_code,
+                      error_message);
+    free(error_message);
+  }
+#else
+  (void) worker; /* kill unused parameter warning */
+#endif
+}
+
+static void *TcpWorkerMain(void *argument) {
+  TcpWorker *worker = argument;
+
+  /* signals are handled by the main thread */
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  SetUpTcpWorkerScheduling(worker);
+  SetEncapsulationSessionSlice(
+      worker->index * OPENER_SESSIONS_PER_TCP_WORKER,
+      OPENER_SESSIONS_PER_TCP_WORKER);
+  SetTcpConnectionSlice(worker->index * OPENER_TCP_CONNECTIONS_PER_TCP_WORKER,
+                        OPENER_TCP_CONNECTIONS_PER_TCP_WORKER);
+
+  if ((kEipStatusOk != EventLoopInitialize())
+      || (kEipStatusOk
+          != EventLoopAddSocket(g_tcp_workers_wake_up[0],
+                                HandleTcpWorkerWakeUp))
+      || (kEipStatusOk
+          != EventLoopAddSocket(worker->listener, HandleTcpListenerSocket))) {
+    OPENER_TRACE_ERR("tcp worker: worker %d could not set up its event loop\n",
+                     worker->index);
+    EventLoopShutdown();
+    return NULL;
+  }
+
+  while (!__atomic_load_n(&g_are_tcp_workers_stopping, __ATOMIC_ACQUIRE)) {
+    if (kEipStatusOk
+        != EventLoopDispatchEvents(kOpenerTimerTickInMilliSeconds * 1000ULL)) {
+      break;
+    }
+  }
+
+  CloseSocket(worker->listener);
+  EventLoopShutdown();
+  return NULL;
+}
+
+EipStatus TcpWorkersInitialize(void) {
+  if (0 != pipe2(g_tcp_workers_wake_up, O_NONBLOCK | O_CLOEXEC)) {
+    int error_code = errno;
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("tcp worker: could not create wake up pipe: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipStatusError;
+  }
+
+  for (int i = 0; i < OPENER_TCP_WORKERS; i++) {
+    g_tcp_workers[i].index = i;
+    g_tcp_workers[i].is_running = false;
+    if (kEipInvalidSocket == (g_tcp_workers[i].listener = CreateTcpListener())) {
+      return kEipStatusError;
+    }
+  }
+  return kEipStatusOk;
+}
+
+EipStatus TcpWorkersStart(void) {
+  g_are_tcp_workers_stopping = false;
+  for (int i = 0; i < OPENER_TCP_WORKERS; i++) {
+    int error_code = pthread_create(&g_tcp_workers[i].thread, NULL,
+                                    TcpWorkerMain, &g_tcp_workers[i]);
+    if (0 != error_code) {
+      char* error_message = GetErrorMessage(error_code);
+      OPENER_TRACE_ERR("tcp worker: could not start worker %d: %d - %s\n", i,
+                       error_code, error_message);
+      free(error_message);
+      return kEipStatusError;
+    }
+    g_tcp_workers[i].is_running = true;
+  }
+  return kEipStatusOk;
+}
+
+void TcpWorkersStop(void) {
+  static const char wake_up = 0;
+
+  __atomic_store_n(&g_are_tcp_workers_stopping, true, __ATOMIC_RELEASE);
+  if (1 != write(g_tcp_workers_wake_up[1], &wake_up, sizeof(wake_up))) {
+    OPENER_TRACE_ERR("tcp worker: could not wake up the workers\n");
+  }
+  for (int i = 0; i < OPENER_TCP_WORKERS; i++) {
+    if (g_tcp_workers[i].is_running) {
+      pthread_join(g_tcp_workers[i].thread, NULL);
+      g_tcp_workers[i].is_running = false;
+    }
+  }
+  for (int i = 0; i < 2; i++) {
+    close(g_tcp_workers_wake_up[i]);
+    g_tcp_workers_wake_up[i] = -1;
+  }
+}
@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Rockwell Automation, Inc.
+ * All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef OPENER_TCP_WORKERS_H_
+#define OPENER_TCP_WORKERS_H_
+
+/** @file tcp_workers.h
+ * @brief Worker threads serving the encapsulation sessions on TCP
+ *
+ * With OPENER_TCP_WORKERS the TCP connections are not served by the main
+ * thread but by OPENER_TCP_WORKERS worker threads. Every worker runs its own
+ * event loop with its own listener on port 0xAF12, the kernel distributes the
+ * incoming connections among the listeners (SO_REUSEPORT). A worker owns a
+ * slice of the session table and of the TCP reassembly buffers, the requests
+ * are handled in request contexts on the worker's stack.
+ *
+ * The CIP objects are shared by all threads. The message router, the
+ * connection manager and ManageConnections run with the lock of
+ * LockCipObjects held.
+ */
+
+#include "generic_networkhandler.h"
+
+/** @brief First CPU the workers are pinned to, worker i runs on CPU
+ * OPENER_TCP_WORKER_FIRST_CPU + i; -1 allows all CPUs */
+#ifndef OPENER_TCP_WORKER_FIRST_CPU
+#define OPENER_TCP_WORKER_FIRST_CPU -1
+#endif
+
+/** @brief Creates the listeners of the workers
+ *
+ *  @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus TcpWorkersInitialize(void);
+
+/** @brief Starts the worker threads
+ *
+ *  @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus TcpWorkersStart(void);
+
+/** @brief Stops the worker threads and waits until they have ended
+ *
+ * The sessions of the workers are closed by EncapsulationShutDown
+ * afterwards.
+ */
+void TcpWorkersStop(void);
+
+#endif /* OPENER_TCP_WORKERS_H_ */
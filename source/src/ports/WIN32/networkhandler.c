@@ -16,7 +16,7 @@
 #include "generic_networkhandler.h"
 #include "encap.h"
 
-MicroSeconds getMicroSeconds() {
+MicroSeconds GetMicroSeconds(void) {
   LARGE_INTEGER performance_counter;
   LARGE_INTEGER performance_frequency;
 
@@ -28,7 +28,7 @@ MicroSeconds getMicroSeconds() {
 }
 
 MilliSeconds GetMilliSeconds(void) {
-  return (MilliSeconds) (getMicroSeconds() / 1000ULL);
+  return (MilliSeconds) (GetMicroSeconds() / 1000ULL);
 }
 
 EipStatus NetworkHandlerInitializePlatform(void) {
@@ -44,3 +44,15 @@ EipStatus NetworkHandlerInitializePlatform(void) {
 void CloseSocketPlatform(int socket_handle) {
     closesocket(socket_handle);
 }
+
+EipStatus SetSocketToNonBlocking(int socket_handle) {
+  u_long non_blocking = 1;
+  if (0 != ioctlsocket(socket_handle, FIONBIO, &non_blocking)) {
+    return kEipStatusError;
+  }
+  return kEipStatusOk;
+}
+
+EipBool8 SocketErrorIsWouldBlock(int error_code) {
+  return WSAEWOULDBLOCK == error_code;
+}
@@ -74,13 +74,6 @@ typedef unsigned short in_port_t;
  */
 #define OPENER_CIP_NUM_LISTEN_ONLY_CONNS_PER_CON_PATH   3
 
-/** @brief The number of bytes used for the buffer that will be used for generating any
- *  reply data of messages. There are two uses in OpENer:
- *    1. Explicit messages will use this buffer to store the data generated by the request
- *    2. I/O Connections will use this buffer for the produced data
- */
-#define OPENER_MESSAGE_DATA_REPLY_BUFFER 100
-
 /** @brief Number of sessions that can be handled at the same time
  */
 #define OPENER_NUMBER_OF_SUPPORTED_SESSIONS 20
@@ -145,9 +138,18 @@ static const int kOpenerProducedDataHasRunIdleHeader = 0;
  * the pc port. For different platforms it may makes sense to 
  * have more than one buffer.
  *
- *  This buffer size will be used for any received message.
- *  The same buffer is used for the replied explicit message.
+ *  This buffer size will be used for any received message on TCP.
+ *  The replies of explicit messages are assembled in a buffer of the same size.
  */
 #define PC_OPENER_ETHERNET_BUFFER_SIZE 512
 
+/** @brief The number of bytes used for the buffers receiving UDP datagrams
+ *
+ *  Bounds the size of the consumed I/O connections, connections larger than
+ *  511 bytes are opened with the Large Forward Open. Must not be smaller than
+ *  PC_OPENER_ETHERNET_BUFFER_SIZE as the replies to unconnected messages on
+ *  UDP are assembled in the receive buffer.
+ */
+#define PC_OPENER_UDP_BUFFER_SIZE 4096
+
 #endif /*OPENER_USER_CONF_H_*/
@@ -11,6 +11,10 @@
  *  The generic network handler delegates platform-dependent tasks to the platform network handler
  */
 
+#if defined(OPENER_HAVE_RECVMMSG) || defined(OPENER_BATCHED_PRODUCTION)
+#define _GNU_SOURCE /* recvmmsg(), sendmmsg() */
+#endif
+
 #include <assert.h>
 
 #include "generic_networkhandler.h"
@@ -20,33 +24,215 @@
 #include "opener_error.h"
 #include "encap.h"
 #include "ciptcpipinterface.h"
+#include "cipioconnection.h"
+#ifdef OPENER_IO_THREAD
+#include "io_thread.h"
+#endif
+#ifdef OPENER_TCP_WORKERS
+#include "tcp_workers.h"
+#endif
+
+OPENER_THREAD_LOCAL fd_set master_socket;
+OPENER_THREAD_LOCAL fd_set read_socket;
+OPENER_THREAD_LOCAL int highest_socket_handle;
+OPENER_THREAD_LOCAL struct timeval g_time_value;
+
+/** @brief Processes request received via the UDP unicast socket
+ *
+ *  @param socket The UDP unicast listener socket
+ *  @param from_address The sender of the request
+ *  @param data The received datagram
+ *  @param data_length Length of the received datagram
+ */
+void HandleUdpUnicastDatagram(int socket, struct sockaddr_in *from_address,
+                              EipUint8 *data, int data_length);
+
+/** @brief Handles incoming messages via UDP broadcast
+ *
+ *  @param socket The UDP global broadcast listener socket
+ *  @param from_address The sender of the message
+ *  @param data The received datagram
+ *  @param data_length Length of the received datagram
+ */
+void HandleUdpGlobalBroadcastDatagram(int socket,
+                                      struct sockaddr_in *from_address,
+                                      EipUint8 *data, int data_length);
+
+/** @brief Handles data received on one of the UDP consuming sockets
+ *
+ *  @param socket The consuming socket the data has been received on
+ *  @param from_address The sender of the data
+ *  @param data The received datagram
+ *  @param data_length Length of the received datagram, 0 or less on errors
+ */
+void HandleConsumingUdpDatagram(int socket, struct sockaddr_in *from_address,
+                                EipUint8 *data, int data_length);
+
+/** @brief Creates a non-blocking UDP socket bound to the given address and
+ * registers it for consuming I/O messages with the event loop
+ *
+ *  @param address The address to bind the socket to
+ *  @return the socket handle if successful, else kEipInvalidSocket
+ */
+int CreateConsumingUdpSocket(struct sockaddr_in *address);
+
+/** @brief Handles explicit messages received on one of the UDP listeners
+ *
+ *  @param socket The UDP listener socket
+ *  @param from_address The sender of the message
+ *  @param data The received datagram
+ *  @param data_length Length of the received datagram
+ *  @param unicast true if received on the unicast listener
+ */
+void HandleExplicitUdpDatagram(int socket, struct sockaddr_in *from_address,
+                               EipUint8 *data, int data_length, int unicast);
 
-/** @brief handle any connection request coming in the TCP server socket.
+/** @brief Reassembly state of a TCP connection
  *
+ * The bytes of an encapsulation frame which has not been received completely
+ * are collected in the buffer. Frames which do not fit into the buffer are
+ * skipped.
+ *
+ * If the socket cannot take a reply completely, the unsent tail is kept and
+ * the data received after the frame is held back until the tail is sent, so
+ * the replies leave in the order of the requests.
  */
-void CheckAndHandleTcpListenerSocket(void);
+typedef struct {
+  int socket; /**< the TCP connection, kEipInvalidSocket if the entry is unused */
+  struct sockaddr_in peer_address; /**< the originator of the requests */
+  size_t fill_level; /**< number of bytes of the incomplete frame held in buffer */
+  size_t bytes_to_discard; /**< remaining bytes of a skipped frame */
+  EipUint8 buffer[PC_OPENER_ETHERNET_BUFFER_SIZE];
+  size_t unsent_length; /**< number of bytes of the last reply still to be sent */
+  EipUint8 unsent_data[PC_OPENER_ETHERNET_BUFFER_SIZE];
+  size_t held_length; /**< number of received bytes waiting for the unsent reply */
+  EipUint8 held_data[OPENER_TCP_HELD_DATA_SIZE];
+} TcpConnectionBuffer;
+
+static TcpConnectionBuffer g_tcp_connection_buffers[OPENER_NUMBER_OF_TCP_CONNECTIONS];
+
+/** @brief The reassembly buffers of the calling thread, see
+ * SetTcpConnectionSlice */
+static OPENER_THREAD_LOCAL TcpConnectionBuffer *g_tcp_connection_slice =
+    g_tcp_connection_buffers;
+static OPENER_THREAD_LOCAL int g_number_of_tcp_connections_in_slice =
+    OPENER_NUMBER_OF_TCP_CONNECTIONS;
+
+/** @brief A datagram drained by ReceiveDatagram */
+typedef struct {
+  struct sockaddr_in from_address;
+  int data_length;
+  EipUint8 data[PC_OPENER_UDP_BUFFER_SIZE];
+} ReceivedDatagram;
+
+/** @brief Buffers ReceiveDatagram receives into, one per datagram of a batch */
+static OPENER_THREAD_LOCAL ReceivedDatagram g_received_datagrams[OPENER_UDP_RECEIVE_BATCH_SIZE];
+
+/** @brief Statistics CountDrainedDatagrams adds to, see
+ * SetDatagramReceiveStatistics */
+static OPENER_THREAD_LOCAL DatagramReceiveStatistics *g_datagram_receive_statistics =
+    &g_network_status.datagram_receive_statistics;
+
+#ifdef OPENER_BATCHED_PRODUCTION
+/** @brief A datagram waiting for the batched transmission */
+typedef struct {
+  int socket; /**< the socket to send on, kEipInvalidSocket if dropped */
+  struct sockaddr_in address;
+  size_t data_length;
+  EipUint8 data[PC_OPENER_ETHERNET_BUFFER_SIZE];
+} QueuedDatagram;
+
+/** @brief Datagrams sent by SendUdpData while a batch is open */
+static OPENER_THREAD_LOCAL QueuedDatagram g_queued_datagrams[OPENER_UDP_SEND_BATCH_SIZE];
+static OPENER_THREAD_LOCAL int g_number_of_queued_datagrams = 0;
+static OPENER_THREAD_LOCAL EipBool8 g_is_datagram_batch_open = false;
+
+/** @brief Sends all queued datagrams, one sendmmsg() call per socket */
+static void FlushQueuedDatagrams(void);
+
+/** @brief Queues a datagram gathered from a header and a payload if a batch
+ * is open and the datagram fits into the queue
+ *
+ * @return true if the datagram has been queued
+ */
+static EipBool8 QueueDatagram(int socket, struct sockaddr_in *address,
+                              EipUint8 *header, size_t header_length,
+                              EipUint8 *payload, size_t payload_length);
+#endif
+
+/** @brief A UDP socket bound to a multicast group, shared by all I/O
+ * connections consuming from the group */
+typedef struct {
+  int socket;
+  struct sockaddr_in address; /**< the address the socket is bound to */
+  int number_of_users; /**< connections using the socket, 0 if unused */
+} MulticastConsumingSocket;
+
+static MulticastConsumingSocket g_multicast_consuming_sockets[
+    OPENER_NUMBER_OF_MULTICAST_CONSUMING_SOCKETS];
+
+/** @brief Buffer ReceiveStream receives into */
+static OPENER_THREAD_LOCAL EipUint8 g_stream_receive_buffer[PC_OPENER_ETHERNET_BUFFER_SIZE];
+
+/** @brief Assigns a reassembly buffer to a newly accepted TCP connection and
+ * registers it with the event loop, the connection is closed if that fails
+ *
+ *  @param new_socket The accepted TCP connection
+ *  @param peer_address The address of the peer of the connection
+ */
+void AddTcpConnection(int new_socket, const struct sockaddr_in *peer_address);
+
+/** @brief Handles data received on an established TCP connection and closes the session on errors
+ *
+ *  @param socket The TCP session socket the data has been received on
+ *  @param data The received data
+ *  @param data_length Number of received bytes, 0 or less if the connection
+ *  has been closed or receiving failed
+ */
+void HandleTcpSessionData(int socket, EipUint8 *data, int data_length);
 
-/** @brief Checks and processes request received via the UDP unicast socket, currently the implementation is port-specific
+/** @brief Sends the unsent tail of a reply once the TCP session socket can
+ * take data again and handles the data held back meanwhile, closes the
+ * session on errors
  *
+ *  @param socket The TCP session socket
  */
-void CheckAndHandleUdpUnicastSocket(void);
+void HandleTcpSessionWritable(int socket);
 
-/** @brief Checks and handles incoming messages via UDP broadcast
+/** @brief Sends data on a TCP connection, keeps the tail the socket cannot
+ * take at the moment and waits until the socket is writable
  *
+ *  @param connection The connection to send on
+ *  @param data The data to be sent, may be the unsent tail of the connection
+ *  @param data_length Length of the data
+ *  @return kEipStatusOk if the data has been sent or kept, kEipStatusError if
+ *  the connection has to be closed
  */
-void CheckAndHandleUdpGlobalBroadcastSocket(void);
+EipStatus SendOnTcpConnection(TcpConnectionBuffer *connection, EipUint8 *data,
+                              size_t data_length);
 
-/** @brief check if on one of the UDP consuming sockets data has been received and if yes handle it correctly
+/** @brief Splits received data of a TCP connection into encapsulation frames
+ * and handles every complete frame
  *
+ *  @param connection The reassembly state of the connection
+ *  @param data The received data
+ *  @param data_length Number of received bytes
+ *  @return kEipStatusOk on success, or kEipStatusError if the connection has
+ *  to be closed
  */
-void CheckAndHandleConsumingUdpSockets(void);
+EipStatus HandleDataOnTcpConnection(TcpConnectionBuffer *connection,
+                                    EipUint8 *data, size_t data_length);
 
-/** @brief Handles data on an established TCP connection, processed connection is given by socket
+/** @brief Handles one complete encapsulation frame received via TCP and sends the reply
  *
- *  @param socket The socket to be processed
+ *  @param connection The connection the frame has been received on
+ *  @param frame The encapsulation frame
+ *  @param frame_length Length of the frame including the encapsulation header
  *  @return kEipStatusOk on success, or kEipStatusError on failure
  */
-EipStatus HandleDataOnTcpSocket(int socket);
+EipStatus HandleEncapsulationFrameOnTcpSocket(TcpConnectionBuffer *connection,
+                                              EipUint8 *frame,
+                                              size_t frame_length);
 
 /*************************************************
  * Function implementations from now on
@@ -58,29 +244,37 @@ EipStatus NetworkHandlerInitialize(void) {
     return kEipStatusError;
   }
 
-  /* clear the master an temp sets */
-  FD_ZERO(&master_socket);
-  FD_ZERO(&read_socket);
+  if (kEipStatusOk != EventLoopInitialize()) {
+    return kEipStatusError;
+  }
 
-  /* create a new TCP socket */
-  if ((g_network_status.tcp_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP))
-      == -1) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-    OPENER_TRACE_ERR("error allocating socket stream listener, %d - %s\n", error_code, error_message);
-	free(error_message);
+#ifdef OPENER_IO_THREAD
+  if (kEipStatusOk != IoThreadInitialize()) {
     return kEipStatusError;
   }
+#endif
 
-  int set_socket_option_value = 1;  //Represents true for used set socket options
-  /* Activates address reuse */
-  if (setsockopt(g_network_status.tcp_listener, SOL_SOCKET, SO_REUSEADDR,
-                 (char *) &set_socket_option_value,
-                 sizeof(set_socket_option_value)) == -1) {
-    OPENER_TRACE_ERR(
-        "error setting socket option SO_REUSEADDR on tcp_listener\n");
+  for (int i = 0; i < OPENER_NUMBER_OF_TCP_CONNECTIONS; i++) {
+    g_tcp_connection_buffers[i].socket = kEipInvalidSocket;
+  }
+
+#ifdef OPENER_TCP_WORKERS
+  /* the TCP connections are served by the workers */
+  g_network_status.tcp_listener = kEipInvalidSocket;
+  if (kEipStatusOk != TcpWorkersInitialize()) {
+    return kEipStatusError;
+  }
+#else
+  if ((kEipInvalidSocket
+      == (g_network_status.tcp_listener = CreateTcpListener()))
+      || (kEipStatusOk
+          != EventLoopAddSocket(g_network_status.tcp_listener,
+                                HandleTcpListenerSocket))) {
     return kEipStatusError;
   }
+#endif
+
+  int set_socket_option_value = 1;  //Represents true for used set socket options
 
   /* create a new UDP socket */
   if ((g_network_status.udp_global_broadcast_listener = socket(AF_INET,
@@ -128,16 +322,6 @@ EipStatus NetworkHandlerInitialize(void) {
       kOpenerEthernetPort), .sin_addr.s_addr = interface_configuration_
       .ip_address };
 
-  /* bind the new socket to port 0xAF12 (CIP) */
-  if ((bind(g_network_status.tcp_listener, (struct sockaddr *) &my_address,
-            sizeof(struct sockaddr))) == -1) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-    OPENER_TRACE_ERR("error with TCP bind: %d - %s\n", error_code, error_message);
-	free(error_message);
-    return kEipStatusError;
-  }
-
   if ((bind(g_network_status.udp_unicast_listener,
             (struct sockaddr *) &my_address, sizeof(struct sockaddr))) == -1) {
 	int error_code = GetSocketErrorNumber();
@@ -173,34 +357,138 @@ EipStatus NetworkHandlerInitialize(void) {
     return kEipStatusError;
   }
 
-  /* switch socket in listen mode */
-  if ((listen(g_network_status.tcp_listener, MAX_NO_OF_TCP_SOCKETS)) == -1) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-    OPENER_TRACE_ERR("networkhandler: error with listen: %d - %s\n", error_code, error_message);
-	free(error_message);
+  /* register the listener sockets with the event loop, datagram sockets are
+   * drained until they would block */
+  if ((kEipStatusOk
+      != SetSocketToNonBlocking(g_network_status.udp_unicast_listener))
+      || (kEipStatusOk
+          != SetSocketToNonBlocking(
+              g_network_status.udp_global_broadcast_listener))
+      || (kEipStatusOk
+          != EventLoopAddDatagramSocket(g_network_status.udp_unicast_listener,
+                                        HandleUdpUnicastDatagram))
+      || (kEipStatusOk
+          != EventLoopAddDatagramSocket(
+              g_network_status.udp_global_broadcast_listener,
+              HandleUdpGlobalBroadcastDatagram))) {
+    OPENER_TRACE_ERR("networkhandler: could not register listener sockets\n");
     return kEipStatusError;
   }
 
-  /* add the listener socket to the master set */
-  FD_SET(g_network_status.tcp_listener, &master_socket);
-  FD_SET(g_network_status.udp_unicast_listener, &master_socket);
-  FD_SET(g_network_status.udp_global_broadcast_listener, &master_socket);
-
-  /* keep track of the biggest file descriptor */
-  highest_socket_handle = GetMaxSocket(
-      g_network_status.tcp_listener,
-      g_network_status.udp_global_broadcast_listener,
-      0,
-      g_network_status.udp_unicast_listener);
+  /* all point to point I/O connections consume and produce on port 2222 */
+  struct sockaddr_in io_messaging_address = { .sin_family = AF_INET,
+      .sin_port = htons(kOpenerEipIoUdpPort), .sin_addr.s_addr = htonl(
+          INADDR_ANY) };
+  if (kEipInvalidSocket
+      == (g_network_status.udp_io_messaging = CreateConsumingUdpSocket(
+          &io_messaging_address))) {
+    return kEipStatusError;
+  }
 
-  g_last_time = GetMilliSeconds(); /* initialize time keeping */
+  g_last_time = GetMicroSeconds(); /* initialize time keeping */
   g_network_status.elapsed_time = 0;
 
+#ifdef OPENER_IO_THREAD
+  if (kEipStatusOk != IoThreadStart()) {
+    return kEipStatusError;
+  }
+#endif
+#ifdef OPENER_TCP_WORKERS
+  if (kEipStatusOk != TcpWorkersStart()) {
+    return kEipStatusError;
+  }
+#endif
   return kEipStatusOk;
 }
 
+int CreateTcpListener(void) {
+  int tcp_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (-1 == tcp_listener) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("error allocating socket stream listener, %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipInvalidSocket;
+  }
+
+  int set_socket_option_value = 1;  //Represents true for used set socket options
+  /* Activates address reuse */
+  if (setsockopt(tcp_listener, SOL_SOCKET, SO_REUSEADDR,
+                 (char *) &set_socket_option_value,
+                 sizeof(set_socket_option_value)) == -1) {
+    OPENER_TRACE_ERR(
+        "error setting socket option SO_REUSEADDR on tcp_listener\n");
+    CloseSocketPlatform(tcp_listener);
+    return kEipInvalidSocket;
+  }
+
+#ifdef OPENER_TCP_WORKERS
+  /* the listeners of all workers share the port */
+  if (setsockopt(tcp_listener, SOL_SOCKET, SO_REUSEPORT,
+                 (char *) &set_socket_option_value,
+                 sizeof(set_socket_option_value)) == -1) {
+    OPENER_TRACE_ERR(
+        "error setting socket option SO_REUSEPORT on tcp_listener\n");
+    CloseSocketPlatform(tcp_listener);
+    return kEipInvalidSocket;
+  }
+#endif
+
+  struct sockaddr_in my_address = { .sin_family = AF_INET, .sin_port = htons(
+      kOpenerEthernetPort), .sin_addr.s_addr = interface_configuration_
+      .ip_address };
+
+  /* bind the new socket to port 0xAF12 (CIP) */
+  if ((bind(tcp_listener, (struct sockaddr *) &my_address,
+            sizeof(struct sockaddr))) == -1) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("error with TCP bind: %d - %s\n", error_code,
+                     error_message);
+    free(error_message);
+    CloseSocketPlatform(tcp_listener);
+    return kEipInvalidSocket;
+  }
+
+  /* switch socket in listen mode, accepting never blocks */
+  if (((listen(tcp_listener, MAX_NO_OF_TCP_SOCKETS)) == -1)
+      || (kEipStatusOk != SetSocketToNonBlocking(tcp_listener))) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error with listen: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
+    CloseSocketPlatform(tcp_listener);
+    return kEipInvalidSocket;
+  }
+  return tcp_listener;
+}
+
+void SetTcpConnectionSlice(int first_connection, int number_of_connections) {
+  g_tcp_connection_slice = &g_tcp_connection_buffers[first_connection];
+  g_number_of_tcp_connections_in_slice = number_of_connections;
+}
+
 void IApp_CloseSocket_udp(int socket_handle) {
+  if (g_network_status.udp_io_messaging == socket_handle) {
+    return; /* shared by all I/O connections, closed on shutdown */
+  }
+  for (int i = 0; i < OPENER_NUMBER_OF_MULTICAST_CONSUMING_SOCKETS; i++) {
+    MulticastConsumingSocket *shared_socket = &g_multicast_consuming_sockets[i];
+    if ((0 < shared_socket->number_of_users)
+        && (socket_handle == shared_socket->socket)) {
+      if (0 < --shared_socket->number_of_users) {
+        return; /* still used by other connections */
+      }
+      break;
+    }
+  }
+#ifdef OPENER_IO_THREAD
+  if (kEipInvalidSocket != socket_handle) {
+    IoThreadRemoveSocket(socket_handle);
+  }
+#endif
   CloseSocket(socket_handle);
 }
 
@@ -222,418 +510,746 @@ EipBool8 CheckSocketSet(int socket) {
   return return_value;
 }
 
-void CheckAndHandleTcpListenerSocket(void) {
+void HandleTcpListenerSocket(int socket) {
   int new_socket;
-  /* see if this is a connection request to the TCP listener*/
-  if (true == CheckSocketSet(g_network_status.tcp_listener)) {
-    OPENER_TRACE_INFO("networkhandler: new TCP connection\n");
-
-    new_socket = accept(g_network_status.tcp_listener, NULL, NULL);
-    if (new_socket == -1) {
-	  int error_code = GetSocketErrorNumber();
-	  char* error_message = GetErrorMessage(error_code);
-      OPENER_TRACE_ERR("networkhandler: error on accept: %d - %s\n",
-                       error_code, error_message);
-	  free(error_message);
-      return;
-    }
-
-    FD_SET(new_socket, &master_socket);
-    /* add newfd to master set */
-    if (new_socket > highest_socket_handle) {
-      highest_socket_handle = new_socket;
-    }
+  struct sockaddr_in peer_address;
+  socklen_t peer_address_length = sizeof(peer_address);
+
+  /* a single readiness event may stand for several pending connections
+   * (io_uring multishot poll), the non-blocking listener is drained */
+  while (-1
+      != (new_socket = accept(socket, (struct sockaddr *) &peer_address,
+                              &peer_address_length))) {
+    AddTcpConnection(new_socket, &peer_address);
+    peer_address_length = sizeof(peer_address);
+  }
 
-    OPENER_TRACE_STATE("networkhandler: opened new TCP connection on fd %d\n",
-                       new_socket);
+  int error_code = GetSocketErrorNumber();
+  if (!SocketErrorIsWouldBlock(error_code)) {
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error on accept: %d - %s\n",
+                     error_code, error_message);
+    free(error_message);
   }
 }
 
-EipStatus NetworkHandlerProcessOnce(void) {
-
-  read_socket = master_socket;
+void AddTcpConnection(int new_socket, const struct sockaddr_in *peer_address) {
+  OPENER_TRACE_INFO("networkhandler: new TCP connection\n");
 
-  g_time_value.tv_sec = 0;
-  g_time_value.tv_usec = (
-      g_network_status.elapsed_time < kOpenerTimerTickInMilliSeconds ?
-          kOpenerTimerTickInMilliSeconds - g_network_status.elapsed_time : 0)
-      * 1000; /* 10 ms */
+  TcpConnectionBuffer *connection = NULL;
+  for (int i = 0; i < g_number_of_tcp_connections_in_slice; i++) {
+    if (kEipInvalidSocket == g_tcp_connection_slice[i].socket) {
+      connection = &g_tcp_connection_slice[i];
+      break;
+    }
+  }
+  if (NULL == connection) {
+    OPENER_TRACE_WARN(
+        "networkhandler: too many TCP connections, closing fd %d\n",
+        new_socket);
+    CloseSocketPlatform(new_socket);
+    return;
+  }
 
-  int ready_socket = select(highest_socket_handle + 1, &read_socket, 0, 0,
-                            &g_time_value);
+  if ((kEipStatusOk != SetSocketToNonBlocking(new_socket))
+      || (kEipStatusOk
+          != EventLoopAddStreamSocket(new_socket, HandleTcpSessionData))) {
+    OPENER_TRACE_ERR(
+        "networkhandler: cannot watch new TCP connection on fd %d, closing it\n",
+        new_socket);
+    CloseSocketPlatform(new_socket);
+    return;
+  }
+  connection->socket = new_socket;
+  connection->peer_address = *peer_address;
+  connection->fill_level = 0;
+  connection->bytes_to_discard = 0;
+  connection->unsent_length = 0;
+  connection->held_length = 0;
+
+  OPENER_TRACE_STATE("networkhandler: opened new TCP connection on fd %d\n",
+                     new_socket);
+}
 
-  if (ready_socket == kEipInvalidSocket) {
-    if (EINTR == errno) /* we have somehow been interrupted. The default behavior is to go back into the select loop. */
-    {
-      return kEipStatusOk;
+void HandleTcpSessionData(int socket, EipUint8 *data, int data_length) {
+  if (0 >= data_length) {
+    if (0 == data_length) {
+      OPENER_TRACE_STATE("networkhandler: connection closed by client\n");
     } else {
-	  int error_code = GetSocketErrorNumber();
-	  char* error_message = GetErrorMessage(error_code);
-      OPENER_TRACE_ERR("networkhandler: error with select: %d - %s\n", error_code, error_message);
-	  free(error_message);
-      return kEipStatusError;
+      int error_code = GetSocketErrorNumber();
+      char* error_message = GetErrorMessage(error_code);
+      OPENER_TRACE_ERR("networkhandler: error on recv: %d - %s\n",
+                       error_code, error_message);
+      free(error_message);
     }
+    CloseSocket(socket);
+    CloseSession(socket); /* clean up session and close the socket */
+    return;
   }
 
-  if (ready_socket > 0) {
-
-    CheckAndHandleTcpListenerSocket();
-    CheckAndHandleUdpUnicastSocket();
-    CheckAndHandleUdpGlobalBroadcastSocket();
-    CheckAndHandleConsumingUdpSockets();
+  for (int i = 0; i < g_number_of_tcp_connections_in_slice; i++) {
+    if (socket == g_tcp_connection_slice[i].socket) {
+      if (kEipStatusError
+          == HandleDataOnTcpConnection(&g_tcp_connection_slice[i], data,
+                                       data_length)) {
+        CloseSocket(socket);
+        CloseSession(socket); /* clean up session and close the socket */
+      }
+      return;
+    }
+  }
+}
 
-    for (int socket = 0; socket <= highest_socket_handle; socket++) {
-      if (true == CheckSocketSet(socket)) {
-        /* if it is still checked it is a TCP receive */
-        if (kEipStatusError == HandleDataOnTcpSocket(socket)) /* if error */
-        {
-          CloseSocket(socket);
-          CloseSession(socket); /* clean up session and close the socket */
-        }
+void HandleTcpSessionWritable(int socket) {
+  for (int i = 0; i < g_number_of_tcp_connections_in_slice; i++) {
+    TcpConnectionBuffer *connection = &g_tcp_connection_slice[i];
+    if (socket == connection->socket) {
+      EipStatus status = SendOnTcpConnection(connection,
+                                             connection->unsent_data,
+                                             connection->unsent_length);
+      if ((kEipStatusOk == status) && (0 == connection->unsent_length)
+          && (0 < connection->held_length)) {
+        size_t held_length = connection->held_length;
+        connection->held_length = 0; /* held again if the socket blocks again */
+        status = HandleDataOnTcpConnection(connection, connection->held_data,
+                                           held_length);
+      }
+      if (kEipStatusError == status) {
+        CloseSocket(socket);
+        CloseSession(socket); /* clean up session and close the socket */
       }
+      return;
     }
   }
+}
+
+/** @brief Returns the time from the last call of ManageConnections on at which
+ * it has to be called next: when the next connection is due, but at least once
+ * every OPENER_TIMER_TICK to run the application */
+static MicroSeconds GetConnectionManagementTime(void) {
+#ifdef OPENER_IO_THREAD
+  return kOpenerTimerTickInMilliSeconds * 1000ULL; /* the connections are up to the I/O thread */
+#else
+  MicroSeconds management_time = GetTimeToNextConnectionEvent();
+  if (management_time > kOpenerTimerTickInMilliSeconds * 1000ULL) {
+    management_time = kOpenerTimerTickInMilliSeconds * 1000ULL;
+  }
+  return management_time;
+#endif
+}
+
+EipStatus NetworkHandlerProcessOnce(void) {
+
+  MicroSeconds management_time = GetConnectionManagementTime();
+  MicroSeconds timeout =
+      g_network_status.elapsed_time < management_time ?
+          management_time - g_network_status.elapsed_time : 0;
+
+  if (kEipStatusOk != EventLoopDispatchEvents(timeout)) {
+    return kEipStatusError;
+  }
 
-  g_actual_time = GetMilliSeconds();
+  g_actual_time = GetMicroSeconds();
   g_network_status.elapsed_time += g_actual_time - g_last_time;
   g_last_time = g_actual_time;
 
-  /* check if we had been not able to update the connection manager for several OPENER_TIMER_TICK.
-   * This should compensate the jitter of the windows timer
-   */
-  if (g_network_status.elapsed_time >= kOpenerTimerTickInMilliSeconds) {
-    /* call manage_connections() in connection manager every OPENER_TIMER_TICK ms */
+  /* the handlers may have opened or triggered connections which are due now.
+   * Late calls are compensated by the elapsed time */
+  if (g_network_status.elapsed_time >= GetConnectionManagementTime()) {
+    /* collect the productions of this tick and send them together */
+    BeginDatagramBatch();
+#ifdef OPENER_TCP_WORKERS
+    LockCipObjects();
+    ManageConnections(g_network_status.elapsed_time);
+    UnlockCipObjects();
+#else
     ManageConnections(g_network_status.elapsed_time);
+#endif
     g_network_status.elapsed_time = 0;
+    EndDatagramBatch();
   }
   return kEipStatusOk;
 }
 
+void BeginDatagramBatch(void) {
+#ifdef OPENER_BATCHED_PRODUCTION
+  g_is_datagram_batch_open = true;
+#endif
+}
+
+void EndDatagramBatch(void) {
+#ifdef OPENER_BATCHED_PRODUCTION
+  g_is_datagram_batch_open = false;
+  FlushQueuedDatagrams();
+#endif
+}
+
 EipStatus NetworkHandlerFinish(void) {
+#ifdef OPENER_TCP_WORKERS
+  TcpWorkersStop();
+#endif
+#ifdef OPENER_IO_THREAD
+  IoThreadStop();
+#endif
   CloseSocket(g_network_status.tcp_listener);
   CloseSocket(g_network_status.udp_unicast_listener);
   CloseSocket(g_network_status.udp_global_broadcast_listener);
+  CloseSocket(g_network_status.udp_io_messaging);
+  EventLoopShutdown();
   return kEipStatusOk;
 }
 
-void CheckAndHandleUdpGlobalBroadcastSocket(void) {
+void HandleUdpGlobalBroadcastDatagram(int socket,
+                                      struct sockaddr_in *from_address,
+                                      EipUint8 *data, int data_length) {
+  OPENER_TRACE_STATE(
+      "networkhandler: unsolicited UDP message on EIP global broadcast socket\n");
 
-  struct sockaddr_in from_address;
-  socklen_t from_address_length;
-
-  /* see if this is an unsolicited inbound UDP message */
-  if (true == CheckSocketSet(g_network_status.udp_global_broadcast_listener)) {
+  if (data_length <= 0) { /* got error */
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR(
+        "networkhandler: error on recvfrom UDP global broadcast port: %d - %s\n", error_code, error_message);
+    free(error_message);
+    return;
+  }
 
-    from_address_length = sizeof(from_address);
+  OPENER_TRACE_INFO("Data received on global broadcast UDP:\n");
+  HandleExplicitUdpDatagram(socket, from_address, data, data_length, false);
+}
 
-    OPENER_TRACE_STATE(
-        "networkhandler: unsolicited UDP message on EIP global broadcast socket\n");
+void HandleUdpUnicastDatagram(int socket, struct sockaddr_in *from_address,
+                              EipUint8 *data, int data_length) {
+  OPENER_TRACE_STATE(
+      "networkhandler: unsolicited UDP message on EIP unicast socket\n");
 
-    /* Handle UDP broadcast messages */
-    int received_size = recvfrom(g_network_status.udp_global_broadcast_listener,
-                                 g_ethernet_communication_buffer,
-                                 PC_OPENER_ETHERNET_BUFFER_SIZE,
-                                 0, (struct sockaddr *) &from_address,
-                                 &from_address_length);
+  if (data_length <= 0) { /* got error */
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR(
+        "networkhandler: error on recvfrom UDP unicast port: %d - %s\n", error_code, error_message);
+    free(error_message);
+    return;
+  }
 
-    if (received_size <= 0) { /* got error */
-	  int error_code = GetSocketErrorNumber();
-	  char* error_message = GetErrorMessage(error_code);
-      OPENER_TRACE_ERR(
-          "networkhandler: error on recvfrom UDP global broadcast port: %d - %s\n", error_code, error_message);
-	  free(error_message);
-      return;
-    }
+  OPENER_TRACE_INFO("Data received on UDP unicast:\n");
+  HandleExplicitUdpDatagram(socket, from_address, data, data_length, true);
+}
 
-    OPENER_TRACE_INFO("Data received on global broadcast UDP:\n");
+void HandleExplicitUdpDatagram(int socket, struct sockaddr_in *from_address,
+                               EipUint8 *data, int data_length, int unicast) {
+  EipUint8 *receive_buffer = data;
+  int received_size = data_length;
+  int remaining_bytes = 0;
+  do {
+    int reply_length = HandleReceivedExplictUdpData(socket, from_address,
+                                                    receive_buffer,
+                                                    received_size,
+                                                    &remaining_bytes, unicast);
 
-    EipUint8 *receive_buffer = &g_ethernet_communication_buffer[0];
-    int remaining_bytes = 0;
-    do {
-      int reply_length = HandleReceivedExplictUdpData(
-          g_network_status.udp_global_broadcast_listener, &from_address,
-          receive_buffer, received_size, &remaining_bytes, false);
+    if (reply_length > 0) {
+      OPENER_TRACE_INFO("reply sent:\n");
 
-      receive_buffer += received_size - remaining_bytes;
-      received_size = remaining_bytes;
+      /* the reply has been assembled in place of the handled message */
+      if (kEipStatusOk
+          != EventLoopSendDatagram(socket, from_address, receive_buffer,
+                                   reply_length)) {
+        OPENER_TRACE_INFO(
+            "networkhandler: UDP response was not fully sent\n");
+      }
+    }
 
-      if (reply_length > 0) {
-        OPENER_TRACE_INFO("reply sent:\n");
+    receive_buffer += received_size - remaining_bytes;
+    received_size = remaining_bytes;
+  } while (remaining_bytes > 0);
+}
 
-        /* if the active socket matches a registered UDP callback, handle a UDP packet */
-        if (sendto(g_network_status.udp_global_broadcast_listener,
-                   (char *) g_ethernet_communication_buffer, reply_length, 0,
-                   (struct sockaddr *) &from_address, sizeof(from_address))
-            != reply_length) {
-          OPENER_TRACE_INFO(
-              "networkhandler: UDP response was not fully sent\n");
-        }
-      }
-    } while (remaining_bytes > 0);
+EipStatus SendUdpData(struct sockaddr_in *address, int socket, EipUint8 *data,
+                      EipUint16 data_length) {
+#ifdef OPENER_BATCHED_PRODUCTION
+  if (QueueDatagram(socket, address, data, data_length, NULL, 0)) {
+    return kEipStatusOk;
   }
+#endif
+  return EventLoopSendDatagram(socket, address, data, data_length);
 }
 
-void CheckAndHandleUdpUnicastSocket(void) {
-
-  struct sockaddr_in from_address;
-  socklen_t from_address_length;
-
-  /* see if this is an unsolicited inbound UDP message */
-  if (true == CheckSocketSet(g_network_status.udp_unicast_listener)) {
-
-    from_address_length = sizeof(from_address);
+EipStatus SendUdpDataGathered(struct sockaddr_in *address, int socket,
+                              EipUint8 *header, EipUint16 header_length,
+                              EipUint8 *payload, EipUint16 payload_length) {
+#ifdef OPENER_BATCHED_PRODUCTION
+  if (QueueDatagram(socket, address, header, header_length, payload,
+                    payload_length)) {
+    return kEipStatusOk;
+  }
+#endif
+  return EventLoopSendGatheredDatagram(socket, address, header, header_length,
+                                       payload, payload_length);
+}
 
-    OPENER_TRACE_STATE(
-        "networkhandler: unsolicited UDP message on EIP unicast socket\n");
+#ifdef OPENER_BATCHED_PRODUCTION
+static EipBool8 QueueDatagram(int socket, struct sockaddr_in *address,
+                              EipUint8 *header, size_t header_length,
+                              EipUint8 *payload, size_t payload_length) {
+  if (!g_is_datagram_batch_open
+      || (header_length + payload_length > sizeof(g_queued_datagrams[0].data))) {
+    return false;
+  }
+  if (OPENER_UDP_SEND_BATCH_SIZE == g_number_of_queued_datagrams) {
+    FlushQueuedDatagrams();
+  }
+  QueuedDatagram *datagram = &g_queued_datagrams[g_number_of_queued_datagrams++];
+  datagram->socket = socket;
+  datagram->address = *address;
+  datagram->data_length = header_length + payload_length;
+  memcpy(datagram->data, header, header_length);
+  if (0 < payload_length) {
+    memcpy(&datagram->data[header_length], payload, payload_length);
+  }
+  return true;
+}
 
-    /* Handle UDP broadcast messages */
-    int received_size = recvfrom(g_network_status.udp_unicast_listener,
-                                 g_ethernet_communication_buffer,
-                                 PC_OPENER_ETHERNET_BUFFER_SIZE,
-                                 0, (struct sockaddr *) &from_address,
-                                 &from_address_length);
+static void FlushQueuedDatagrams(void) {
+  struct mmsghdr messages[OPENER_UDP_SEND_BATCH_SIZE];
+  struct iovec io_vectors[OPENER_UDP_SEND_BATCH_SIZE];
 
-    if (received_size <= 0) { /* got error */
-	  int error_code = GetSocketErrorNumber();
-	  char* error_message = GetErrorMessage(error_code);
-	  OPENER_TRACE_ERR(
-		  "networkhandler: error on recvfrom UDP unicast port: %d - %s\n", error_code, error_message);
-	  free(error_message);
-      return;
+  /* gather the datagrams of one socket at a time, keeping their order */
+  for (int first = 0; first < g_number_of_queued_datagrams; first++) {
+    int socket = g_queued_datagrams[first].socket;
+    if (kEipInvalidSocket == socket) {
+      continue; /* already sent or dropped */
     }
 
-    OPENER_TRACE_INFO("Data received on UDP unicast:\n");
-
-    EipUint8 *receive_buffer = &g_ethernet_communication_buffer[0];
-    int remaining_bytes = 0;
-    do {
-      int reply_length = HandleReceivedExplictUdpData(
-          g_network_status.udp_unicast_listener, &from_address, receive_buffer,
-          received_size, &remaining_bytes, true);
-
-      receive_buffer += received_size - remaining_bytes;
-      received_size = remaining_bytes;
-
-      if (reply_length > 0) {
-        OPENER_TRACE_INFO("reply sent:\n");
+    int number_of_messages = 0;
+    for (int i = first; i < g_number_of_queued_datagrams; i++) {
+      QueuedDatagram *datagram = &g_queued_datagrams[i];
+      if (socket != datagram->socket) {
+        continue;
+      }
+      io_vectors[number_of_messages].iov_base = datagram->data;
+      io_vectors[number_of_messages].iov_len = datagram->data_length;
+      memset(&messages[number_of_messages], 0, sizeof(messages[0]));
+      messages[number_of_messages].msg_hdr.msg_name = &datagram->address;
+      messages[number_of_messages].msg_hdr.msg_namelen =
+          sizeof(datagram->address);
+      messages[number_of_messages].msg_hdr.msg_iov =
+          &io_vectors[number_of_messages];
+      messages[number_of_messages].msg_hdr.msg_iovlen = 1;
+      number_of_messages++;
+      datagram->socket = kEipInvalidSocket;
+    }
 
-        /* if the active socket matches a registered UDP callback, handle a UDP packet */
-        if (sendto(g_network_status.udp_unicast_listener,
-                   (char *) g_ethernet_communication_buffer, reply_length, 0,
-                   (struct sockaddr *) &from_address, sizeof(from_address))
-            != reply_length) {
-          OPENER_TRACE_INFO(
-              "networkhandler: UDP unicast response was not fully sent\n");
-        }
+    int number_of_sent_messages = 0;
+    while (number_of_sent_messages < number_of_messages) {
+      int result = sendmmsg(socket, &messages[number_of_sent_messages],
+                            number_of_messages - number_of_sent_messages, 0);
+      if (0 > result) {
+        int error_code = GetSocketErrorNumber();
+        char* error_message = GetErrorMessage(error_code);
+        OPENER_TRACE_ERR(
+            "networkhandler: error with sendmmsg, datagram dropped: %d - %s\n",
+            error_code, error_message);
+        free(error_message);
+        result = 1; /* skip the failing datagram */
       }
-    } while (remaining_bytes > 0);
+      number_of_sent_messages += result;
+    }
   }
+  g_number_of_queued_datagrams = 0;
 }
+#endif
 
-EipStatus SendUdpData(struct sockaddr_in *address, int socket, EipUint8 *data,
-                      EipUint16 data_length) {
-
-  int sent_length = sendto(socket, (char *) data, data_length, 0,
-                           (struct sockaddr *) address, sizeof(*address));
-
+/** @brief Checks the result of sending a datagram
+ *
+ * @param sent_length The result of the send function
+ * @param data_length Length of the datagram
+ * @param function_name Name of the send function for the trace
+ * @return kEipStatusOk if the whole datagram has been sent,
+ * kEipStatusError otherwise
+ */
+static EipStatus CheckSentDatagram(long sent_length, size_t data_length,
+                                   const char *function_name) {
   if (sent_length < 0) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-	OPENER_TRACE_ERR("networkhandler: error with sendto in sendUDPData: %d - %s\n", error_code, error_message);
-	free(error_message);
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error with %s in sendUDPData: %d - %s\n", function_name, error_code, error_message);
+    free(error_message);
     return kEipStatusError;
   }
 
-  if (sent_length != data_length) {
+  if ((size_t) sent_length != data_length) {
     OPENER_TRACE_WARN(
         "data length sent_length mismatch; probably not all data was sent in SendUdpData, sent %d of %d\n",
-        sent_length, data_length);
+        (int) sent_length, (int) data_length);
     return kEipStatusError;
   }
 
   return kEipStatusOk;
 }
 
-EipStatus HandleDataOnTcpSocket(int socket) {
-  int remaining_bytes = 0;
-  long data_sent = PC_OPENER_ETHERNET_BUFFER_SIZE;
+EipStatus SendDatagramImmediately(int socket, struct sockaddr_in *address,
+                                  EipUint8 *data, size_t data_length) {
 
-  /* We will handle just one EIP packet here the rest is done by the select
-   * method which will inform us if more data is available in the socket
-   because of the current implementation of the main loop this may not be
-   the fastest way and a loop here with a non blocking socket would better
-   fit*/
+  int sent_length = sendto(socket, (char *) data, data_length, 0,
+                           (struct sockaddr *) address, sizeof(*address));
 
-  /*Check how many data is here -- read the first four bytes from the connection */
-  long number_of_read_bytes = recv(socket, g_ethernet_communication_buffer, 4,
-                                   0); /*TODO we may have to set the socket to a non blocking socket */
+  return CheckSentDatagram(sent_length, data_length, "sendto");
+}
 
-  if (number_of_read_bytes == 0) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-	OPENER_TRACE_ERR("networkhandler: connection closed by client: %d - %s\n", error_code, error_message);
-	free(error_message);
+EipStatus SendGatheredDatagramImmediately(int socket,
+                                          struct sockaddr_in *address,
+                                          EipUint8 *header,
+                                          size_t header_length,
+                                          EipUint8 *payload,
+                                          size_t payload_length) {
+#ifdef OPENER_HAVE_SENDMSG
+  struct iovec io_vectors[2];
+  struct msghdr message;
+
+  io_vectors[0].iov_base = header;
+  io_vectors[0].iov_len = header_length;
+  io_vectors[1].iov_base = payload;
+  io_vectors[1].iov_len = payload_length;
+  memset(&message, 0, sizeof(message));
+  message.msg_name = address;
+  message.msg_namelen = sizeof(*address);
+  message.msg_iov = io_vectors;
+  message.msg_iovlen = 2;
+
+  long sent_length = sendmsg(socket, &message, 0);
+
+  return CheckSentDatagram(sent_length, header_length + payload_length,
+                           "sendmsg");
+#else
+  /* no gathering send, assemble the datagram */
+  EipUint8 datagram[PC_OPENER_UDP_BUFFER_SIZE];
+
+  if (header_length + payload_length > sizeof(datagram)) {
+    OPENER_TRACE_ERR("networkhandler: datagram of %d bytes is too long\n",
+                     (int) (header_length + payload_length));
     return kEipStatusError;
   }
-  if (number_of_read_bytes < 0) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-    OPENER_TRACE_ERR("networkhandler: error on recv: %d - %s\n", error_code, error_message);
-	free(error_message);
-    return kEipStatusError;
+  memcpy(datagram, header, header_length);
+  if (0 < payload_length) {
+    memcpy(&datagram[header_length], payload, payload_length);
   }
+  return SendDatagramImmediately(socket, address, datagram,
+                                 header_length + payload_length);
+#endif
+}
 
-  EipUint8 *read_buffer = &g_ethernet_communication_buffer[2]; /* at this place EIP stores the data length */
-  size_t data_size = GetIntFromMessage(&read_buffer)
-      + ENCAPSULATION_HEADER_LENGTH - 4; /* -4 is for the 4 bytes we have already read*/
-  /* (NOTE this advances the buffer pointer) */
-  if ((PC_OPENER_ETHERNET_BUFFER_SIZE - 4) < data_size) { /*TODO can this be handled in a better way?*/
-    OPENER_TRACE_ERR(
-        "too large packet received will be ignored, will drop the data\n");
-    /* Currently we will drop the whole packet */
-
-    do {
-      number_of_read_bytes = recv(socket, &g_ethernet_communication_buffer[0],
-                                  data_sent, 0);
-
-      if (number_of_read_bytes == 0) /* got error or connection closed by client */
-      {
-		int error_code = GetSocketErrorNumber();
-		char* error_message = GetErrorMessage(error_code);
-		OPENER_TRACE_ERR("networkhandler: connection closed by client: %d - %s\n", error_code, error_message);
-		free(error_message);
-        return kEipStatusError;
-      }
-      if (number_of_read_bytes < 0) {
-		int error_code = GetSocketErrorNumber();
-		char* error_message = GetErrorMessage(error_code);
-		OPENER_TRACE_ERR("networkhandler: error on recv: %d - %s\n", error_code, error_message);
-		free(error_message);
-        return kEipStatusError;
-      }
-      data_size -= number_of_read_bytes;
-      if ((data_size < PC_OPENER_ETHERNET_BUFFER_SIZE) && (data_size != 0)) {
-        data_sent = data_size;
+long SendStreamImmediately(int socket, EipUint8 *data, size_t data_length) {
+  long data_sent = send(socket, (char *) data, data_length, 0);
+  if (data_sent < 0) {
+    int error_code = GetSocketErrorNumber();
+    if (SocketErrorIsWouldBlock(error_code)) {
+      return 0; /* the send buffer is full */
+    }
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: error on send: %d - %s\n", error_code,
+                     error_message);
+    free(error_message);
+    return -1;
+  }
+  return data_sent;
+}
+
+void ReceiveDatagram(int socket, DatagramEventHandler handler) {
+  int number_of_datagrams = 0;
+
+#ifdef OPENER_HAVE_RECVMMSG
+  struct mmsghdr messages[OPENER_UDP_RECEIVE_BATCH_SIZE];
+  struct iovec io_vectors[OPENER_UDP_RECEIVE_BATCH_SIZE];
+
+  memset(messages, 0, sizeof(messages));
+  for (int i = 0; i < OPENER_UDP_RECEIVE_BATCH_SIZE; i++) {
+    io_vectors[i].iov_base = g_received_datagrams[i].data;
+    io_vectors[i].iov_len = sizeof(g_received_datagrams[i].data);
+    messages[i].msg_hdr.msg_name = &g_received_datagrams[i].from_address;
+    messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    messages[i].msg_hdr.msg_iov = &io_vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  number_of_datagrams = recvmmsg(socket, messages,
+                                 OPENER_UDP_RECEIVE_BATCH_SIZE, 0, NULL);
+  for (int i = 0; i < number_of_datagrams; i++) {
+    g_received_datagrams[i].data_length = messages[i].msg_len;
+  }
+#else
+  while (number_of_datagrams < OPENER_UDP_RECEIVE_BATCH_SIZE) {
+    ReceivedDatagram *datagram = &g_received_datagrams[number_of_datagrams];
+    socklen_t from_address_length = sizeof(datagram->from_address);
+
+    datagram->data_length = recvfrom(socket, (char *) datagram->data,
+                                     sizeof(datagram->data), 0,
+                                     (struct sockaddr *) &datagram->from_address,
+                                     &from_address_length);
+    if (0 > datagram->data_length) {
+      if (0 == number_of_datagrams) {
+        number_of_datagrams = -1; /* report the error of the first receive */
       }
-    } while (0 < data_size);
-    assert(0 <= data_size);
-    return kEipStatusOk;
+      break;
+    }
+    number_of_datagrams++;
   }
+#endif
 
-  number_of_read_bytes = recv(socket, &g_ethernet_communication_buffer[4],
-                              data_size, 0);
+  if (0 > number_of_datagrams) {
+    if (!SocketErrorIsWouldBlock(GetSocketErrorNumber())) {
+      handler(socket, &g_received_datagrams[0].from_address,
+              g_received_datagrams[0].data, -1);
+    }
+    return;
+  }
 
-  if (number_of_read_bytes == 0) /* got error or connection closed by client */
-  {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-	OPENER_TRACE_ERR("networkhandler: connection closed by client: %d - %s\n", error_code, error_message);
-	free(error_message);
-    return kEipStatusError;
+  CountDrainedDatagrams(number_of_datagrams);
+  for (int i = 0; i < number_of_datagrams; i++) {
+    if (0 < g_received_datagrams[i].data_length) { /* empty datagrams carry nothing to handle */
+      handler(socket, &g_received_datagrams[i].from_address,
+              g_received_datagrams[i].data,
+              g_received_datagrams[i].data_length);
+    }
   }
-  if (number_of_read_bytes < 0) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-	OPENER_TRACE_ERR("networkhandler: error on recv: %d - %s\n", error_code, error_message);
-	free(error_message);
-    return kEipStatusError;
+}
+
+void SetDatagramReceiveStatistics(DatagramReceiveStatistics *statistics) {
+  g_datagram_receive_statistics = statistics;
+}
+
+void CountDrainedDatagrams(int number_of_datagrams) {
+  DatagramReceiveStatistics *statistics = g_datagram_receive_statistics;
+
+  if (0 >= number_of_datagrams) {
+    return;
   }
+  statistics->received_datagrams += number_of_datagrams;
+  if (statistics->largest_batch < (EipUint32) number_of_datagrams) {
+    statistics->largest_batch = number_of_datagrams;
+  }
+  if (OPENER_UDP_RECEIVE_BATCH_SIZE < number_of_datagrams) {
+    number_of_datagrams = OPENER_UDP_RECEIVE_BATCH_SIZE;
+  }
+  statistics->wakeups_by_batch_size[number_of_datagrams - 1]++;
+}
 
-  if ((unsigned) number_of_read_bytes == data_size) {
-    /*we got the right amount of data */
-    data_size += 4;
-    /*TODO handle partial packets*/
-    OPENER_TRACE_INFO("Data received on tcp:\n");
+void ReceiveStream(int socket, StreamEventHandler handler) {
+  /* a single recv() per readiness event keeps the connections served fairly,
+   * the level triggered backends report remaining data again */
+  int received_size = recv(socket, (char *) g_stream_receive_buffer,
+                           sizeof(g_stream_receive_buffer), 0);
 
-    g_current_active_tcp_socket = socket;
+  if ((0 > received_size) && SocketErrorIsWouldBlock(GetSocketErrorNumber())) {
+    return; /* nothing to read anymore */
+  }
+  handler(socket, g_stream_receive_buffer, received_size);
+}
 
-    number_of_read_bytes = HandleReceivedExplictTcpData(
-        socket, g_ethernet_communication_buffer, data_size, &remaining_bytes);
+/** @brief Returns the length of the encapsulation frame starting with the
+ * given header, including the header itself */
+static size_t GetEncapsulationFrameLength(EipUint8 *header) {
+  EipUint8 *length_field = &header[2]; /* at this place EIP stores the data length */
+  return GetIntFromMessage(&length_field) + ENCAPSULATION_HEADER_LENGTH;
+}
 
-    g_current_active_tcp_socket = -1;
+EipStatus HandleDataOnTcpConnection(TcpConnectionBuffer *connection,
+                                    EipUint8 *data, size_t data_length) {
+  int socket = connection->socket;
+
+  while (0 < data_length) {
+    if (0 < connection->unsent_length) { /* the next frames wait for the reply */
+      if (sizeof(connection->held_data) - connection->held_length
+          < data_length) {
+        OPENER_TRACE_ERR(
+            "networkhandler: too much data received on fd %d while a reply is pending\n",
+            socket);
+        return kEipStatusError;
+      }
+      memmove(&connection->held_data[connection->held_length], data,
+              data_length);
+      connection->held_length += data_length;
+      return kEipStatusOk;
+    }
 
-    if (remaining_bytes != 0) {
-      OPENER_TRACE_WARN(
-          "Warning: received packet was to long: %d Bytes left!\n",
-          remaining_bytes);
+    if (0 < connection->bytes_to_discard) {
+      size_t discarded_bytes =
+          (connection->bytes_to_discard < data_length) ?
+              connection->bytes_to_discard : data_length;
+      connection->bytes_to_discard -= discarded_bytes;
+      data += discarded_bytes;
+      data_length -= discarded_bytes;
+      continue;
     }
 
-    if (number_of_read_bytes > 0) {
-      OPENER_TRACE_INFO("reply sent:\n");
+    /* complete frames are handled directly from the received data */
+    if ((0 == connection->fill_level)
+        && (ENCAPSULATION_HEADER_LENGTH <= data_length)) {
+      size_t frame_length = GetEncapsulationFrameLength(data);
+      if (PC_OPENER_ETHERNET_BUFFER_SIZE < frame_length) {
+        OPENER_TRACE_ERR(
+            "too large packet received will be ignored, will drop the data\n");
+        connection->bytes_to_discard = frame_length;
+        continue;
+      }
+      if (frame_length <= data_length) {
+        if (kEipStatusOk
+            != HandleEncapsulationFrameOnTcpSocket(connection, data,
+                                                   frame_length)) {
+          return kEipStatusError;
+        }
+        if (socket != connection->socket) {
+          return kEipStatusOk; /* the session has been closed by the frame */
+        }
+        data += frame_length;
+        data_length -= frame_length;
+        continue;
+      }
+    }
 
-      data_sent = send(socket, (char *) &g_ethernet_communication_buffer[0],
-                       number_of_read_bytes, 0);
-      if (data_sent != number_of_read_bytes) {
-        OPENER_TRACE_WARN("TCP response was not fully sent\n");
+    /* collect the incomplete frame, the header first to learn its length */
+    size_t missing_bytes =
+        (ENCAPSULATION_HEADER_LENGTH > connection->fill_level) ?
+            ENCAPSULATION_HEADER_LENGTH - connection->fill_level :
+            GetEncapsulationFrameLength(connection->buffer)
+                - connection->fill_level;
+    size_t copied_bytes =
+        (missing_bytes < data_length) ? missing_bytes : data_length;
+    memcpy(&connection->buffer[connection->fill_level], data, copied_bytes);
+    connection->fill_level += copied_bytes;
+    data += copied_bytes;
+    data_length -= copied_bytes;
+
+    if (ENCAPSULATION_HEADER_LENGTH <= connection->fill_level) {
+      size_t frame_length = GetEncapsulationFrameLength(connection->buffer);
+      if (PC_OPENER_ETHERNET_BUFFER_SIZE < frame_length) {
+        OPENER_TRACE_ERR(
+            "too large packet received will be ignored, will drop the data\n");
+        connection->bytes_to_discard = frame_length - connection->fill_level;
+        connection->fill_level = 0;
+      } else if (frame_length == connection->fill_level) {
+        connection->fill_level = 0;
+        if (kEipStatusOk
+            != HandleEncapsulationFrameOnTcpSocket(connection,
+                                                   connection->buffer,
+                                                   frame_length)) {
+          return kEipStatusError;
+        }
+        if (socket != connection->socket) {
+          return kEipStatusOk; /* the session has been closed by the frame */
+        }
       }
     }
+  }
+  return kEipStatusOk;
+}
 
-    return kEipStatusOk;
-  } else {
-    /* we got a fragmented packet currently we cannot handle this will
-     * for this we would need a network buffer per TCP socket
-     *
-     * However with typical packet sizes of EIP this should't be a big issue.
-     */
-    /*TODO handle fragmented packets */
+EipStatus HandleEncapsulationFrameOnTcpSocket(TcpConnectionBuffer *connection,
+                                              EipUint8 *frame,
+                                              size_t frame_length) {
+  int remaining_bytes = 0;
+  RequestContext context;
+
+  OPENER_TRACE_INFO("Data received on tcp:\n");
+
+  context.socket = connection->socket;
+  context.originator_address = connection->peer_address;
+
+  int reply_length = HandleReceivedExplictTcpData(&context, frame, frame_length,
+                                                  &remaining_bytes);
+
+  if (remaining_bytes != 0) {
+    OPENER_TRACE_WARN("Warning: received packet was to long: %d Bytes left!\n",
+                      remaining_bytes);
   }
-  return kEipStatusError;
+
+  if (reply_length > 0) {
+    OPENER_TRACE_INFO("reply sent:\n");
+    return SendOnTcpConnection(connection, &context.reply_buffer[0],
+                               reply_length);
+  }
+  return kEipStatusOk;
+}
+
+EipStatus SendOnTcpConnection(TcpConnectionBuffer *connection, EipUint8 *data,
+                              size_t data_length) {
+  long sent_length = EventLoopSendStream(connection->socket, data,
+                                         data_length);
+  if (0 > sent_length) {
+    return kEipStatusError;
+  }
+
+  /* the tail is kept as a partially sent reply breaks the framing of the
+   * stream, data may point into unsent_data */
+  connection->unsent_length = data_length - sent_length;
+  if (0 < connection->unsent_length) {
+    OPENER_TRACE_INFO("networkhandler: fd %d is busy, %d bytes are pending\n",
+                      connection->socket, (int) connection->unsent_length);
+    memmove(connection->unsent_data, &data[sent_length],
+            connection->unsent_length);
+    return EventLoopWatchWritable(connection->socket, HandleTcpSessionWritable);
+  }
+  return kEipStatusOk;
 }
 
 /** @brief create a new UDP socket for the connection manager
  *
  * @param communciation_direction Consuming or producing port
  * @param socket_data Data for socket creation
+ * @param originator_address Address of the originator opening the connection
  *
  * @return the socket handle if successful, else -1 */
 int CreateUdpSocket(UdpCommuncationDirection communication_direction,
-                    struct sockaddr_in *socket_data) {
-  struct sockaddr_in peer_address;
+                    struct sockaddr_in *socket_data,
+                    const struct sockaddr_in *originator_address) {
   int new_socket;
 
-  socklen_t peer_address_length;
-
-  peer_address_length = sizeof(struct sockaddr_in);
-  /* create a new UDP socket */
-  if ((new_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
-	int error_code = GetSocketErrorNumber();
-	char* error_message = GetErrorMessage(error_code);
-	OPENER_TRACE_ERR("networkhandler: cannot create UDP socket: %d- %s\n", error_code, error_message);
-	free(error_message);
-    return kEipInvalidSocket;
-  }
-
-  OPENER_TRACE_INFO("networkhandler: UDP socket %d\n", new_socket);
-
   /* check if it is sending or receiving */
   if (communication_direction == kUdpCommuncationDirectionConsuming) {
-    int option_value = 1;
-    if (setsockopt(new_socket, SOL_SOCKET, SO_REUSEADDR, (char *) &option_value,
-                   sizeof(option_value)) == -1) {
-      OPENER_TRACE_ERR(
-          "error setting socket option SO_REUSEADDR on consuming udp socket\n");
-      return kEipStatusError;
-    }
+    if ((htonl(INADDR_ANY) == socket_data->sin_addr.s_addr)
+        && (htons(kOpenerEipIoUdpPort) == socket_data->sin_port)) {
+      new_socket = g_network_status.udp_io_messaging;
+    } else { /* share one socket per multicast group */
+      MulticastConsumingSocket *unused_socket = NULL;
+      MulticastConsumingSocket *shared_socket = NULL;
+      for (int i = 0; i < OPENER_NUMBER_OF_MULTICAST_CONSUMING_SOCKETS; i++) {
+        MulticastConsumingSocket *candidate = &g_multicast_consuming_sockets[i];
+        if (0 == candidate->number_of_users) {
+          if (NULL == unused_socket) {
+            unused_socket = candidate;
+          }
+        } else if ((socket_data->sin_addr.s_addr
+            == candidate->address.sin_addr.s_addr)
+            && (socket_data->sin_port == candidate->address.sin_port)) {
+          shared_socket = candidate;
+          break;
+        }
+      }
 
-    /* bind is only for consuming necessary */
-    if ((bind(new_socket, (struct sockaddr *) socket_data,
-              sizeof(struct sockaddr))) == -1) {
-		int error_code = GetSocketErrorNumber();
-		char* error_message = GetErrorMessage(error_code);
-		OPENER_TRACE_ERR("error on bind udp: %d - %s\n", error_code, error_message);
-		free(error_message);
-      return kEipInvalidSocket;
+      if (NULL == shared_socket) {
+        if (NULL == unused_socket) {
+          OPENER_TRACE_ERR(
+              "networkhandler: no free multicast consuming socket available\n");
+          return kEipInvalidSocket;
+        }
+        if (kEipInvalidSocket
+            == (unused_socket->socket = CreateConsumingUdpSocket(socket_data))) {
+          return kEipInvalidSocket;
+        }
+        unused_socket->address = *socket_data;
+        shared_socket = unused_socket;
+      }
+      shared_socket->number_of_users++;
+      new_socket = shared_socket->socket;
     }
-
-    OPENER_TRACE_INFO("networkhandler: bind UDP socket %d\n", new_socket);
-  } else { /* we have a producing udp socket */
+  } else { /* we have a producing udp socket, all productions share one socket */
+    new_socket = g_network_status.udp_io_messaging;
 
     if (socket_data->sin_addr.s_addr
         == g_multicast_configuration.starting_multicast_address) {
       if (1 != g_time_to_live_value) { /* we need to set a TTL value for the socket */
         if (setsockopt(new_socket, IPPROTO_IP, IP_MULTICAST_TTL,
                        &g_time_to_live_value,
-                       sizeof(g_time_to_live_value) < 0)) {
+                       sizeof(g_time_to_live_value)) < 0) {
 			int error_code = GetSocketErrorNumber();
 			char* error_message = GetErrorMessage(error_code);
 			OPENER_TRACE_ERR(
@@ -649,80 +1265,101 @@ int CreateUdpSocket(UdpCommuncationDirection communication_direction,
   if ((communication_direction == kUdpCommuncationDirectionConsuming)
       || (0 == socket_data->sin_addr.s_addr)) {
     /* we have a peer to peer producer or a consuming connection*/
-    if (getpeername(g_current_active_tcp_socket,
-                    (struct sockaddr *) &peer_address, &peer_address_length)
-        < 0) {
-		int error_code = GetSocketErrorNumber();
-		char* error_message = GetErrorMessage(error_code);
-		OPENER_TRACE_ERR("networkhandler: could not get peername: %d - %s\n", error_code, error_message);
-		free(error_message);
-      return kEipInvalidSocket;
-    }
     /* store the originators address */
-    socket_data->sin_addr.s_addr = peer_address.sin_addr.s_addr;
+    socket_data->sin_addr.s_addr = originator_address->sin_addr.s_addr;
   }
 
-  /* add new socket to the master list                                             */
-  FD_SET(new_socket, &master_socket);
-  if (new_socket > highest_socket_handle) {
-    highest_socket_handle = new_socket;
-  }
   return new_socket;
 }
 
-void CheckAndHandleConsumingUdpSockets(void) {
-  struct sockaddr_in from_address;
-  socklen_t from_address_length;
-
-  ConnectionObject *connection_object_iterator = g_active_connection_list;
-  ConnectionObject *current_connection_object = NULL;
-
-  /* see a message on one of the registered UDP sockets has been received     */
-  while (NULL != connection_object_iterator) {
-    current_connection_object = connection_object_iterator;
-    connection_object_iterator = connection_object_iterator
-        ->next_connection_object; /* do this at the beginning as the close function may can make the entry invalid */
-
-    if ((-1
-        != current_connection_object->socket[kUdpCommuncationDirectionConsuming])
-        && (true
-            == CheckSocketSet(
-                current_connection_object->socket[kUdpCommuncationDirectionConsuming]))) {
-      from_address_length = sizeof(from_address);
-      int received_size = recvfrom(
-          current_connection_object->socket[kUdpCommuncationDirectionConsuming],
-          g_ethernet_communication_buffer, PC_OPENER_ETHERNET_BUFFER_SIZE, 0,
-          (struct sockaddr *) &from_address, &from_address_length);
-      if (0 == received_size) {
-        OPENER_TRACE_STATE("connection closed by client\n");
-        current_connection_object->connection_close_function(
-            current_connection_object);
-        continue;
-      }
+int CreateConsumingUdpSocket(struct sockaddr_in *address) {
+  int new_socket;
 
-      if (0 > received_size) {
-		int error_code = GetSocketErrorNumber();
-		char* error_message = GetErrorMessage(error_code);
-		OPENER_TRACE_ERR("networkhandler: error on recv: %d - %s\n", error_code, error_message);
-		free(error_message);
-        current_connection_object->connection_close_function(
-            current_connection_object);
-        continue;
-      }
+  /* create a new UDP socket */
+  if ((new_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("networkhandler: cannot create UDP socket: %d- %s\n",
+                     error_code, error_message);
+    free(error_message);
+    return kEipInvalidSocket;
+  }
 
-      HandleReceivedConnectedData(g_ethernet_communication_buffer,
-                                  received_size, &from_address);
+  OPENER_TRACE_INFO("networkhandler: UDP socket %d\n", new_socket);
 
-    }
+  int option_value = 1;
+  if (setsockopt(new_socket, SOL_SOCKET, SO_REUSEADDR, (char *) &option_value,
+                 sizeof(option_value)) == -1) {
+    OPENER_TRACE_ERR(
+        "error setting socket option SO_REUSEADDR on consuming udp socket\n");
+    CloseSocketPlatform(new_socket);
+    return kEipInvalidSocket;
   }
+
+  if ((bind(new_socket, (struct sockaddr *) address,
+            sizeof(struct sockaddr))) == -1) {
+    int error_code = GetSocketErrorNumber();
+    char* error_message = GetErrorMessage(error_code);
+    OPENER_TRACE_ERR("error on bind udp: %d - %s\n", error_code, error_message);
+    free(error_message);
+    CloseSocketPlatform(new_socket);
+    return kEipInvalidSocket;
+  }
+
+  OPENER_TRACE_INFO("networkhandler: bind UDP socket %d\n", new_socket);
+
+  /* consuming sockets have to be watched for received data */
+  if ((kEipStatusOk != SetSocketToNonBlocking(new_socket))
+#ifdef OPENER_IO_THREAD
+      || (kEipStatusOk != IoThreadAddSocket(new_socket, HandleConsumingUdpDatagram))) {
+#else
+      || (kEipStatusOk
+          != EventLoopAddDatagramSocket(new_socket, HandleConsumingUdpDatagram))) {
+#endif
+    CloseSocketPlatform(new_socket);
+    return kEipInvalidSocket;
+  }
+  return new_socket;
 }
 
+void HandleConsumingUdpDatagram(int socket, struct sockaddr_in *from_address,
+                                EipUint8 *data, int data_length) {
+  if (0 >= data_length) {
+    if (0 == data_length) {
+      OPENER_TRACE_STATE("connection closed by client\n");
+    } else {
+      int error_code = GetSocketErrorNumber();
+      char* error_message = GetErrorMessage(error_code);
+      OPENER_TRACE_ERR("networkhandler: error on recv: %d - %s\n", error_code, error_message);
+      free(error_message);
+    }
+    /* the socket is shared by several connections, each of them is closed
+     * by its inactivity watchdog if no more data arrives */
+    return;
+  }
+
+  /* the connection is found by the connection id of the received data */
+  HandleReceivedConnectedData(data, data_length, from_address);
+}
 
 void CloseSocket(int socket_handle) {
 
   OPENER_TRACE_INFO("networkhandler: closing socket %d\n", socket_handle);
   if (kEipInvalidSocket != socket_handle) {
-    FD_CLR(socket_handle, &master_socket);
+#ifdef OPENER_BATCHED_PRODUCTION
+    for (int i = 0; i < g_number_of_queued_datagrams; i++) {
+      if (socket_handle == g_queued_datagrams[i].socket) {
+        g_queued_datagrams[i].socket = kEipInvalidSocket; /* the descriptor may be reused */
+      }
+    }
+#endif
+    for (int i = 0; i < g_number_of_tcp_connections_in_slice; i++) {
+      if (socket_handle == g_tcp_connection_slice[i].socket) {
+        g_tcp_connection_slice[i].socket = kEipInvalidSocket;
+        break;
+      }
+    }
+    EventLoopRemoveSocket(socket_handle);
     CloseSocketPlatform(socket_handle);
   }
 }
@@ -739,3 +1376,205 @@ int GetMaxSocket(int socket1, int socket2, int socket3, int socket4) {
 
   return socket4;
 }
+
+#if !defined(OPENER_USE_EPOLL) && !defined(OPENER_USE_IO_URING)
+
+/** @brief Registration of a socket with the select() based event loop */
+typedef struct {
+  int socket; /**< the watched socket */
+  SocketEventHandler handler; /**< function called when the socket is readable */
+  DatagramEventHandler datagram_handler; /**< if set, datagrams are received by the event loop */
+  StreamEventHandler stream_handler; /**< if set, stream data is received by the event loop */
+  SocketEventHandler writable_handler; /**< if set, reading is paused until the socket is writable */
+} SocketEventRegistration;
+
+/** @brief Sockets watched by the select() based event loop
+ *
+ * The table is kept dense, removed entries are replaced by the last entry.
+ * Every thread running an event loop has its own table.
+ */
+static OPENER_THREAD_LOCAL SocketEventRegistration g_socket_registrations[FD_SETSIZE];
+static OPENER_THREAD_LOCAL int g_number_of_socket_registrations = 0;
+
+/** @brief Sockets watched for writability instead of readability, see
+ * EventLoopWatchWritable */
+static OPENER_THREAD_LOCAL fd_set g_master_write_socket;
+static OPENER_THREAD_LOCAL fd_set g_write_socket;
+
+EipStatus EventLoopInitialize(void) {
+  FD_ZERO(&master_socket);
+  FD_ZERO(&read_socket);
+  FD_ZERO(&g_master_write_socket);
+  highest_socket_handle = 0;
+  g_number_of_socket_registrations = 0;
+  return kEipStatusOk;
+}
+
+void EventLoopShutdown(void) {
+  FD_ZERO(&master_socket);
+  FD_ZERO(&g_master_write_socket);
+  g_number_of_socket_registrations = 0;
+}
+
+/** @brief Registers the socket with either a readiness, a datagram or a
+ * stream handler
+ *
+ * @param socket The socket to be watched
+ * @param handler Readiness handler or NULL
+ * @param datagram_handler Datagram handler or NULL
+ * @param stream_handler Stream handler or NULL
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+static EipStatus AddSocketRegistration(int socket, SocketEventHandler handler,
+                                       DatagramEventHandler datagram_handler,
+                                       StreamEventHandler stream_handler) {
+  for (int i = 0; i < g_number_of_socket_registrations; i++) {
+    if (socket == g_socket_registrations[i].socket) {
+      g_socket_registrations[i].handler = handler;
+      g_socket_registrations[i].datagram_handler = datagram_handler;
+      g_socket_registrations[i].stream_handler = stream_handler;
+      g_socket_registrations[i].writable_handler = NULL;
+      FD_CLR(socket, &g_master_write_socket);
+      FD_SET(socket, &master_socket);
+      return kEipStatusOk;
+    }
+  }
+
+  if (FD_SETSIZE <= g_number_of_socket_registrations) {
+    OPENER_TRACE_ERR("networkhandler: cannot watch more than %d sockets\n",
+                     FD_SETSIZE);
+    return kEipStatusError;
+  }
+#ifndef WIN32
+  if (FD_SETSIZE <= socket) { /* fd_set is a bit field indexed by the descriptor */
+    OPENER_TRACE_ERR("networkhandler: socket %d exceeds FD_SETSIZE\n", socket);
+    return kEipStatusError;
+  }
+#endif
+
+  g_socket_registrations[g_number_of_socket_registrations].socket = socket;
+  g_socket_registrations[g_number_of_socket_registrations].handler = handler;
+  g_socket_registrations[g_number_of_socket_registrations].datagram_handler =
+      datagram_handler;
+  g_socket_registrations[g_number_of_socket_registrations].stream_handler =
+      stream_handler;
+  g_socket_registrations[g_number_of_socket_registrations].writable_handler =
+      NULL;
+  g_number_of_socket_registrations++;
+
+  FD_SET(socket, &master_socket);
+  if (socket > highest_socket_handle) {
+    highest_socket_handle = socket;
+  }
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopAddSocket(int socket, SocketEventHandler handler) {
+  return AddSocketRegistration(socket, handler, NULL, NULL);
+}
+
+EipStatus EventLoopAddDatagramSocket(int socket, DatagramEventHandler handler) {
+  return AddSocketRegistration(socket, NULL, handler, NULL);
+}
+
+EipStatus EventLoopAddStreamSocket(int socket, StreamEventHandler handler) {
+  return AddSocketRegistration(socket, NULL, NULL, handler);
+}
+
+void EventLoopRemoveSocket(int socket) {
+  for (int i = 0; i < g_number_of_socket_registrations; i++) {
+    if (socket == g_socket_registrations[i].socket) {
+      g_number_of_socket_registrations--;
+      g_socket_registrations[i] =
+          g_socket_registrations[g_number_of_socket_registrations];
+      FD_CLR(socket, &master_socket);
+      FD_CLR(socket, &g_master_write_socket);
+      break;
+    }
+  }
+}
+
+EipStatus EventLoopWatchWritable(int socket, SocketEventHandler handler) {
+  for (int i = 0; i < g_number_of_socket_registrations; i++) {
+    if (socket == g_socket_registrations[i].socket) {
+      g_socket_registrations[i].writable_handler = handler;
+      FD_CLR(socket, &master_socket);
+      FD_SET(socket, &g_master_write_socket);
+      return kEipStatusOk;
+    }
+  }
+  return kEipStatusError;
+}
+
+EipStatus EventLoopDispatchEvents(MicroSeconds timeout) {
+  read_socket = master_socket;
+  g_write_socket = g_master_write_socket;
+
+  g_time_value.tv_sec = timeout / 1000000;
+  g_time_value.tv_usec = timeout % 1000000;
+
+  int ready_socket = select(highest_socket_handle + 1, &read_socket,
+                            &g_write_socket, 0, &g_time_value);
+
+  if (ready_socket == kEipInvalidSocket) {
+    if (EINTR == errno) /* we have somehow been interrupted. The default behavior is to go back into the select loop. */
+    {
+      return kEipStatusOk;
+    } else {
+      int error_code = GetSocketErrorNumber();
+      char* error_message = GetErrorMessage(error_code);
+      OPENER_TRACE_ERR("networkhandler: error with select: %d - %s\n", error_code, error_message);
+      free(error_message);
+      return kEipStatusError;
+    }
+  }
+
+  /* A handler may remove registrations, CheckSocketSet therefore clears each
+   * handled socket from the read set. Sockets skipped because of a removal are
+   * still readable and will be reported by the next select() call. */
+  for (int i = 0; (0 < ready_socket) && (i < g_number_of_socket_registrations);
+      i++) {
+    int socket = g_socket_registrations[i].socket;
+    SocketEventHandler writable_handler =
+        g_socket_registrations[i].writable_handler;
+    if ((NULL != writable_handler) && FD_ISSET(socket, &g_write_socket)) {
+      ready_socket--;
+      FD_CLR(socket, &g_write_socket);
+      /* resume reading before the handler may pause it again */
+      g_socket_registrations[i].writable_handler = NULL;
+      FD_CLR(socket, &g_master_write_socket);
+      FD_SET(socket, &master_socket);
+      writable_handler(socket);
+    } else if (true == CheckSocketSet(socket)) {
+      ready_socket--;
+      if (NULL != g_socket_registrations[i].datagram_handler) {
+        ReceiveDatagram(socket, g_socket_registrations[i].datagram_handler);
+      } else if (NULL != g_socket_registrations[i].stream_handler) {
+        ReceiveStream(socket, g_socket_registrations[i].stream_handler);
+      } else {
+        g_socket_registrations[i].handler(socket);
+      }
+    }
+  }
+  return kEipStatusOk;
+}
+
+EipStatus EventLoopSendDatagram(int socket, struct sockaddr_in *address,
+                                EipUint8 *data, size_t data_length) {
+  return SendDatagramImmediately(socket, address, data, data_length);
+}
+
+EipStatus EventLoopSendGatheredDatagram(int socket,
+                                        struct sockaddr_in *address,
+                                        EipUint8 *header, size_t header_length,
+                                        EipUint8 *payload,
+                                        size_t payload_length) {
+  return SendGatheredDatagramImmediately(socket, address, header, header_length,
+                                         payload, payload_length);
+}
+
+long EventLoopSendStream(int socket, EipUint8 *data, size_t data_length) {
+  return SendStreamImmediately(socket, data, data_length);
+}
+
+#endif /* !OPENER_USE_EPOLL && !OPENER_USE_IO_URING */
@@ -27,25 +27,69 @@
 
 #define MAX_NO_OF_TCP_SOCKETS 10
 
+#if defined(OPENER_IO_THREAD) || defined(OPENER_TCP_WORKERS)
+/** Buffers and event loop state used by several threads of the stack alike
+ * exist once per thread */
+#define OPENER_THREAD_LOCAL __thread
+#else
+#define OPENER_THREAD_LOCAL
+#endif
+
+#ifndef OPENER_UDP_RECEIVE_BATCH_SIZE
+/** @brief Maximum number of datagrams drained from a ready UDP socket at once */
+#define OPENER_UDP_RECEIVE_BATCH_SIZE 16
+#endif
+
+#ifndef OPENER_UDP_SEND_BATCH_SIZE
+/** @brief Maximum number of produced datagrams collected before they are sent
+ * with sendmmsg(), only used with OPENER_BATCHED_PRODUCTION */
+#define OPENER_UDP_SEND_BATCH_SIZE 64
+#endif
+
+#ifndef OPENER_NUMBER_OF_MULTICAST_CONSUMING_SOCKETS
+/** @brief Number of multicast groups I/O connections may consume from at the
+ * same time, all connections consuming from one group share its socket */
+#define OPENER_NUMBER_OF_MULTICAST_CONSUMING_SOCKETS 8
+#endif
+
+#ifndef OPENER_NUMBER_OF_TCP_CONNECTIONS
+/** @brief Number of TCP connections which may be open at the same time, each
+ * of them owns a reassembly and an unsent reply buffer of
+ * PC_OPENER_ETHERNET_BUFFER_SIZE bytes and OPENER_TCP_HELD_DATA_SIZE bytes for
+ * held back data */
+#define OPENER_NUMBER_OF_TCP_CONNECTIONS OPENER_NUMBER_OF_SUPPORTED_SESSIONS
+#endif
+
+#ifndef OPENER_TCP_HELD_DATA_SIZE
+/** @brief Number of received bytes a TCP connection holds back while the
+ * socket cannot take its last reply, at least one received chunk (the
+ * io_uring backend receives up to PC_OPENER_UDP_BUFFER_SIZE bytes at once) */
+#define OPENER_TCP_HELD_DATA_SIZE (2 * PC_OPENER_UDP_BUFFER_SIZE)
+#endif
+
 /* values needed from the connection manager */
 extern ConnectionObject *g_active_connection_list;
 
-EipUint8 g_ethernet_communication_buffer[PC_OPENER_ETHERNET_BUFFER_SIZE]; /**< communication buffer */
+extern OPENER_THREAD_LOCAL fd_set master_socket;
+extern OPENER_THREAD_LOCAL fd_set read_socket;
 
-fd_set master_socket;
-fd_set read_socket;
+extern OPENER_THREAD_LOCAL int highest_socket_handle; /**< temporary file descriptor for select() */
 
-int highest_socket_handle; /**< temporary file descriptor for select() */
+extern OPENER_THREAD_LOCAL struct timeval g_time_value;
+MicroSeconds g_actual_time;
+MicroSeconds g_last_time;
 
-/** @brief This variable holds the TCP socket the received to last explicit message.
- * It is needed for opening point to point connection to determine the peer's
- * address.
+/** @brief Counters on the draining of ready UDP sockets
+ *
  */
-int g_current_active_tcp_socket;
-
-struct timeval g_time_value;
-MilliSeconds g_actual_time;
-MilliSeconds g_last_time;
+typedef struct {
+  EipUint32 received_datagrams; /**< datagrams received in total */
+  EipUint32 largest_batch; /**< most datagrams drained at one wakeup */
+  /** number of wakeups by the number of datagrams drained, index 0 counts
+   * wakeups draining a single datagram, the last entry also counts larger
+   * batches of backends which are not bound to the batch size (io_uring) */
+  EipUint32 wakeups_by_batch_size[OPENER_UDP_RECEIVE_BATCH_SIZE];
+} DatagramReceiveStatistics;
 
 /** @brief Struct representing the current network status
  *
@@ -54,11 +98,52 @@ typedef struct {
   int tcp_listener; /**< TCP listener socket */
   int udp_unicast_listener; /**< UDP unicast listener socket */
   int udp_global_broadcast_listener; /**< UDP global network broadcast listener */
-  MilliSeconds elapsed_time;
+  int udp_io_messaging; /**< UDP socket on port 2222 shared by all I/O connections */
+  MicroSeconds elapsed_time; /**< time since the last call of ManageConnections */
+  DatagramReceiveStatistics datagram_receive_statistics; /**< batch sizes of the UDP receive path */
+#ifdef OPENER_IO_THREAD
+  DatagramReceiveStatistics io_thread_datagram_receive_statistics; /**< batch sizes of the I/O sockets drained by the I/O thread */
+#endif
 } NetworkStatus;
 
 NetworkStatus g_network_status; /**< Global variable holding the current network status */
 
+/** @brief Callback invoked by the event loop when a registered socket is ready
+ * for reading
+ *
+ * @param socket The socket which is ready
+ */
+typedef void (*SocketEventHandler)(int socket);
+
+/** @brief Callback invoked by the event loop for each datagram received on a
+ * registered UDP socket
+ *
+ * The buffer holding the datagram provides PC_OPENER_UDP_BUFFER_SIZE bytes,
+ * so replies may be assembled in place.
+ *
+ * @param socket The socket the datagram has been received on
+ * @param from_address The sender of the datagram
+ * @param data The received datagram
+ * @param data_length Length of the datagram, 0 or less if receiving failed
+ */
+typedef void (*DatagramEventHandler)(int socket,
+                                     struct sockaddr_in *from_address,
+                                     EipUint8 *data, int data_length);
+
+/** @brief Callback invoked by the event loop for data received on a registered
+ * TCP socket
+ *
+ * The data is a section of the byte stream and neither starts nor ends at
+ * encapsulation frame boundaries necessarily.
+ *
+ * @param socket The socket the data has been received on
+ * @param data The received data
+ * @param data_length Number of received bytes, 0 if the peer closed the
+ * connection, less than 0 if receiving failed
+ */
+typedef void (*StreamEventHandler)(int socket, EipUint8 *data,
+                                   int data_length);
+
 /** @brief The platform independent part of network handler initialization routine
  *
  *  @return Returns the OpENer status after the initialization routine
@@ -80,6 +165,32 @@ EipStatus NetworkHandlerProcessOnce(void);
 
 EipStatus NetworkHandlerFinish(void);
 
+/** @brief Creates the TCP listener socket on port 0xAF12 (CIP)
+ *
+ * With OPENER_TCP_WORKERS every worker creates its own listener, the kernel
+ * distributes the incoming connections among them (SO_REUSEPORT).
+ *
+ *  @return the listening socket if successful, else kEipInvalidSocket
+ */
+int CreateTcpListener(void);
+
+/** @brief handle any connection request coming in the TCP server socket.
+ *
+ *  @param socket The TCP listener socket
+ */
+void HandleTcpListenerSocket(int socket);
+
+/** @brief Restricts the TCP connections of the calling thread to a slice of
+ * the OPENER_NUMBER_OF_TCP_CONNECTIONS reassembly buffers
+ *
+ * A thread serving TCP connections besides the main thread owns its slice
+ * exclusively, the main thread uses all buffers by default.
+ *
+ *  @param first_connection Index of the first buffer of the slice
+ *  @param number_of_connections Number of buffers in the slice
+ */
+void SetTcpConnectionSlice(int first_connection, int number_of_connections);
+
 /** @brief check if the given socket is set in the read set
  * @param socket The socket to check
  * @return true if socket is set
@@ -96,4 +207,226 @@ EipBool8 CheckSocketSet(int socket);
  */
 int GetMaxSocket(int socket1, int socket2, int socket3, int socket4);
 
+/** @brief Initializes the event loop backend used by the network handler
+ *
+ * The select() based backend in generic_networkhandler.c is used unless the
+ * platform provides its own backend (e.g., epoll or io_uring on Linux, enabled
+ * with OPENER_USE_EPOLL or OPENER_USE_IO_URING).
+ *
+ *  @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus EventLoopInitialize(void);
+
+/** @brief Releases all resources held by the event loop backend */
+void EventLoopShutdown(void);
+
+/** @brief Registers a socket with the event loop
+ *
+ * Whenever the socket becomes readable the given handler is invoked with the
+ * socket as argument. Registering an already registered socket replaces its
+ * handler.
+ *
+ * @param socket The socket to be watched
+ * @param handler The function handling the readiness of the socket
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus EventLoopAddSocket(int socket, SocketEventHandler handler);
+
+/** @brief Registers a UDP socket with the event loop
+ *
+ * The event loop receives the datagrams itself and hands each of them to the
+ * given handler. This allows completion based backends (io_uring) to keep
+ * receives posted on the socket.
+ *
+ * @param socket The UDP socket to be watched
+ * @param handler The function handling each received datagram
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus EventLoopAddDatagramSocket(int socket, DatagramEventHandler handler);
+
+/** @brief Registers a TCP socket with the event loop
+ *
+ * The event loop receives the data of the connection itself and hands it to
+ * the given handler as it arrives.
+ *
+ * @param socket The connected TCP socket to be watched
+ * @param handler The function handling the received data
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus EventLoopAddStreamSocket(int socket, StreamEventHandler handler);
+
+/** @brief Removes a socket from the event loop
+ *
+ * Pending readiness events of the socket are discarded. Removing a socket
+ * which is not registered has no effect.
+ *
+ * @param socket The socket to be removed
+ */
+void EventLoopRemoveSocket(int socket);
+
+/** @brief Waits for socket readiness and invokes the registered handlers
+ *
+ * @param timeout Maximum time to wait for events in microseconds
+ * @return kEipStatusOk on success (also on timeout or interruption by a
+ * signal), kEipStatusError if waiting for events failed
+ */
+EipStatus EventLoopDispatchEvents(MicroSeconds timeout);
+
+/** @brief Sends a datagram via the event loop backend
+ *
+ * The data is copied if the backend defers the transmission, the buffer may be
+ * reused as soon as the function returns.
+ *
+ * @param socket The UDP socket to send on
+ * @param address The receiver of the datagram
+ * @param data The datagram to be sent
+ * @param data_length Length of the datagram
+ * @return kEipStatusOk if the datagram has been sent or queued,
+ * kEipStatusError otherwise
+ */
+EipStatus EventLoopSendDatagram(int socket, struct sockaddr_in *address,
+                                EipUint8 *data, size_t data_length);
+
+/** @brief Sends a datagram gathered from a header and a payload via the event
+ * loop backend
+ *
+ * The data is copied if the backend defers the transmission, the buffers may
+ * be reused as soon as the function returns.
+ *
+ * @param socket The UDP socket to send on
+ * @param address The receiver of the datagram
+ * @param header The first part of the datagram
+ * @param header_length Length of the header
+ * @param payload The part of the datagram following the header
+ * @param payload_length Length of the payload
+ * @return kEipStatusOk if the datagram has been sent or queued,
+ * kEipStatusError otherwise
+ */
+EipStatus EventLoopSendGatheredDatagram(int socket,
+                                        struct sockaddr_in *address,
+                                        EipUint8 *header, size_t header_length,
+                                        EipUint8 *payload,
+                                        size_t payload_length);
+
+/** @brief Sends data on a TCP socket via the event loop backend
+ *
+ * The backend may take only a leading part of the data if the socket cannot
+ * take more at the moment. The caller keeps the rest and offers it again when
+ * the handler passed to EventLoopWatchWritable is invoked.
+ *
+ * @param socket The TCP socket to send on
+ * @param data The data to be sent, may be reused when the function returns
+ * @param data_length Length of the data
+ * @return the number of bytes sent or queued, -1 if sending failed
+ */
+long EventLoopSendStream(int socket, EipUint8 *data, size_t data_length);
+
+/** @brief Pauses reading from a registered TCP socket until the socket can
+ * take data again
+ *
+ * The handler is invoked once the socket can take data again, reading is
+ * resumed before. Backends receiving ahead (io_uring) may still hand data
+ * received before the pause to the stream handler.
+ *
+ * @param socket The TCP socket registered with EventLoopAddStreamSocket
+ * @param handler The function called when the socket can take data
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus EventLoopWatchWritable(int socket, SocketEventHandler handler);
+
+/** @brief Drains up to OPENER_UDP_RECEIVE_BATCH_SIZE datagrams from the
+ * socket and hands each of them to the given handler
+ *
+ * Used by readiness based event loop backends to serve sockets registered with
+ * EventLoopAddDatagramSocket. The datagrams are received with a single
+ * recvmmsg() call where available. The socket has to be non-blocking.
+ *
+ * @param socket The UDP socket which is ready for reading
+ * @param handler The datagram handler registered for the socket
+ */
+void ReceiveDatagram(int socket, DatagramEventHandler handler);
+
+/** @brief Receives the data available on a TCP socket and hands it to the
+ * given handler
+ *
+ * Used by readiness based event loop backends to serve sockets registered with
+ * EventLoopAddStreamSocket. The socket has to be non-blocking.
+ *
+ * @param socket The TCP socket which is ready for reading
+ * @param handler The stream handler registered for the socket
+ */
+void ReceiveStream(int socket, StreamEventHandler handler);
+
+/** @brief Adds the number of datagrams drained at one wakeup to the
+ * statistics in g_network_status
+ *
+ * @param number_of_datagrams Number of datagrams handled at the wakeup
+ */
+void CountDrainedDatagrams(int number_of_datagrams);
+
+/** @brief Selects the statistics CountDrainedDatagrams of the calling thread
+ * adds to
+ *
+ * Threads other than the main thread draining sockets keep their own
+ * statistics, g_network_status.datagram_receive_statistics is used by default.
+ *
+ * @param statistics The statistics of the calling thread
+ */
+void SetDatagramReceiveStatistics(DatagramReceiveStatistics *statistics);
+
+/** @brief Starts collecting the I/O productions of the calling thread
+ *
+ * Datagrams sent with SendUdpData are queued until EndDatagramBatch if
+ * batched production is enabled.
+ */
+void BeginDatagramBatch(void);
+
+/** @brief Sends the I/O productions collected since BeginDatagramBatch */
+void EndDatagramBatch(void);
+
+/** @brief Sends a datagram immediately with sendto()
+ *
+ * @param socket The UDP socket to send on
+ * @param address The receiver of the datagram
+ * @param data The datagram to be sent
+ * @param data_length Length of the datagram
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus SendDatagramImmediately(int socket, struct sockaddr_in *address,
+                                  EipUint8 *data, size_t data_length);
+
+/** @brief Sends a datagram gathered from a header and a payload immediately
+ * with sendmsg(), without copying the payload
+ *
+ * Platforms without sendmsg() assemble the datagram and send it with
+ * SendDatagramImmediately.
+ *
+ * @param socket The UDP socket to send on
+ * @param address The receiver of the datagram
+ * @param header The first part of the datagram
+ * @param header_length Length of the header
+ * @param payload The part of the datagram following the header
+ * @param payload_length Length of the payload
+ * @return kEipStatusOk on success, kEipStatusError otherwise
+ */
+EipStatus SendGatheredDatagramImmediately(int socket,
+                                          struct sockaddr_in *address,
+                                          EipUint8 *header,
+                                          size_t header_length,
+                                          EipUint8 *payload,
+                                          size_t payload_length);
+
+/** @brief Sends data immediately on a TCP socket with send()
+ *
+ * As TCP sockets are non-blocking only the part of the data which fits into
+ * the socket's send buffer is sent.
+ *
+ * @param socket The TCP socket to send on
+ * @param data The data to be sent
+ * @param data_length Length of the data
+ * @return the number of bytes sent, 0 if the socket cannot take data at the
+ * moment, -1 if sending failed
+ */
+long SendStreamImmediately(int socket, EipUint8 *data, size_t data_length);
+
 #endif /* GENERIC_NETWORKHANDLER_H_ */
\ No newline at end of file
@@ -0,0 +1,49 @@
+/*
+ * arena.c
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+
+void ArenaInit(Arena *arena, void *storage, size_t capacity) {
+  arena->storage = storage;
+  arena->capacity = capacity;
+  arena->used = 0;
+  arena->is_sealed = 0;
+}
+
+void *ArenaAllocate(Arena *arena, size_t size) {
+  if (arena->is_sealed) {
+    return NULL;
+  }
+  /* align the address, not the offset, the storage may be aligned less */
+  uintptr_t start = (uintptr_t) (arena->storage + arena->used);
+  size_t padding = (size_t) ((ARENA_ALIGNMENT
+      - (start & (ARENA_ALIGNMENT - 1))) & (ARENA_ALIGNMENT - 1));
+
+  if ((padding > arena->capacity - arena->used)
+      || (size > arena->capacity - arena->used - padding)) {
+    return NULL;
+  }
+  unsigned char *block = arena->storage + arena->used + padding;
+  arena->used += padding + size;
+  memset(block, 0, size);
+  return block;
+}
+
+int ArenaContains(const Arena *arena, const void *memory) {
+  uintptr_t address = (uintptr_t) memory;
+  uintptr_t start = (uintptr_t) arena->storage;
+  return (address >= start) && (address - start < arena->capacity);
+}
+
+void ArenaSeal(Arena *arena) {
+  arena->is_sealed = 1;
+}
+
+void ArenaReset(Arena *arena) {
+  arena->used = 0;
+  arena->is_sealed = 0;
+}
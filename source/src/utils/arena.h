@@ -0,0 +1,65 @@
+/*
+ * arena.h
+ */
+
+/**
+ * @file arena.h
+ *
+ * A bump allocator on one contiguous region of memory. Allocating advances a
+ * fill level, single blocks are never returned; all blocks are released at
+ * once by resetting the arena. After sealing, the arena refuses to allocate so
+ * that allocations after the start-up phase can be detected.
+ */
+#include <stddef.h>
+
+#ifndef OPENER_ARENA_H_
+#define OPENER_ARENA_H_
+
+/** @brief Alignment of the blocks handed out, in bytes */
+#define ARENA_ALIGNMENT 16
+
+/** @brief An arena on caller provided storage */
+typedef struct {
+  unsigned char *storage;
+  size_t capacity; /**< size of the storage in bytes */
+  size_t used; /**< fill level in bytes, including the alignment padding */
+  int is_sealed; /**< no further allocations are made if set */
+} Arena;
+
+/**
+ * @brief Initializes an empty, unsealed arena
+ * @param arena The arena to be initialized
+ * @param storage The memory handed out by the arena
+ * @param capacity Size of the storage in bytes
+ */
+void ArenaInit(Arena *arena, void *storage, size_t capacity);
+
+/**
+ * @brief Takes a zeroed block aligned to ARENA_ALIGNMENT from the arena
+ * @param arena The arena to allocate from
+ * @param size Size of the block in bytes
+ * @return The block, NULL if the arena is sealed or exhausted
+ */
+void *ArenaAllocate(Arena *arena, size_t size);
+
+/**
+ * @brief Checks if memory belongs to the storage of the arena
+ * @param arena The arena
+ * @param memory The memory to be checked
+ * @return 1 if the memory lies within the storage, 0 otherwise
+ */
+int ArenaContains(const Arena *arena, const void *memory);
+
+/**
+ * @brief Refuses all further allocations until the arena is reset
+ * @param arena The arena to be sealed
+ */
+void ArenaSeal(Arena *arena);
+
+/**
+ * @brief Releases all blocks at once and unseals the arena
+ * @param arena The arena to be reset
+ */
+void ArenaReset(Arena *arena);
+
+#endif /* OPENER_ARENA_H_ */
@@ -0,0 +1,45 @@
+/*
+ * spscqueue.c
+ */
+
+#include <string.h>
+
+#include "spscqueue.h"
+
+void SpscQueueInit(SpscQueue *queue, void *storage, size_t element_size,
+                   size_t capacity) {
+  queue->elements = storage;
+  queue->element_size = element_size;
+  queue->capacity = capacity;
+  queue->head = 0;
+  queue->tail = 0;
+}
+
+int SpscQueuePush(SpscQueue *queue, const void *element) {
+  size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+  size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+  if (queue->capacity == tail - head) {
+    return -1;
+  }
+  memcpy(&queue->elements[(tail & (queue->capacity - 1)) * queue->element_size],
+         element, queue->element_size);
+  /* publish the element to the consumer */
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+int SpscQueuePop(SpscQueue *queue, void *element) {
+  size_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+  if (head == tail) {
+    return -1;
+  }
+  memcpy(element,
+         &queue->elements[(head & (queue->capacity - 1)) * queue->element_size],
+         queue->element_size);
+  /* hand the slot back to the producer */
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return 0;
+}
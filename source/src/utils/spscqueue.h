@@ -0,0 +1,54 @@
+/*
+ * spscqueue.h
+ */
+
+/**
+ * @file spscqueue.h
+ *
+ * A bounded first-in first-out queue of fixed size elements for exactly one
+ * producing and one consuming thread. Pushing and popping never block and need
+ * no locks, the two threads synchronize through the acquire and release
+ * semantics of the head and tail counters only.
+ */
+#include <stddef.h>
+
+#ifndef OPENER_SPSCQUEUE_H_
+#define OPENER_SPSCQUEUE_H_
+
+/** @brief A single producer single consumer queue */
+typedef struct {
+  unsigned char *elements; /**< storage of capacity elements */
+  size_t element_size;
+  size_t capacity; /**< a power of two */
+  size_t head; /**< number of elements popped, written by the consumer */
+  size_t tail; /**< number of elements pushed, written by the producer */
+} SpscQueue;
+
+/**
+ * @brief Initializes an empty queue
+ * @param queue The queue to be initialized
+ * @param storage Storage for capacity elements
+ * @param element_size Size of one element in bytes
+ * @param capacity Number of elements fitting into the storage, has to be a
+ * power of two
+ */
+void SpscQueueInit(SpscQueue *queue, void *storage, size_t element_size,
+                   size_t capacity);
+
+/**
+ * @brief Appends a copy of the element, only to be called by the producer
+ * @param queue The queue to append to
+ * @param element The element to be copied into the queue
+ * @return 0 on success, -1 if the queue is full
+ */
+int SpscQueuePush(SpscQueue *queue, const void *element);
+
+/**
+ * @brief Removes the oldest element, only to be called by the consumer
+ * @param queue The queue to take the element from
+ * @param element Receives the copy of the removed element
+ * @return 0 on success, -1 if the queue is empty
+ */
+int SpscQueuePop(SpscQueue *queue, void *element);
+
+#endif /* OPENER_SPSCQUEUE_H_ */
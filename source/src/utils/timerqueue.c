@@ -0,0 +1,139 @@
+/*
+ * timerqueue.c
+ */
+
+#include "timerqueue.h"
+
+/** @brief Stores the timer at the given heap index */
+static void PlaceTimer(TimerQueue *queue, QueuedTimer *timer, size_t index) {
+  queue->heap[index] = timer;
+  timer->position = index + 1;
+}
+
+/** @brief Moves the timer at the given index towards the root until its
+ * parent is not due later */
+static void SiftUp(TimerQueue *queue, size_t index) {
+  QueuedTimer *timer = queue->heap[index];
+  while (0 < index) {
+    size_t parent = (index - 1) / 2;
+    if (queue->heap[parent]->due_time <= timer->due_time) {
+      break;
+    }
+    PlaceTimer(queue, queue->heap[parent], index);
+    index = parent;
+  }
+  PlaceTimer(queue, timer, index);
+}
+
+/** @brief Moves the timer at the given index towards the leaves until no
+ * child is due earlier */
+static void SiftDown(TimerQueue *queue, size_t index) {
+  QueuedTimer *timer = queue->heap[index];
+  for (;;) {
+    size_t child = 2 * index + 1;
+    if (child >= queue->number_of_timers) {
+      break;
+    }
+    if ((child + 1 < queue->number_of_timers)
+        && (queue->heap[child + 1]->due_time < queue->heap[child]->due_time)) {
+      child++;
+    }
+    if (timer->due_time <= queue->heap[child]->due_time) {
+      break;
+    }
+    PlaceTimer(queue, queue->heap[child], index);
+    index = child;
+  }
+  PlaceTimer(queue, timer, index);
+}
+
+void TimerQueueInit(TimerQueue *queue, QueuedTimer **storage, size_t capacity) {
+  queue->heap = storage;
+  queue->number_of_timers = 0;
+  queue->capacity = capacity;
+}
+
+int TimerQueueSchedule(TimerQueue *queue, QueuedTimer *timer,
+                       uint64_t due_time) {
+  if (IsTimerQueued(timer)) {
+    uint64_t previous_due_time = timer->due_time;
+    timer->due_time = due_time;
+    if (due_time < previous_due_time) {
+      SiftUp(queue, timer->position - 1);
+    } else {
+      SiftDown(queue, timer->position - 1);
+    }
+    return 0;
+  }
+
+  if (queue->number_of_timers == queue->capacity) {
+    return -1;
+  }
+  timer->due_time = due_time;
+  PlaceTimer(queue, timer, queue->number_of_timers++);
+  SiftUp(queue, queue->number_of_timers - 1);
+  return 0;
+}
+
+void TimerQueueCancel(TimerQueue *queue, QueuedTimer *timer) {
+  if (!IsTimerQueued(timer)) {
+    return;
+  }
+  size_t index = timer->position - 1;
+  timer->position = 0;
+
+  queue->number_of_timers--;
+  if (index == queue->number_of_timers) {
+    return; /* the last timer has been removed */
+  }
+  /* fill the gap with the last timer and restore the heap order */
+  PlaceTimer(queue, queue->heap[queue->number_of_timers], index);
+  if ((0 < index)
+      && (queue->heap[(index - 1) / 2]->due_time
+          > queue->heap[index]->due_time)) {
+    SiftUp(queue, index);
+  } else {
+    SiftDown(queue, index);
+  }
+}
+
+QueuedTimer *TimerQueuePeek(const TimerQueue *queue) {
+  return (0 < queue->number_of_timers) ? queue->heap[0] : NULL;
+}
+
+QueuedTimer *TimerQueuePopDue(TimerQueue *queue, uint64_t now) {
+  QueuedTimer *timer = TimerQueuePeek(queue);
+  if ((NULL == timer) || (timer->due_time > now)) {
+    return NULL;
+  }
+  TimerQueueCancel(queue, timer);
+  return timer;
+}
+
+int IsTimerQueued(const QueuedTimer *timer) {
+  return 0 != timer->position;
+}
+
+uint64_t GetNextPeriodicDueTime(uint64_t due_time, uint64_t period,
+                                uint64_t now, uint64_t *missed_periods) {
+  uint64_t next_due_time = due_time + period;
+  *missed_periods = 0;
+  if (next_due_time <= now) {
+    *missed_periods = (now - next_due_time) / period + 1;
+    next_due_time += *missed_periods * period;
+  }
+  return next_due_time;
+}
+
+uint32_t GetSpreadFraction(uint32_t index) {
+  uint32_t fraction = 0;
+  for (int i = 0; i < 32; i++) {
+    fraction = (fraction << 1) | (index & 1);
+    index >>= 1;
+  }
+  return fraction;
+}
+
+uint64_t GetFractionOfPeriod(uint32_t fraction, uint64_t period) {
+  return ((uint64_t) fraction * period) >> 32;
+}
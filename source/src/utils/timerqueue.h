@@ -0,0 +1,111 @@
+/*
+ * timerqueue.h
+ */
+
+/**
+ * @file timerqueue.h
+ *
+ * A queue of timers ordered by their due times, implemented as a binary
+ * min-heap. The timers are embedded in the structures they belong to, so
+ * scheduling, moving and cancelling a timer costs O(log n) without any
+ * allocation, and the earliest timer is found in O(1).
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef OPENER_TIMERQUEUE_H_
+#define OPENER_TIMERQUEUE_H_
+
+/** @brief A timer which can be queued in one TimerQueue */
+typedef struct {
+  uint64_t due_time; /**< the time at which the timer expires */
+  size_t position; /**< position in the heap plus one, 0 if not queued */
+  void *data; /**< identifies the owner of the timer */
+} QueuedTimer;
+
+/** @brief Timers ordered by their due times */
+typedef struct {
+  QueuedTimer **heap; /**< the queued timers, the earliest first */
+  size_t number_of_timers;
+  size_t capacity;
+} TimerQueue;
+
+/**
+ * @brief Initializes an empty timer queue
+ * @param queue The queue to be initialized
+ * @param storage Storage for the queued timers
+ * @param capacity Number of entries of the storage
+ */
+void TimerQueueInit(TimerQueue *queue, QueuedTimer **storage, size_t capacity);
+
+/**
+ * @brief Queues the timer with the given due time, or moves it to the given
+ * due time if it is already queued
+ * @param queue The queue to hold the timer
+ * @param timer The timer to be scheduled
+ * @param due_time The time at which the timer expires
+ * @return 0 on success, -1 if the queue is full
+ */
+int TimerQueueSchedule(TimerQueue *queue, QueuedTimer *timer,
+                       uint64_t due_time);
+
+/**
+ * @brief Removes the timer from the queue, has no effect if it is not queued
+ * @param queue The queue holding the timer
+ * @param timer The timer to be removed
+ */
+void TimerQueueCancel(TimerQueue *queue, QueuedTimer *timer);
+
+/**
+ * @brief Returns the timer which expires first
+ * @param queue The queue to look into
+ * @return The earliest timer, NULL if the queue is empty
+ */
+QueuedTimer *TimerQueuePeek(const TimerQueue *queue);
+
+/**
+ * @brief Removes and returns the earliest timer if it is due
+ * @param queue The queue to take the timer from
+ * @param now The current time
+ * @return A timer with a due time not after now, NULL if no timer is due
+ */
+QueuedTimer *TimerQueuePopDue(TimerQueue *queue, uint64_t now);
+
+/**
+ * @brief Checks if the timer is queued
+ * @param timer The timer to be checked
+ * @return 1 if the timer is queued, 0 otherwise
+ */
+int IsTimerQueued(const QueuedTimer *timer);
+
+/**
+ * @brief Determines the next due time of a periodic timer on the grid of its
+ * previous due time, skipping the due times which are not after now
+ * @param due_time The previous due time of the timer
+ * @param period The period of the timer, has to be larger than 0
+ * @param now The current time
+ * @param missed_periods Receives the number of skipped due times
+ * @return The next due time
+ */
+uint64_t GetNextPeriodicDueTime(uint64_t due_time, uint64_t period,
+                                uint64_t now, uint64_t *missed_periods);
+
+/**
+ * @brief Returns the position of the index-th of several periodic timers
+ * within their period, as the bit reversed index (van der Corput sequence).
+ * Every further timer is placed into the middle of the largest gap left by
+ * the previous ones.
+ * @param index The number of previously placed timers
+ * @return The position in units of 2^-32 of the period
+ */
+uint32_t GetSpreadFraction(uint32_t index);
+
+/**
+ * @brief Converts a fraction of a period into a time
+ * @param fraction The fraction in units of 2^-32
+ * @param period The period, at most 2^32 - 1
+ * @return The time, always smaller than the period
+ */
+uint64_t GetFractionOfPeriod(uint32_t fraction, uint64_t period);
+
+#endif /* OPENER_TIMERQUEUE_H_ */
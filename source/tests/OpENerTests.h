@@ -2,4 +2,8 @@
 
 IMPORT_TEST_GROUP(RandomClass);
 IMPORT_TEST_GROUP(XorShiftRandom);
+IMPORT_TEST_GROUP(TimerQueue);
+IMPORT_TEST_GROUP(PeriodicTimer);
+IMPORT_TEST_GROUP(SpscQueue);
+IMPORT_TEST_GROUP(Arena);
 IMPORT_TEST_GROUP(EndianConversion);
@@ -0,0 +1,58 @@
+/*
+ * arenatests.cpp
+ */
+
+#include <CppUTest/TestHarness.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C"  {
+#include <arena.h>
+}
+
+TEST_GROUP(Arena)
+{
+  Arena arena;
+  unsigned char storage[4 * ARENA_ALIGNMENT];
+
+  void setup()
+  {
+    ArenaInit(&arena, storage, sizeof(storage));
+  }
+};
+
+TEST(Arena, BlocksAreAlignedAndZeroed)
+{
+  memset(storage, 0xFF, sizeof(storage));
+  unsigned char *first = (unsigned char *) ArenaAllocate(&arena, 3);
+  unsigned char *second = (unsigned char *) ArenaAllocate(&arena, 5);
+  CHECK(NULL != first);
+  CHECK(NULL != second);
+  LONGS_EQUAL(0, (uintptr_t) second % ARENA_ALIGNMENT);
+  CHECK(second >= first + 3);
+  for (int i = 0; i < 5; i++) {
+    LONGS_EQUAL(0, second[i]);
+  }
+}
+
+TEST(Arena, ExhaustedArenaRefusesBlock)
+{
+  CHECK(NULL != ArenaAllocate(&arena, 2 * ARENA_ALIGNMENT));
+  POINTERS_EQUAL(NULL, ArenaAllocate(&arena, 4 * ARENA_ALIGNMENT));
+}
+
+TEST(Arena, ContainsOnlyItsStorage)
+{
+  void *block = ArenaAllocate(&arena, 1);
+  CHECK(ArenaContains(&arena, block));
+  CHECK(!ArenaContains(&arena, storage + sizeof(storage)));
+  CHECK(!ArenaContains(&arena, &arena));
+}
+
+TEST(Arena, SealedArenaRefusesBlockUntilReset)
+{
+  ArenaSeal(&arena);
+  POINTERS_EQUAL(NULL, ArenaAllocate(&arena, 1));
+  ArenaReset(&arena);
+  CHECK(NULL != ArenaAllocate(&arena, 3 * ARENA_ALIGNMENT));
+}
@@ -0,0 +1,60 @@
+/*
+ * spscqueuetests.cpp
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"  {
+#include <spscqueue.h>
+}
+
+TEST_GROUP(SpscQueue)
+{
+  SpscQueue queue;
+  int storage[4];
+
+  void setup()
+  {
+    SpscQueueInit(&queue, storage, sizeof(storage[0]), 4);
+  }
+};
+
+TEST(SpscQueue, EmptyQueueHasNoElement)
+{
+  int element;
+  LONGS_EQUAL(-1, SpscQueuePop(&queue, &element));
+}
+
+TEST(SpscQueue, ElementsArePoppedInPushOrder)
+{
+  int element;
+  for (int i = 1; i <= 3; i++) {
+    LONGS_EQUAL(0, SpscQueuePush(&queue, &i));
+  }
+  for (int i = 1; i <= 3; i++) {
+    LONGS_EQUAL(0, SpscQueuePop(&queue, &element));
+    LONGS_EQUAL(i, element);
+  }
+  LONGS_EQUAL(-1, SpscQueuePop(&queue, &element));
+}
+
+TEST(SpscQueue, FullQueueRejectsElement)
+{
+  int element = 0;
+  for (int i = 0; i < 4; i++) {
+    LONGS_EQUAL(0, SpscQueuePush(&queue, &element));
+  }
+  LONGS_EQUAL(-1, SpscQueuePush(&queue, &element));
+  SpscQueuePop(&queue, &element);
+  LONGS_EQUAL(0, SpscQueuePush(&queue, &element));
+}
+
+TEST(SpscQueue, QueueWrapsAround)
+{
+  int element;
+  for (int i = 0; i < 10; i++) {
+    LONGS_EQUAL(0, SpscQueuePush(&queue, &i));
+    LONGS_EQUAL(0, SpscQueuePop(&queue, &element));
+    LONGS_EQUAL(i, element);
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ * timerqueuetests.cpp
+ */
+
+#include <CppUTest/TestHarness.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C"  {
+#include <timerqueue.h>
+}
+
+TEST_GROUP(TimerQueue)
+{
+  TimerQueue queue;
+  QueuedTimer *storage[8];
+  QueuedTimer timers[8];
+
+  void setup()
+  {
+    TimerQueueInit(&queue, storage, 8);
+    memset(timers, 0, sizeof(timers));
+  }
+};
+
+TEST(TimerQueue, EmptyQueueHasNoTimer)
+{
+  POINTERS_EQUAL(NULL, TimerQueuePeek(&queue));
+  POINTERS_EQUAL(NULL, TimerQueuePopDue(&queue, UINT64_MAX));
+}
+
+TEST(TimerQueue, TimersArePoppedInDueOrder)
+{
+  const uint64_t due_times[8] = { 50, 10, 70, 30, 20, 80, 60, 40 };
+  for (int i = 0; i < 8; i++) {
+    LONGS_EQUAL(0, TimerQueueSchedule(&queue, &timers[i], due_times[i]));
+  }
+  uint64_t previous_due_time = 0;
+  for (int i = 0; i < 8; i++) {
+    QueuedTimer *timer = TimerQueuePopDue(&queue, 100);
+    CHECK(NULL != timer);
+    CHECK(previous_due_time <= timer->due_time);
+    CHECK(!IsTimerQueued(timer));
+    previous_due_time = timer->due_time;
+  }
+  POINTERS_EQUAL(NULL, TimerQueuePeek(&queue));
+}
+
+TEST(TimerQueue, OnlyDueTimersArePopped)
+{
+  TimerQueueSchedule(&queue, &timers[0], 10);
+  TimerQueueSchedule(&queue, &timers[1], 20);
+  POINTERS_EQUAL(&timers[0], TimerQueuePopDue(&queue, 15));
+  POINTERS_EQUAL(NULL, TimerQueuePopDue(&queue, 15));
+  POINTERS_EQUAL(&timers[1], TimerQueuePeek(&queue));
+}
+
+TEST(TimerQueue, FullQueueRejectsTimer)
+{
+  QueuedTimer additional_timer = { 0 };
+  for (int i = 0; i < 8; i++) {
+    TimerQueueSchedule(&queue, &timers[i], i);
+  }
+  LONGS_EQUAL(-1, TimerQueueSchedule(&queue, &additional_timer, 0));
+  CHECK(!IsTimerQueued(&additional_timer));
+}
+
+TEST(TimerQueue, RescheduledTimerMoves)
+{
+  TimerQueueSchedule(&queue, &timers[0], 10);
+  TimerQueueSchedule(&queue, &timers[1], 20);
+  TimerQueueSchedule(&queue, &timers[2], 30);
+  TimerQueueSchedule(&queue, &timers[0], 40);
+  POINTERS_EQUAL(&timers[1], TimerQueuePeek(&queue));
+  TimerQueueSchedule(&queue, &timers[2], 5);
+  POINTERS_EQUAL(&timers[2], TimerQueuePeek(&queue));
+}
+
+TEST(TimerQueue, CancelledTimerIsNotPopped)
+{
+  TimerQueueSchedule(&queue, &timers[0], 10);
+  TimerQueueSchedule(&queue, &timers[1], 20);
+  TimerQueueSchedule(&queue, &timers[2], 30);
+  TimerQueueCancel(&queue, &timers[0]);
+  TimerQueueCancel(&queue, &timers[0]);
+  CHECK(!IsTimerQueued(&timers[0]));
+  POINTERS_EQUAL(&timers[1], TimerQueuePopDue(&queue, 100));
+  POINTERS_EQUAL(&timers[2], TimerQueuePopDue(&queue, 100));
+  POINTERS_EQUAL(NULL, TimerQueuePopDue(&queue, 100));
+}
+
+TEST_GROUP(PeriodicTimer)
+{
+};
+
+TEST(PeriodicTimer, TimelyTimerMissesNoPeriod)
+{
+  uint64_t missed_periods = 1;
+  CHECK_EQUAL(2000U, GetNextPeriodicDueTime(1000, 1000, 1500,
+                                            &missed_periods));
+  CHECK_EQUAL(0U, missed_periods);
+}
+
+TEST(PeriodicTimer, LatenessDoesNotShiftTheGrid)
+{
+  uint64_t missed_periods = 1;
+  CHECK_EQUAL(2000U, GetNextPeriodicDueTime(1000, 1000, 1999,
+                                            &missed_periods));
+  CHECK_EQUAL(0U, missed_periods);
+}
+
+TEST(PeriodicTimer, DueTimeAtNowIsMissed)
+{
+  uint64_t missed_periods = 0;
+  CHECK_EQUAL(3000U, GetNextPeriodicDueTime(1000, 1000, 2000,
+                                            &missed_periods));
+  CHECK_EQUAL(1U, missed_periods);
+}
+
+TEST(PeriodicTimer, AllPassedDueTimesAreMissed)
+{
+  uint64_t missed_periods = 0;
+  CHECK_EQUAL(8000U, GetNextPeriodicDueTime(1000, 1000, 7500,
+                                            &missed_periods));
+  CHECK_EQUAL(6U, missed_periods);
+  CHECK_EQUAL(1003U, GetNextPeriodicDueTime(3, 500, 999, &missed_periods));
+  CHECK_EQUAL(1U, missed_periods);
+}
+
+TEST(PeriodicTimer, SpreadFillsTheLargestGap)
+{
+  CHECK_EQUAL(0U, GetSpreadFraction(0));
+  CHECK_EQUAL(0x80000000U, GetSpreadFraction(1));
+  CHECK_EQUAL(0x40000000U, GetSpreadFraction(2));
+  CHECK_EQUAL(0xC0000000U, GetSpreadFraction(3));
+  CHECK_EQUAL(0x20000000U, GetSpreadFraction(4));
+  CHECK_EQUAL(0xE0000000U, GetSpreadFraction(7));
+  CHECK_EQUAL(1U, GetSpreadFraction(0x80000000U));
+}
+
+TEST(PeriodicTimer, SpreadTimersDoNotCollide)
+{
+  uint64_t phases[16];
+  for (uint32_t i = 0; i < 16; i++) {
+    phases[i] = GetFractionOfPeriod(GetSpreadFraction(i), 1600);
+    CHECK_EQUAL(0U, phases[i] % 100);
+    for (uint32_t j = 0; j < i; j++) {
+      CHECK(phases[i] != phases[j]);
+    }
+  }
+}
+
+TEST(PeriodicTimer, FractionIsScaledToThePeriod)
+{
+  CHECK_EQUAL(0U, GetFractionOfPeriod(0, 1000));
+  CHECK_EQUAL(500U, GetFractionOfPeriod(0x80000000U, 1000));
+  CHECK_EQUAL(250U, GetFractionOfPeriod(0x40000000U, 1000));
+  CHECK_EQUAL(999U, GetFractionOfPeriod(UINT32_MAX, 1000));
+  CHECK_EQUAL(UINT32_MAX - 1U, GetFractionOfPeriod(UINT32_MAX, UINT32_MAX));
+}